@@ -1,24 +1,55 @@
 #include "Communication.h"
+#include "Crc32.h"
+#include "Log.h"
+#include "CycleTimer.h"
+#include <utility/ATT.h>
+#include <utility/HCI.h>
 
 Communication::Communication() : 
     lockService(BLEConfig::SERVICE_UUID),
     // Characteristic for sending weights FROM Arduino TO Python
-    weightsReadCharacteristic(BLEConfig::WEIGHTS_READ_CHAR_UUID, BLERead | BLENotify, sizeof(float) * BLEConfig::CHUNK_SIZE),
+    weightsReadCharacteristic(BLEConfig::WEIGHTS_READ_CHAR_UUID, BLERead | BLENotify, BLEConfig::WEIGHT_PACKET_MAX_SIZE),
     // Characteristic for receiving weights FROM Python TO Arduino
-    weightsWriteCharacteristic(BLEConfig::WEIGHTS_WRITE_CHAR_UUID, BLEWrite, sizeof(float) * BLEConfig::CHUNK_SIZE),
-    controlCharacteristic(BLEConfig::CONTROL_CHAR_UUID, BLERead | BLEWrite, sizeof(uint8_t)),
+    weightsWriteCharacteristic(BLEConfig::WEIGHTS_WRITE_CHAR_UUID, BLEWrite, BLEConfig::WEIGHT_PACKET_MAX_SIZE),
+    controlCharacteristic(BLEConfig::CONTROL_CHAR_UUID, BLERead | BLEWrite, 2 * sizeof(uint8_t)),
     labelCharacteristic(BLEConfig::LABEL_CHAR_UUID, BLERead | BLEWrite, sizeof(int8_t)),
     predictionCharacteristic(BLEConfig::PREDICTION_CHAR_UUID, BLERead | BLENotify, sizeof(float) * 3),
+    benchmarkCharacteristic(BLEConfig::BENCHMARK_CHAR_UUID, BLERead | BLEWrite | BLENotify, BLEConfig::BENCHMARK_REPORT_SIZE),
+    transferCharacteristic(BLEConfig::TRANSFER_CHAR_UUID, BLERead | BLEWrite | BLENotify, sizeof(TransferStatus)),
+    syncCharacteristic(BLEConfig::SYNC_CHAR_UUID, BLERead | BLEWrite, sizeof(uint32_t)),
+    trainingCharacteristic(BLEConfig::TRAINING_CHAR_UUID, BLERead | BLENotify, sizeof(NeuralNetworkBikeLock::TrainingProgress)),
+    predictionStreamCharacteristic(BLEConfig::PREDICTION_STREAM_CHAR_UUID, BLERead | BLEWrite | BLENotify, BLEConfig::WEIGHT_PACKET_MAX_SIZE),
+    currentSendPos(0),
     currentBufferPos(0),
-    currentSendPos(0)
+    receiveLength(0),
+    receiveCrc(CRC32_INIT),
+    sendCrc(CRC32_INIT),
+    resumeOffset(0),
+    resumeRequested(false),
+    transferStartMs(0),
+    transferBytes(0),
+    wasConnected(false),
+    transferStatus(),
+    sendLength(0),
+    requestedVersion(0),
+    deltaStarted(false),
+    streamRecords(0),
+    streamOldestMs(0),
+    predictionSequence(0),
+    streamFlushCount(BLEConfig::PREDICTION_FLUSH_COUNT),
+    streamFlushAgeMs(BLEConfig::PREDICTION_FLUSH_AGE_MS),
+    benchmarkIterations(BenchmarkConfig::DEFAULT_ITERATIONS),
+    benchmarkWarmup(BenchmarkConfig::DEFAULT_WARMUP),
+    featureEngine(SignalConfig::DEFAULT_FEATURE_ENGINE),
+    cascadePercent(NNConfig::CASCADE_ENABLED ? (uint8_t)(NNConfig::CASCADE_THRESHOLD * 100 + 0.5f) : 0)
 {
 }
 
 bool Communication::begin() {
-    Serial.println("Initializing BLE...");
+    LOG_INFO("Initializing BLE...");
     
     if (!BLE.begin()) {
-        Serial.println("Failed to initialize BLE!");
+        LOG_ERROR("Failed to initialize BLE!");
         return false;
     }
     // Add after BLE.begin()
@@ -31,15 +62,21 @@ bool Communication::begin() {
     lockService.addCharacteristic(controlCharacteristic);
     lockService.addCharacteristic(labelCharacteristic);
     lockService.addCharacteristic(predictionCharacteristic);
+    lockService.addCharacteristic(benchmarkCharacteristic);
+    lockService.addCharacteristic(transferCharacteristic);
+    lockService.addCharacteristic(syncCharacteristic);
+    lockService.addCharacteristic(trainingCharacteristic);
+    lockService.addCharacteristic(predictionStreamCharacteristic);
     BLE.addService(lockService);
 
     BLE.setEventHandler(BLEConnected, Communication::onBLEConnected);
     BLE.setEventHandler(BLEDisconnected, Communication::onBLEDisconnected);
 
+    publishTransferStatus();
+    publishSyncVersion();
     BLE.advertise();
-    Serial.println("BLE service started");
-    Serial.print("Device MAC: ");
-    Serial.println(BLE.address());
+    LOG_INFO("BLE service started");
+    LOG_INFO("Device MAC: %s", BLE.address().c_str());
     return true;
 }
 
@@ -47,127 +84,501 @@ void Communication::update() {
     BLE.poll();
     
     if (controlCharacteristic.written()) {
-        uint8_t command;
-        controlCharacteristic.readValue(command);
-        currentCommand = static_cast<Command>(command);
+        // {command} or {command, argument}
+        uint8_t control[2] = {0, 0};
+        int length = controlCharacteristic.readValue(control, sizeof(control));
+        currentCommand = static_cast<Command>(control[0]);
         
         switch(currentCommand) {
             case Command::GET_WEIGHTS:
-                Serial.println("Received GET_WEIGHTS command");
+                LOG_INFO("Received GET_WEIGHTS command");
+                resetSend();
+                break;
+            case Command::GET_WEIGHT_DELTA:
+                LOG_INFO("Received GET_WEIGHT_DELTA command");
+                resetSend();
+                deltaStarted = false;
                 break;
             case Command::SET_WEIGHTS:
-                Serial.println("Received SET_WEIGHTS command");
-                currentBufferPos = 0;
+                LOG_INFO("Received SET_WEIGHTS command");
+                resetReceive();
                 break;
             case Command::START_TRAINING:
-                Serial.println("Received START_TRAINING command");
+                LOG_INFO("Received START_TRAINING command");
                 break;
             case Command::START_CLASSIFICATION:
-                Serial.println("Received START_CLASSIFICATION command");
+                LOG_INFO("Received START_CLASSIFICATION command");
+                break;
+            case Command::START_CONTINUOUS_CLASSIFICATION:
+                LOG_INFO("Received START_CONTINUOUS_CLASSIFICATION command");
+                break;
+            case Command::START_INFERENCE_BENCHMARK:
+                LOG_INFO("Received START_INFERENCE_BENCHMARK command");
+                break;
+            case Command::START_TRAINING_BENCHMARK:
+                LOG_INFO("Received START_TRAINING_BENCHMARK command");
+                break;
+            case Command::PRUNE_WEIGHTS:
+                LOG_INFO("Received PRUNE_WEIGHTS command");
+                break;
+            case Command::SAVE_WEIGHTS:
+                LOG_INFO("Received SAVE_WEIGHTS command");
+                break;
+            case Command::SET_FEATURE_ENGINE:
+                if (length == 2 && control[1] <= static_cast<uint8_t>(SignalConfig::FeatureEngine::FIXED_Q15)) {
+                    featureEngine = static_cast<SignalConfig::FeatureEngine>(control[1]);
+                    LOG_INFO("Received SET_FEATURE_ENGINE command, engine %u", control[1]);
+                } else {
+                    LOG_WARN("SET_FEATURE_ENGINE without a valid engine, keeping %u", static_cast<unsigned>(featureEngine));
+                }
+                break;
+            case Command::SET_CASCADE:
+                if (length == 2 && control[1] <= 100) {
+                    cascadePercent = control[1];
+                    LOG_INFO("Received SET_CASCADE command, threshold %u%%", control[1]);
+                } else {
+                    LOG_WARN("SET_CASCADE without a valid threshold, keeping %u%%", cascadePercent);
+                }
+                break;
+            case Command::GET_CASCADE_STATS:
+                LOG_INFO("Received GET_CASCADE_STATS command");
                 break;
             default:
-                Serial.println("Unknown command received");
+                LOG_WARN("Unknown command received");
                 break;
         }
     }
+
+    if (benchmarkCharacteristic.written()) {
+        uint16_t settings[2];
+        if (benchmarkCharacteristic.readValue(settings, sizeof(settings)) == sizeof(settings)) {
+            benchmarkIterations = settings[0];
+            benchmarkWarmup = settings[1];
+            LOG_INFO("Benchmark iterations/warm-up: %u/%u", benchmarkIterations, benchmarkWarmup);
+        }
+    }
+
+    if (transferCharacteristic.written()) {
+        uint32_t offset;
+        if (transferCharacteristic.readValue(&offset, sizeof(offset)) == sizeof(offset)) {
+            resumeOffset = offset;
+            resumeRequested = true;
+        }
+    }
+
+    if (syncCharacteristic.written()) {
+        syncCharacteristic.readValue(&requestedVersion, sizeof(requestedVersion));
+    }
+
+    if (predictionStreamCharacteristic.written()) {
+        uint8_t policy[4];
+        if (predictionStreamCharacteristic.readValue(policy, sizeof(policy)) == sizeof(policy)) {
+            streamFlushCount = max(policy[0], (uint8_t)1);
+            memcpy(&streamFlushAgeMs, &policy[2], sizeof(streamFlushAgeMs));
+            LOG_INFO("Prediction flush count/age: %u/%u ms", streamFlushCount, streamFlushAgeMs);
+        }
+    }
+    if (streamRecords > 0 && millis() - streamOldestMs >= streamFlushAgeMs) {
+        flushPredictions();
+    }
+
+    bool connected = isConnected();
+    if (connected != wasConnected) {
+        wasConnected = connected;
+        if (!connected) {
+            // Offsets as of the drop, for the central to read back after reconnecting
+            publishTransferStatus();
+            // Records nobody can receive; the sequence gap tells the central what it missed
+            streamRecords = 0;
+        }
+    }
 }
 
 void Communication::onBLEConnected(BLEDevice central) {
-    Serial.print("Connected to central: ");
-    Serial.println(central.address());
+    LOG_INFO("Connected to central: %s", central.address().c_str());
 }
 
 void Communication::onBLEDisconnected(BLEDevice central) {
-    Serial.print("Disconnected from central: ");
-    Serial.println(central.address());
+    LOG_INFO("Disconnected from central: %s", central.address().c_str());
 }
 
 bool Communication::isConnected() {
     return BLE.connected();
 }
 
-bool Communication::sendWeights(const float* weights, size_t length) {
+bool Communication::sendWeights(NeuralNetworkBikeLock& nn) {
     if (!isConnected()) {
-        Serial.println("Not connected");
-        return false;
+        return false;  // Paused; the central writes its offset to resume after reconnecting
     }
 
-    const size_t chunk_size = BLEConfig::CHUNK_SIZE;
-    const size_t chunk_bytes = chunk_size * sizeof(float);
-    
-    while (currentSendPos < length) {
-        size_t floatsToSend = min(chunk_size, length - currentSendPos);
+    if (sendLength == 0) {
+        sendLength = nn.getTotalWeights();
+    }
+    const size_t length = sendLength;
+    if (resumeRequested) {
+        resumeSend(nn, resumeOffset);
+    }
+    if (currentSendPos == 0 && transferBytes == 0) {
+        transferStartMs = millis();
+    }
+
+    size_t chunkFloats = (packetSize() - BLEConfig::WEIGHT_HEADER_SIZE) / sizeof(float);
+    uint8_t packet[BLEConfig::WEIGHT_PACKET_MAX_SIZE];
+    float chunk[BLEConfig::WEIGHT_CHUNK_MAX];
+
+    for (unsigned int queued = 0; currentSendPos < length && queued < BLEConfig::WEIGHT_WINDOW; queued++) {
+        // No free controller buffer: return instead of blocking, update() polls completions
+        if (HCI.availableAclPackets() == 0) {
+            return false;
+        }
+
+        // Serialise straight from the network, one chunk at a time
+        size_t floatsToSend = nn.readWeights(chunk, currentSendPos, chunkFloats);
         size_t bytesToSend = floatsToSend * sizeof(float);
-        
-        memcpy(tempBuffer, &weights[currentSendPos], bytesToSend);
-        
-        if (weightsReadCharacteristic.writeValue(reinterpret_cast<uint8_t*>(tempBuffer), bytesToSend)) {
-            currentSendPos += floatsToSend;
-            delay(20);
-            
-            if (currentSendPos >= length) {
-                currentSendPos = 0;
-                currentCommand = Command::NONE;
-                Serial.println("Completed sending all weights");
-                return true;
-            }
-        } else {
-            Serial.println("Failed to send weight chunk");
+        if (floatsToSend == 0) {
+            LOG_ERROR("Failed to read weights from network");
+            resetSend();
+            currentCommand = Command::NONE;
+            return false;
+        }
+
+        uint32_t offset = currentSendPos;
+        memcpy(packet, &offset, BLEConfig::WEIGHT_HEADER_SIZE);
+        memcpy(&packet[BLEConfig::WEIGHT_HEADER_SIZE], chunk, bytesToSend);
+        if (!weightsReadCharacteristic.writeValue(packet, BLEConfig::WEIGHT_HEADER_SIZE + bytesToSend)) {
+            LOG_ERROR("Failed to send weight chunk");
+            resetSend();
+            currentCommand = Command::NONE;
             return false;
         }
+        sendCrc = crc32Update(sendCrc, reinterpret_cast<const uint8_t*>(chunk), bytesToSend);
+        currentSendPos += floatsToSend;
+        transferBytes += BLEConfig::WEIGHT_HEADER_SIZE + bytesToSend;
     }
-    return false;
+    if (currentSendPos < length || HCI.availableAclPackets() == 0) {
+        return false;
+    }
+
+    // Trailer lets the receiver check it got every chunk intact
+    uint32_t trailer[3] = {BLEConfig::WEIGHT_TRAILER_OFFSET, crc32Final(sendCrc), static_cast<uint32_t>(length)};
+    bool success = weightsReadCharacteristic.writeValue(trailer, BLEConfig::WEIGHT_TRAILER_SIZE);
+    if (success) {
+        transferBytes += BLEConfig::WEIGHT_TRAILER_SIZE;
+        finishTransfer();
+        // The central now holds exactly these weights
+        weightSync.rebase(nn, nn.getVersion());
+        publishSyncVersion();
+    }
+
+    resetSend();
+    currentCommand = Command::NONE;
+    if (success) {
+        LOG_INFO("Completed sending all weights");
+    } else {
+        LOG_ERROR("Failed to send weight trailer");
+    }
+    return success;
 }
 
-bool Communication::receiveWeights(float* buffer, size_t length) {
-    if (!isConnected() || length > NNConfig::MAX_WEIGHTS) {
-        Serial.println("Not connected or buffer too large");
+bool Communication::sendWeightDelta(NeuralNetworkBikeLock& nn) {
+    if (!isConnected()) {
+        if (deltaStarted) {
+            // Part of the delta is applied on each side, neither knows how much
+            LOG_WARN("Delta sync interrupted, next sync sends all weights");
+            weightSync.invalidate();
+            publishSyncVersion();
+            deltaStarted = false;
+            currentCommand = Command::NONE;
+        }
         return false;
     }
-    
-    if (weightsWriteCharacteristic.written()) {
-        const size_t max_chunk_size = BLEConfig::CHUNK_SIZE * sizeof(float);
-        uint8_t chunk[max_chunk_size];
-        int bytesRead = weightsWriteCharacteristic.readValue(chunk, sizeof(chunk));
-        
-        int numFloats = bytesRead / sizeof(float);
-        
-        if (currentBufferPos + numFloats > length) {
-            Serial.println("Error: Buffer overflow");
-            currentBufferPos = 0;
+
+    uint8_t packet[BLEConfig::WEIGHT_PACKET_MAX_SIZE];
+    if (!deltaStarted) {
+        if (requestedVersion == 0 || requestedVersion != weightSync.getBaseVersion()) {
+            LOG_INFO("Central holds an unknown version, sending all weights");
+            resetSend();
+            currentCommand = Command::GET_WEIGHTS;
             return false;
         }
-        
-        memcpy(&buffer[currentBufferPos], chunk, bytesRead);
-        currentBufferPos += numFloats;
-        
-        if (currentBufferPos % 32 == 0) {
-            Serial.print("Received weights: ");
-            Serial.print(currentBufferPos);
-            Serial.print("/");
-            Serial.println(length);
+        if (HCI.availableAclPackets() == 0) {
+            return false;
         }
-        
-        if (currentBufferPos >= length) {
-            currentBufferPos = 0;
-            Serial.println("Weight transfer complete");
-            return true;
+        resetSend();
+        transferStartMs = millis();
+        weightSync.beginDelta();
+        uint32_t header[3] = {BLEConfig::WEIGHT_DELTA_HEADER_OFFSET, weightSync.getBaseVersion(), nn.getVersion()};
+        if (!weightsReadCharacteristic.writeValue(header, BLEConfig::WEIGHT_DELTA_HEADER_SIZE)) {
+            LOG_ERROR("Failed to send delta header");
+            currentCommand = Command::NONE;
+            return false;
+        }
+        transferBytes += BLEConfig::WEIGHT_DELTA_HEADER_SIZE;
+        deltaStarted = true;
+    }
+
+    size_t capacity = packetSize() - BLEConfig::WEIGHT_HEADER_SIZE;
+    for (unsigned int queued = 0; !weightSync.deltaDone() && queued < BLEConfig::WEIGHT_WINDOW; queued++) {
+        if (HCI.availableAclPackets() == 0) {
+            return false;
+        }
+        size_t used = weightSync.nextRuns(nn, &packet[BLEConfig::WEIGHT_HEADER_SIZE], capacity);
+        if (used == 0) {
+            break;  // Nothing changed past the last run
+        }
+        uint32_t marker = BLEConfig::WEIGHT_DELTA_RUNS_OFFSET;
+        memcpy(packet, &marker, BLEConfig::WEIGHT_HEADER_SIZE);
+        if (!weightsReadCharacteristic.writeValue(packet, BLEConfig::WEIGHT_HEADER_SIZE + used)) {
+            LOG_ERROR("Failed to send delta runs");
+            weightSync.invalidate();
+            publishSyncVersion();
+            deltaStarted = false;
+            currentCommand = Command::NONE;
+            return false;
+        }
+        transferBytes += BLEConfig::WEIGHT_HEADER_SIZE + used;
+    }
+    if (!weightSync.deltaDone() || HCI.availableAclPackets() == 0) {
+        return false;
+    }
+
+    uint32_t trailer[3] = {BLEConfig::WEIGHT_TRAILER_OFFSET, weightSync.baseCrc(), weightSync.getChangedCount()};
+    bool success = weightsReadCharacteristic.writeValue(trailer, BLEConfig::WEIGHT_TRAILER_SIZE);
+    if (success) {
+        weightSync.finishDelta(nn.getVersion());
+        transferBytes += BLEConfig::WEIGHT_TRAILER_SIZE;
+        finishTransfer();
+    } else {
+        weightSync.invalidate();
+    }
+    publishSyncVersion();
+
+    if (success) {
+        LOG_INFO("Delta sync complete, changed weights: %u", weightSync.getChangedCount());
+    } else {
+        LOG_ERROR("Failed to send delta trailer");
+    }
+    deltaStarted = false;
+    resetSend();
+    currentCommand = Command::NONE;
+    return success;
+}
+
+size_t Communication::packetSize() {
+    // Fill whatever the negotiated MTU allows in one notification
+    size_t mtu = max((size_t)ATT.mtu(), (size_t)BLEConfig::ATT_MIN_MTU);
+    return min(mtu - 3, (size_t)BLEConfig::WEIGHT_PACKET_MAX_SIZE);
+}
+
+void Communication::publishSyncVersion() {
+    uint32_t version = weightSync.getBaseVersion();
+    syncCharacteristic.writeValue(&version, sizeof(version));
+}
+
+void Communication::resetSend() {
+    currentSendPos = 0;
+    sendLength = 0;
+    sendCrc = CRC32_INIT;
+    resumeRequested = false;
+    transferBytes = 0;
+}
+
+void Communication::resumeSend(NeuralNetworkBikeLock& nn, uint32_t offset) {
+    // The CRC covers everything before the offset, so rebuild it from the network
+    float chunk[BLEConfig::WEIGHT_CHUNK_MAX];
+    currentSendPos = 0;
+    sendCrc = CRC32_INIT;
+    while (currentSendPos < offset) {
+        size_t n = nn.readWeights(chunk, currentSendPos, min((size_t)BLEConfig::WEIGHT_CHUNK_MAX, offset - currentSendPos));
+        if (n == 0) {
+            break;
         }
+        sendCrc = crc32Update(sendCrc, reinterpret_cast<const uint8_t*>(chunk), n * sizeof(float));
+        currentSendPos += n;
+    }
+    resumeRequested = false;
+
+    LOG_INFO("Resuming weights at %u", currentSendPos);
+    publishTransferStatus();
+}
+
+void Communication::finishTransfer() {
+    unsigned long elapsed = millis() - transferStartMs;
+    transferStatus.bytes = transferBytes;
+    transferStatus.elapsedMs = elapsed;
+    transferStatus.bytesPerSecond = elapsed > 0 ? (uint32_t)((uint64_t)transferBytes * 1000 / elapsed) : 0;
+    publishTransferStatus();
+
+    LOG_INFO("Weight transfer: %u bytes in %u ms, %u B/s", transferBytes, elapsed, transferStatus.bytesPerSecond);
+}
+
+void Communication::publishTransferStatus() {
+    transferStatus.sendOffset = currentSendPos;
+    transferStatus.receiveOffset = currentBufferPos;
+    transferCharacteristic.writeValue(&transferStatus, sizeof(transferStatus));
+}
+
+void Communication::resetReceive() {
+    currentBufferPos = 0;
+    receiveLength = 0;
+    receiveCrc = CRC32_INIT;
+}
+
+// A rejected transfer starts over from offset 0, the standby copy is not kept for it
+void Communication::abortReceive(NeuralNetworkBikeLock& nn) {
+    nn.cancelWeightUpdate();
+    resetReceive();
+}
+
+bool Communication::receiveWeights(NeuralNetworkBikeLock& nn) {
+    // Disconnected: keep the offset, the central continues from transferStatus.receiveOffset
+    if (!isConnected() || !weightsWriteCharacteristic.written()) {
+        return false;
+    }
+
+    uint8_t packet[BLEConfig::WEIGHT_PACKET_MAX_SIZE];
+    int bytesRead = weightsWriteCharacteristic.readValue(packet, sizeof(packet));
+    if (bytesRead < (int)BLEConfig::WEIGHT_HEADER_SIZE) {
+        LOG_ERROR("Weight packet too short");
+        abortReceive(nn);
+        return false;
+    }
+    uint32_t offset;
+    memcpy(&offset, packet, BLEConfig::WEIGHT_HEADER_SIZE);
+    size_t payloadBytes = bytesRead - BLEConfig::WEIGHT_HEADER_SIZE;
+
+    if (offset == BLEConfig::WEIGHT_TRAILER_OFFSET) {
+        uint32_t trailer[2] = {0, 0};
+        if (payloadBytes == sizeof(trailer)) {
+            memcpy(trailer, &packet[BLEConfig::WEIGHT_HEADER_SIZE], sizeof(trailer));
+        }
+        bool complete = receiveLength > 0 && currentBufferPos == receiveLength && trailer[1] == receiveLength;
+        bool intact = trailer[0] == crc32Final(receiveCrc);
+        if (!complete || !intact) {
+            // Chunks went to the standby copy and are dropped; without one they are
+            // already live and the model is inconsistent until resent
+            if (complete) {
+                LOG_ERROR("Weight CRC mismatch");
+            } else {
+                LOG_ERROR("Weight count mismatch");
+            }
+            abortReceive(nn);
+            return false;
+        }
+        transferBytes += bytesRead;
+        nn.commitWeightUpdate();
+        finishTransfer();
+        resetReceive();
+        weightSync.rebase(nn, nn.getVersion());
+        publishSyncVersion();
+        LOG_INFO("Weight transfer complete");
+        return true;
+    }
+
+    if (offset < currentBufferPos) {
+        return false;  // Resent after a reconnect, already stored
+    }
+    if (offset != currentBufferPos || payloadBytes == 0 || payloadBytes % sizeof(float) != 0) {
+        LOG_ERROR("Unexpected weight chunk at %u, expected %u", offset, currentBufferPos);
+        abortReceive(nn);
+        return false;
+    }
+    if (offset == 0 && !nn.isTrainable()) {
+        LOG_ERROR("Weights are read in place, transfer rejected");
+        abortReceive(nn);
+        return false;
+    }
+    if (offset == 0) {
+        receiveLength = nn.getTotalWeights();
+        transferStartMs = millis();
+        transferBytes = 0;
+        if (!nn.beginWeightUpdate()) {
+            LOG_WARN("No standby weight copy, receiving into the live weights");
+        }
+    }
+
+    size_t numFloats = payloadBytes / sizeof(float);
+    if (currentBufferPos + numFloats > receiveLength) {
+        LOG_ERROR("Weight buffer overflow");
+        abortReceive(nn);
+        return false;
+    }
+
+    // Into the network's standby copy at the running offset
+    float chunk[BLEConfig::WEIGHT_CHUNK_MAX];
+    memcpy(chunk, &packet[BLEConfig::WEIGHT_HEADER_SIZE], payloadBytes);
+    nn.writeWeightUpdate(chunk, currentBufferPos, numFloats);
+    receiveCrc = crc32Update(receiveCrc, reinterpret_cast<const uint8_t*>(chunk), payloadBytes);
+    currentBufferPos += numFloats;
+    transferBytes += bytesRead;
+
+    if (currentBufferPos % 1024 < numFloats) {
+        LOG_DEBUG("Received weights: %u/%u", currentBufferPos, receiveLength);
     }
     return false;
 }
 
-bool Communication::sendPrediction(const float* probabilities, size_t length) {
-    if (!isConnected() || length != 3) {
-        Serial.println("Not connected or invalid prediction length");
+bool Communication::sendPrediction(const float* probabilities, size_t length, uint32_t timestampMs) {
+    if (!isConnected() || length != NNConfig::NUM_OUTPUTS) {
+        LOG_WARN("Not connected or invalid prediction length");
         return false;
     }
-    
+
+    if (predictionStreamCharacteristic.subscribed()) {
+        queuePrediction(probabilities, timestampMs);
+        size_t capacity = (packetSize() - BLEConfig::PREDICTION_STREAM_HEADER_SIZE) / BLEConfig::PREDICTION_RECORD_SIZE;
+        if (streamRecords >= min((size_t)streamFlushCount, capacity)) {
+            return flushPredictions();
+        }
+        return true;
+    }
+    predictionSequence++;
+
     bool success = predictionCharacteristic.writeValue(probabilities, length * sizeof(float));
     if (success) {
-        Serial.println("Sent prediction probabilities");
+        LOG_DEBUG("Sent prediction probabilities");
+    } else {
+        LOG_ERROR("Failed to send prediction probabilities");
+    }
+    return success;
+}
+
+void Communication::queuePrediction(const float* probabilities, uint32_t timestampMs) {
+    if (streamRecords == 0) {
+        streamOldestMs = millis();
+    }
+    uint8_t* record = &streamPacket[BLEConfig::PREDICTION_STREAM_HEADER_SIZE + streamRecords * BLEConfig::PREDICTION_RECORD_SIZE];
+    uint8_t classId = 0;
+    for (uint8_t i = 1; i < NNConfig::NUM_OUTPUTS; i++) {
+        if (probabilities[i] > probabilities[classId]) {
+            classId = i;
+        }
+    }
+
+    memcpy(record, &predictionSequence, sizeof(predictionSequence));
+    memcpy(&record[2], &timestampMs, sizeof(timestampMs));
+    record[6] = classId;
+    for (unsigned int i = 0; i < NNConfig::NUM_OUTPUTS; i++) {
+        float p = constrain(probabilities[i], 0.0f, 1.0f);
+        record[7 + i] = (uint8_t)(p * 255.0f + 0.5f);
+    }
+    predictionSequence++;
+    streamRecords++;
+}
+
+bool Communication::flushPredictions() {
+    if (streamRecords == 0) {
+        return true;
+    }
+    streamPacket[0] = streamRecords;
+    size_t length = BLEConfig::PREDICTION_STREAM_HEADER_SIZE + streamRecords * BLEConfig::PREDICTION_RECORD_SIZE;
+    streamRecords = 0;
+
+    bool success = predictionStreamCharacteristic.writeValue(streamPacket, length);
+    if (success) {
+        LOG_DEBUG("Sent %u prediction records", streamPacket[0]);
     } else {
-        Serial.println("Failed to send prediction probabilities");
+        LOG_ERROR("Failed to send prediction records");
     }
     return success;
 }
@@ -175,14 +586,54 @@ bool Communication::sendPrediction(const float* probabilities, size_t length) {
 int8_t Communication::getTrainingLabel() {
     int8_t label = -1;
     labelCharacteristic.readValue(label);
-    Serial.print("Received training label: ");
-    Serial.println(label);
+    LOG_INFO("Received training label: %d", label);
     return label;
 }
 
 void Communication::resetState() {
-    currentBufferPos = 0;
-    currentSendPos = 0;
+    resetReceive();
+    resetSend();
+    if (deltaStarted) {
+        weightSync.invalidate();
+        publishSyncVersion();
+        deltaStarted = false;
+    }
     currentCommand = Command::NONE;
-    Serial.println("Communication state reset");
-}
\ No newline at end of file
+    LOG_DEBUG("Communication state reset");
+}
+
+bool Communication::sendCascadeReport(const NeuralNetworkBikeLock& nn) {
+    const NeuralNetworkBikeLock::CascadeStats& stats = nn.getCascadeStats();
+    CascadeReport report;
+    report.version = CASCADE_REPORT_VERSION;
+    report.kind = BLEConfig::CASCADE_REPORT_KIND;
+    report.flags = (nn.isCascadeEnabled() ? 1 : 0) | (nn.isFirstStageTrained() ? 2 : 0);
+    report.thresholdPercent = (uint8_t)(nn.getCascadeThreshold() * 100 + 0.5f);
+    report.tickHz = CycleTimer::ticksPerSecond();
+    report.firstStageHits = stats.firstStageHits;
+    report.escalations = stats.escalations;
+    report.firstStageTicks = stats.firstStageTicks;
+    report.secondStageTicks = stats.secondStageTicks;
+    return sendBenchmarkReport(reinterpret_cast<const uint8_t*>(&report), sizeof(report));
+}
+
+bool Communication::sendBenchmarkReport(const uint8_t* report, size_t length) {
+    if (!isConnected()) {
+        LOG_WARN("Not connected");
+        return false;
+    }
+
+    // Notifications carry at most MTU - 3 bytes; the central reads the full record after the notify
+    bool success = benchmarkCharacteristic.writeValue(report, length);
+    if (success) {
+        LOG_INFO("Sent benchmark report");
+    } else {
+        LOG_ERROR("Failed to send benchmark report");
+    }
+    return success;
+}
+
+bool Communication::sendTrainingProgress(const NeuralNetworkBikeLock::TrainingProgress& progress) {
+    // Written while disconnected too, so a central that connects later reads the latest epoch
+    return trainingCharacteristic.writeValue(&progress, sizeof(progress));
+}
@@ -3,30 +3,92 @@
 
 #include <ArduinoBLE.h>
 #include "Config.h"
+#include "NeuralNetworkBikeLock.h"
+#include "WeightSync.h"
 
 enum class Command {
     NONE = 0,
     GET_WEIGHTS = 1,
-    SET_WEIGHTS = 2,
+    SET_WEIGHTS = 2,                     // Leaves continuous classification running (NNConfig::STANDBY_WEIGHTS)
     START_TRAINING = 3,
     START_CLASSIFICATION = 4,
     START_INFERENCE_BENCHMARK = 5,
-    START_TRAINING_BENCHMARK = 6
+    START_TRAINING_BENCHMARK = 6,
+    START_CONTINUOUS_CLASSIFICATION = 7, // Runs until another command (or NONE) is written
+    GET_WEIGHT_DELTA = 8,                // Changes since the version written to the sync characteristic
+    PRUNE_WEIGHTS = 9,                   // Magnitude-prune to NNConfig::PRUNE_SPARSITY
+    SAVE_WEIGHTS = 10,                   // Persist the weights to flash, loaded at boot
+    SET_FEATURE_ENGINE = 11,             // Second control byte is a SignalConfig::FeatureEngine
+    SET_CASCADE = 12,                    // Second control byte is the threshold in percent, 0 turns the cascade off
+    GET_CASCADE_STATS = 13               // CascadeReport on the benchmark characteristic
 };
 
 class Communication {
 public:
+    // Served on the transfer characteristic; notified when a weight transfer completes
+    // and refreshed on disconnect so a reconnecting central can read where to resume
+    struct TransferStatus {
+        uint32_t sendOffset;       // Weights GET_WEIGHTS has queued
+        uint32_t receiveOffset;    // Weights SET_WEIGHTS has stored, continue writing from here
+        uint32_t bytes;            // Packet bytes of the last completed transfer
+        uint32_t elapsedMs;        // First packet to trailer
+        uint32_t bytesPerSecond;
+    };
+    static_assert(sizeof(TransferStatus) <= BLEConfig::ATT_MIN_MTU - 3, "TransferStatus must fit the default MTU");
+
+    // Cascade state and NeuralNetworkBikeLock::CascadeStats, sent as-is (little-endian,
+    // no padding). Ticks are CycleTimer ticks; divide by tickHz for seconds.
+    struct CascadeReport {
+        uint8_t version;
+        uint8_t kind;               // BLEConfig::CASCADE_REPORT_KIND
+        uint8_t flags;              // Bit 0: cascade on, bit 1: first stage trained (else every window escalates)
+        uint8_t thresholdPercent;
+        uint32_t tickHz;
+        uint32_t firstStageHits;
+        uint32_t escalations;
+        uint64_t firstStageTicks;
+        uint64_t secondStageTicks;
+    };
+    static constexpr uint8_t CASCADE_REPORT_VERSION = 1;
+    static_assert(sizeof(CascadeReport) == 32, "Cascade report must stay unpadded, the BLE client parses it byte by byte");
+    static_assert(sizeof(CascadeReport) <= BLEConfig::BENCHMARK_REPORT_SIZE, "Cascade report does not fit the BLE characteristic");
+
     Communication();
     bool begin();
     void update();
     bool isConnected();
     Command getCurrentCommand() { return currentCommand; } 
-    bool sendWeights(const float* weights, size_t length);
-    bool receiveWeights(float* buffer, size_t length);
+    // Weights are streamed in MTU-sized packets straight from / into the network, see
+    // BLEConfig for the packet layout. Both calls are non-blocking and pause while
+    // disconnected: sendWeights() queues at most one window of packets, limited by the
+    // free controller buffers, and returns true once the trailer went out;
+    // receiveWeights() fills the network's standby copy and returns true once the
+    // trailer arrived, count and CRC matched and the network switched to the new weights.
+    bool sendWeights(NeuralNetworkBikeLock& nn);
+    bool receiveWeights(NeuralNetworkBikeLock& nn);
+    // Same pacing as sendWeights(); falls back to GET_WEIGHTS when the central's
+    // version is not the current base. Full transfers in either direction rebase.
+    bool sendWeightDelta(NeuralNetworkBikeLock& nn);
+    const TransferStatus& getTransferStatus() const { return transferStatus; }
     void resetState();
-    bool sendPrediction(const float* probabilities, size_t length);
+    // Probabilities of the window that ended at timestampMs. While a central is subscribed
+    // to the prediction stream they are queued as a record and sent in batches (see
+    // BLEConfig); otherwise the three floats are notified right away.
+    bool sendPrediction(const float* probabilities, size_t length, uint32_t timestampMs);
+    bool flushPredictions();
+    uint16_t getPredictionSequence() const { return predictionSequence; }
+    bool sendBenchmarkReport(const uint8_t* report, size_t length);
+    bool sendCascadeReport(const NeuralNetworkBikeLock& nn);
+    // Stored for reads and notified to a subscribed central
+    bool sendTrainingProgress(const NeuralNetworkBikeLock::TrainingProgress& progress);
+    // Iteration and warm-up counts last written by the central (defaults otherwise)
+    uint16_t getBenchmarkIterations() const { return benchmarkIterations; }
+    uint16_t getBenchmarkWarmup() const { return benchmarkWarmup; }
+    // Engine last selected with SET_FEATURE_ENGINE (SignalConfig::DEFAULT_FEATURE_ENGINE otherwise)
+    SignalConfig::FeatureEngine getFeatureEngine() const { return featureEngine; }
+    // Threshold in percent last written with SET_CASCADE, 0 for off
+    uint8_t getCascadePercent() const { return cascadePercent; }
     int8_t getTrainingLabel();
-    float* getTempBuffer() { return tempBuffer; }
 
 private:
     BLEService lockService;
@@ -35,12 +97,49 @@ private:
     BLECharacteristic controlCharacteristic;
     BLECharacteristic labelCharacteristic;
     BLECharacteristic predictionCharacteristic;
+    BLECharacteristic benchmarkCharacteristic;
+    BLECharacteristic transferCharacteristic;
+    BLECharacteristic syncCharacteristic;
+    BLECharacteristic trainingCharacteristic;
+    BLECharacteristic predictionStreamCharacteristic;
     
     // Variables for chunked transfer
     size_t currentSendPos = 0;
     Command currentCommand = Command::NONE;
-    float tempBuffer[NNConfig::MAX_WEIGHTS];
     size_t currentBufferPos;
+    size_t receiveLength;               // Weights expected by the running SET_WEIGHTS transfer
+    uint32_t receiveCrc;
+    uint32_t sendCrc;
+    uint32_t resumeOffset;              // Written by the central, applied by the next sendWeights()
+    bool resumeRequested;
+    unsigned long transferStartMs;
+    uint32_t transferBytes;
+    bool wasConnected;
+    TransferStatus transferStatus;
+    size_t sendLength;
+    uint32_t requestedVersion;          // Base version the central says it holds
+    bool deltaStarted;
+    WeightSync weightSync;
+    uint8_t streamPacket[BLEConfig::WEIGHT_PACKET_MAX_SIZE];
+    size_t streamRecords;
+    unsigned long streamOldestMs;       // millis() when the first queued record arrived
+    uint16_t predictionSequence;        // Next sequence number, counts every prediction
+    uint8_t streamFlushCount;
+    uint16_t streamFlushAgeMs;
+    uint16_t benchmarkIterations;
+    uint16_t benchmarkWarmup;
+    SignalConfig::FeatureEngine featureEngine;
+    uint8_t cascadePercent;
+
+    void resetReceive();
+    void abortReceive(NeuralNetworkBikeLock& nn);
+    void resetSend();
+    void resumeSend(NeuralNetworkBikeLock& nn, uint32_t offset);
+    void finishTransfer();
+    void publishTransferStatus();
+    void publishSyncVersion();
+    size_t packetSize();
+    void queuePrediction(const float* probabilities, uint32_t timestampMs);
 
     static void onBLEConnected(BLEDevice central);
     static void onBLEDisconnected(BLEDevice central);
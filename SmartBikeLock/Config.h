@@ -2,6 +2,9 @@
 #ifndef CONFIG_H
 #define CONFIG_H
 
+#include <stddef.h>
+#include <stdint.h>
+
 // Neural Network Configuration
 namespace NNConfig {
     constexpr unsigned int NUM_LAYERS = 3;
@@ -19,6 +22,54 @@ namespace NNConfig {
     }
     
     constexpr size_t MAX_WEIGHTS = calculateTotalWeights();
+    constexpr unsigned int NUM_INPUTS = LAYERS[0];
+    constexpr unsigned int NUM_OUTPUTS = LAYERS[NUM_LAYERS - 1];
+
+    // Network implementation behind NeuralNetworkBikeLock
+    enum class Backend {
+        DYNAMIC = 0,      // NeuralNetwork library, layers sized and allocated by init()
+        STATIC = 1        // StaticNetwork sized from LAYERS at compile time, no heap
+    };
+    constexpr Backend DEFAULT_BACKEND = Backend::STATIC;
+    // STATIC backend weights: true keeps them trainable in a static RAM array (with
+    // the gradient sums about 112 KB of .bss), false only reads them in place from
+    // ModelStore's flash and refuses training and weight writes
+    constexpr bool STATIC_WEIGHTS_IN_RAM = true;
+
+    // Magnitude pruning: PRUNE_WEIGHTS zeroes the smallest weights of every layer
+    // and inference runs a CSR kernel over the rest (6 bytes per kept weight of
+    // SPARSE_CAPACITY, allocated by the first prune)
+    constexpr float PRUNE_SPARSITY = 0.9f;
+    constexpr size_t SPARSE_CAPACITY = MAX_WEIGHTS / 5;    // Sparsity of at least 80%
+
+    // SET_WEIGHTS streams into a standby copy of the weights (another MAX_WEIGHTS
+    // floats, 56 KB of heap for the length of the transfer) and switches to it once
+    // count and CRC check out, so inference never runs on a partial model. false, or
+    // no heap for the copy, writes the live weights in place.
+    constexpr bool STANDBY_WEIGHTS = true;
+
+    // Cascade: a small first stage classifies every window and LAYERS only runs
+    // when the first stage's top output is below CASCADE_THRESHOLD. The first stage
+    // always trains on the same samples as LAYERS; it is not part of weight transfers
+    // or the stored model. SET_CASCADE switches it at run time.
+    constexpr unsigned int CASCADE_HIDDEN = 16;            // 11 x 16 x 3, 224 weights
+    constexpr bool CASCADE_ENABLED = false;
+    constexpr float CASCADE_THRESHOLD = 0.9f;
+
+    // Replay buffer: labelled feature vectors kept for background training
+    enum class ReplayEviction {
+        FIFO = 0,        // A new sample replaces the oldest one
+        RESERVOIR = 1    // Every sample seen so far stays with equal probability
+    };
+    constexpr unsigned int REPLAY_CAPACITY = 64;           // 48 bytes per entry
+    constexpr ReplayEviction REPLAY_EVICTION = ReplayEviction::FIFO;
+
+    // Background trainer: shuffled mini-batch epochs over the replay buffer, run
+    // from loop() in slices so BLE and the sample clock keep being serviced
+    constexpr unsigned int BATCH_SIZE = 8;                 // Samples whose gradients are summed into one step
+    constexpr unsigned int TRAIN_EPOCHS = 20;              // Epochs after each new sample
+    constexpr unsigned long TRAIN_SLICE_US = 4000;         // Below one sampling period
+    static_assert(REPLAY_CAPACITY > 0 && REPLAY_CAPACITY <= 0xFFFF, "Replay indices are 16-bit");
 
     // Classification labels
     enum class TheftClass {
@@ -33,11 +84,93 @@ namespace SignalConfig {
     constexpr unsigned int SAMPLES = 256;
     constexpr unsigned int SAMPLING_FREQ = 100;
     constexpr unsigned int SAMPLING_PERIOD_MS = 1000/SAMPLING_FREQ;
+    constexpr unsigned int HOP_SIZE = 128;  // Continuous mode: new window every HOP_SIZE samples (SAMPLES - HOP_SIZE overlap)
     constexpr unsigned int FEATURE_BINS = 8;
     constexpr unsigned int TOTAL_FEATURES = 11;  // 8 frequency bins + 3 statistical features
+    constexpr float ACCEL_MS2_PER_COUNT = 9.81f * 4.0f / 32768.0f;  // Raw LSM9DS1 counts at the 4 g range
     
-    // Frequency bands (Hz)
-    constexpr float FREQ_BANDS[] = {0, 6, 12, 19, 25, 31, 37, 44, 50};
+    // Frequency band edges (Hz), FEATURE_BINS + 1 of them. A type rather than an
+    // array, so FeaturePlan<..., FreqBands> is the same type in every translation unit.
+    struct FreqBands {
+        static constexpr float edge(unsigned int index) {
+            constexpr float edges[] = {0, 6, 12, 19, 25, 31, 37, 44, 50};
+            static_assert(sizeof(edges) / sizeof(edges[0]) == FEATURE_BINS + 1, "One edge more than FEATURE_BINS");
+            return edges[index];
+        }
+    };
+
+    // Feature engine used by processData(), the central can switch it with SET_FEATURE_ENGINE
+    enum class FeatureEngine {
+        FFT = 0,          // Full-window FFT every window
+        SLIDING_DFT = 1,  // Per-sample sliding DFT on the continuous sample path
+        FIXED_Q15 = 2     // Full-window FFT in Q15 on raw counts, float only for the features
+    };
+    constexpr FeatureEngine DEFAULT_FEATURE_ENGINE = FeatureEngine::FFT;
+    constexpr float SDFT_DAMPING = 0.99999f;         // < 1 keeps the float recursion stable
+    constexpr unsigned int SDFT_DECISION_HOP = 10;   // Samples between classifications (100 ms)
+
+    // Motion gate: windows whose AC RMS stays below MOTION_GATE_RATIO x noise floor
+    // skip FFT and inference and are reported as NO_THEFT
+    constexpr bool MOTION_GATE_ENABLED = true;
+    constexpr float MOTION_GATE_RATIO = 3.0f;
+    constexpr float MOTION_FLOOR_INITIAL = 0.1f;    // m/s^2, typical parked IMU noise
+    constexpr float MOTION_FLOOR_MIN = 0.02f;
+    constexpr float MOTION_FLOOR_MAX = 0.3f;        // Keeps the gate from learning real motion as noise
+    constexpr float MOTION_FLOOR_ALPHA = 0.1f;      // Floor tracking rate, quiet windows only
+
+    static_assert((SAMPLES & (SAMPLES - 1)) == 0 && SAMPLES >= 4, "SAMPLES must be a power of two");
+    static_assert(HOP_SIZE > 0 && HOP_SIZE <= SAMPLES, "HOP_SIZE must be in (0, SAMPLES]");
+    static_assert(SDFT_DECISION_HOP > 0 && SDFT_DECISION_HOP <= SAMPLES, "SDFT_DECISION_HOP must be in (0, SAMPLES]");
+}
+
+// Benchmark Configuration
+namespace BenchmarkConfig {
+    constexpr unsigned int DEFAULT_ITERATIONS = 20;
+    constexpr unsigned int DEFAULT_WARMUP = 2;        // Untimed passes before recording
+    constexpr unsigned int MAX_ITERATIONS = 1000;
+    constexpr unsigned long SLICE_US = 5000;          // Passes per scheduler run, BLE is serviced in between
+    constexpr unsigned long CPU_HZ = 64000000UL;      // nRF52840 core clock, converts DWT cycles
+}
+
+// Logging Configuration (levels are set with LOG_LEVEL in Log.h)
+namespace LogConfig {
+    constexpr unsigned int RING_SIZE = 32;        // Records, power of two
+    constexpr unsigned int MAX_ARGS = 5;
+    constexpr unsigned int TEXT_SIZE = MAX_ARGS * sizeof(uint32_t);
+    constexpr unsigned int DRAIN_PER_IDLE = 4;    // Records printed per idle loop pass
+    static_assert((RING_SIZE & (RING_SIZE - 1)) == 0 && RING_SIZE <= 0x8000, "RING_SIZE must be a power of two");
+}
+
+// Model Store Configuration: trained weights in a raw internal flash region
+namespace StoreConfig {
+    constexpr uint32_t MAGIC = 0x4C4E4E42;        // "BNNL"
+    constexpr uint16_t FORMAT = 1;
+    constexpr size_t PAGE_SIZE = 4096;            // nRF52840 erase unit
+    constexpr size_t TOP_GAP = 4 * PAGE_SIZE;     // Top of flash stays with NanoBLEFlashPrefs (FDS pages)
+    constexpr size_t HEADER_SIZE = 32;            // Weights start 16-byte aligned after the header
+    constexpr size_t REGION_SIZE = (HEADER_SIZE + NNConfig::MAX_WEIGHTS * sizeof(float) + PAGE_SIZE - 1) / PAGE_SIZE * PAGE_SIZE;
+}
+
+// Scheduler Configuration (microseconds; deadlines are relative to the release)
+namespace SchedulerConfig {
+    constexpr unsigned int MAX_TASKS = 9;
+
+    constexpr unsigned long BLE_PERIOD_US = 5000;           // BLE.poll() and command dispatch
+    constexpr unsigned long BLE_BUDGET_US = 1000;
+    constexpr unsigned long ACQUIRE_PERIOD_US = SignalConfig::SAMPLING_PERIOD_MS * 1000UL;
+    constexpr unsigned long ACQUIRE_BUDGET_US = 500;
+    constexpr unsigned long DSP_BUDGET_US = 10000;          // Motion gate plus FFT features
+    constexpr unsigned long DSP_DEADLINE_US = SignalConfig::SDFT_DECISION_HOP * ACQUIRE_PERIOD_US;
+    constexpr unsigned long INFERENCE_BUDGET_US = 5000;
+    constexpr unsigned long INFERENCE_DEADLINE_US = DSP_DEADLINE_US;
+    constexpr unsigned long TRANSFER_PERIOD_US = 5000;      // One window of weight packets
+    constexpr unsigned long TRANSFER_BUDGET_US = 3000;
+    constexpr unsigned long TRAIN_PERIOD_US = 20000;
+    constexpr unsigned long TRAIN_BUDGET_US = NNConfig::TRAIN_SLICE_US + 2000;  // A slice may finish one sample late
+    constexpr unsigned long BENCHMARK_BUDGET_US = BenchmarkConfig::SLICE_US + 5000;  // A slice may finish one pass late
+    constexpr unsigned long BENCHMARK_DEADLINE_US = 100000UL;                   // Per slice, yields to everything else
+    constexpr unsigned long MAINTENANCE_DEADLINE_US = 60000000UL;               // Blocking by design, no budget
+    constexpr unsigned long STATS_PERIOD_US = 10000000UL;   // Overrun report in the log
 }
 
 // BLE Communication Configuration
@@ -51,7 +184,64 @@ namespace BLEConfig {
     constexpr char CONTROL_CHAR_UUID[] = "19B10002-E8F2-537E-4F6C-D104768A1214";
     constexpr char LABEL_CHAR_UUID[] = "19B10003-E8F2-537E-4F6C-D104768A1214";
     constexpr char PREDICTION_CHAR_UUID[] = "19B10004-E8F2-537E-4F6C-D104768A1214";
-    constexpr unsigned int CHUNK_SIZE = 30;
+    // Benchmark report FROM Arduino; the central may write {uint16 iterations, uint16 warmup} first
+    constexpr char BENCHMARK_CHAR_UUID[] = "19B10006-E8F2-537E-4F6C-D104768A1214";
+    constexpr unsigned int BENCHMARK_REPORT_SIZE = 128;  // Upper bound for TimingBenchmark::Record
+    // GET_CASCADE_STATS answers with a Communication::CascadeReport on the same characteristic,
+    // told apart by its kind byte (TimingBenchmark::Kind uses 0 and 1)
+    constexpr uint8_t CASCADE_REPORT_KIND = 2;
+    // Transfer status FROM Arduino (offsets and throughput, see Communication::TransferStatus);
+    // the central writes a uint32 weight offset here to resume GET_WEIGHTS after a reconnect
+    constexpr char TRANSFER_CHAR_UUID[] = "19B10007-E8F2-537E-4F6C-D104768A1214";
+
+    // Weight transfer packets: [uint32 weight offset][floats], then a trailer
+    // [0xFFFFFFFF][uint32 CRC-32 of all weight bytes][uint32 weight count]. Little-endian.
+    // Packets fill the negotiated ATT MTU (MTU - 3 bytes of notification payload).
+    constexpr unsigned int WEIGHT_HEADER_SIZE = sizeof(uint32_t);
+    constexpr unsigned int WEIGHT_PACKET_MAX_SIZE = 244;   // ATT MTU 247 fills one 251-byte LL packet
+    constexpr unsigned int WEIGHT_CHUNK_MAX = (WEIGHT_PACKET_MAX_SIZE - WEIGHT_HEADER_SIZE) / sizeof(float);
+    constexpr unsigned int WEIGHT_TRAILER_SIZE = WEIGHT_HEADER_SIZE + 2 * sizeof(uint32_t);
+    constexpr uint32_t WEIGHT_TRAILER_OFFSET = 0xFFFFFFFF;
+    constexpr unsigned int ATT_MIN_MTU = 23;
+    // Packets queued per sendWeights() call, bounded by free controller buffers as well
+    constexpr unsigned int WEIGHT_WINDOW = 8;
+
+    // Delta sync (GET_WEIGHT_DELTA): the central writes the uint32 base version it holds to
+    // the sync characteristic first. If that matches the device's base, the stream is a header
+    // [0xFFFFFFFE][uint32 base version][uint32 new version], run packets
+    // [0xFFFFFFFD]{[uint16 skip][uint8 n][n x fp16 delta]}... and a trailer [0xFFFFFFFF][CRC-32
+    // of the new fp16 base][uint32 changed count]. A run starts skip weights after the previous
+    // one ended; the central applies base = fp16(float(base) + float(delta)). Otherwise a full
+    // GET_WEIGHTS stream is sent. Either way the sync characteristic then holds the new version.
+    constexpr char SYNC_CHAR_UUID[] = "19B10008-E8F2-537E-4F6C-D104768A1214";
+    constexpr uint32_t WEIGHT_DELTA_HEADER_OFFSET = 0xFFFFFFFE;
+    constexpr uint32_t WEIGHT_DELTA_RUNS_OFFSET = 0xFFFFFFFD;
+    constexpr unsigned int WEIGHT_DELTA_HEADER_SIZE = WEIGHT_HEADER_SIZE + 2 * sizeof(uint32_t);
+    constexpr unsigned int DELTA_RUN_HEADER_SIZE = 3;
+    constexpr unsigned int DELTA_RUN_MAX = 255;
+    constexpr float DELTA_MIN_CHANGE = 1e-3f;  // Smaller moves stay on the device until they add up
+
+    // Background training progress FROM Arduino, notified after every epoch
+    // (see NeuralNetworkBikeLock::TrainingProgress)
+    constexpr char TRAINING_CHAR_UUID[] = "19B10009-E8F2-537E-4F6C-D104768A1214";
+
+    // Prediction stream FROM Arduino, used instead of the prediction characteristic while a
+    // central is subscribed. A notification is [uint8 record count] followed by records of
+    // [uint16 sequence][uint32 window end, ms][uint8 class][uint8 probability x 255 per class],
+    // little-endian, as many as the MTU holds. A batch goes out once it has the flush count or
+    // its oldest record reaches the flush age; the central can write {uint8 count, uint8 reserved,
+    // uint16 age ms} to the characteristic to change both.
+    constexpr char PREDICTION_STREAM_CHAR_UUID[] = "19B1000A-E8F2-537E-4F6C-D104768A1214";
+    constexpr unsigned int PREDICTION_STREAM_HEADER_SIZE = 1;
+    constexpr unsigned int PREDICTION_RECORD_SIZE = sizeof(uint16_t) + sizeof(uint32_t) + 1 + NNConfig::NUM_OUTPUTS;
+    constexpr unsigned int PREDICTION_FLUSH_COUNT = 8;      // 0.8 s of sliding DFT decisions
+    constexpr unsigned int PREDICTION_FLUSH_AGE_MS = 1000;
+
+    static_assert(PREDICTION_STREAM_HEADER_SIZE + PREDICTION_RECORD_SIZE <= ATT_MIN_MTU - 3, "A prediction record must fit the default MTU");
+    static_assert(WEIGHT_TRAILER_SIZE <= ATT_MIN_MTU - 3, "Trailer must fit the default MTU");
+    static_assert(WEIGHT_DELTA_HEADER_SIZE <= ATT_MIN_MTU - 3, "Delta header must fit the default MTU");
+    static_assert(NNConfig::MAX_WEIGHTS <= 0xFFFF, "Delta run skips are 16-bit");
+    static_assert((ATT_MIN_MTU - 3 - WEIGHT_HEADER_SIZE) / sizeof(float) > 0, "Default MTU must carry a weight");
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,28 @@
+#ifndef CRC32_H
+#define CRC32_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// CRC-32 (IEEE 802.3, reflected 0xEDB88320), the same as zlib.crc32 / binascii.crc32
+// on the Python side. Nibble table: 64 bytes of flash, two lookups per byte.
+// Start with CRC32_INIT, feed chunks through crc32Update, finish with crc32Final.
+constexpr uint32_t CRC32_INIT = 0xFFFFFFFFUL;
+
+inline uint32_t crc32Update(uint32_t crc, const uint8_t* data, size_t length) {
+    static const uint32_t table[16] = {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+    };
+    for(size_t i = 0; i < length; i++) {
+        crc = table[(crc ^ data[i]) & 0x0F] ^ (crc >> 4);
+        crc = table[(crc ^ (data[i] >> 4)) & 0x0F] ^ (crc >> 4);
+    }
+    return crc;
+}
+
+inline uint32_t crc32Final(uint32_t crc) {
+    return crc ^ 0xFFFFFFFFUL;
+}
+
+#endif
@@ -0,0 +1,53 @@
+#include "CycleTimer.h"
+
+#if defined(__ARM_ARCH_7EM__) || defined(__ARM_ARCH_7M__)
+
+// Cortex-M3/M4 debug registers (ARMv7-M ARM, C1.6 and C1.8)
+#define TB_DEMCR        (*(volatile uint32_t*)0xE000EDFC)
+#define TB_DWT_CTRL     (*(volatile uint32_t*)0xE0001000)
+#define TB_DWT_CYCCNT   (*(volatile uint32_t*)0xE0001004)
+#define TB_DEMCR_TRCENA (1UL << 24)
+#define TB_DWT_CYCCNTENA (1UL << 0)
+
+void CycleTimer::begin() {
+    TB_DEMCR |= TB_DEMCR_TRCENA;
+    TB_DWT_CYCCNT = 0;
+    TB_DWT_CTRL |= TB_DWT_CYCCNTENA;
+}
+
+uint32_t CycleTimer::now() {
+    return TB_DWT_CYCCNT;
+}
+
+uint32_t CycleTimer::ticksPerSecond() {
+    return BenchmarkConfig::CPU_HZ;
+}
+
+#elif defined(__AVR__)
+
+void CycleTimer::begin() {}
+
+uint32_t CycleTimer::now() {
+    return micros();
+}
+
+uint32_t CycleTimer::ticksPerSecond() {
+    return 1000000UL;
+}
+
+#else
+
+#include <chrono>
+
+void CycleTimer::begin() {}
+
+uint32_t CycleTimer::now() {
+    return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+uint32_t CycleTimer::ticksPerSecond() {
+    return 1000000000UL;
+}
+
+#endif
@@ -0,0 +1,16 @@
+#ifndef CYCLE_TIMER_H
+#define CYCLE_TIMER_H
+
+#include <Arduino.h>
+#include "Config.h"
+
+// Free-running tick source for latency measurements. On Cortex-M4 this is the
+// DWT cycle counter (one tick per CPU cycle), elsewhere micros() on AVR or
+// std::chrono nanoseconds on the host. Differences of now() are wrap-safe.
+namespace CycleTimer {
+    void begin();
+    uint32_t now();
+    uint32_t ticksPerSecond();
+}
+
+#endif
@@ -0,0 +1,137 @@
+#ifndef FEATURE_PLAN_H
+#define FEATURE_PLAN_H
+
+#include <Arduino.h>
+#include "Config.h"
+
+// Feature extraction resolved at compile time from the signal configuration.
+// Band boundaries, counts and normalisers are constants, so extract() makes a
+// single pass over the magnitude spectrum: one unrolled loop per band that also
+// feeds the mean/max/std statistics. Variance is merged band by band with the
+// Welford/Chan update, so no second pass over the data is needed.
+// Bands provides static constexpr float edge(i), the FEATURE_BINS + 1 band edges in Hz.
+template <unsigned int Samples, unsigned int SamplingFreq, typename Bands>
+class FeaturePlan {
+public:
+    static constexpr unsigned int NUM_BANDS = SignalConfig::FEATURE_BINS;
+    static constexpr unsigned int SPECTRUM_BINS = Samples / 2;
+
+    // Same truncation as the old runtime code: Hz -> FFT bin index
+    static constexpr unsigned int bandStart(unsigned int band) {
+        return static_cast<unsigned int>(Bands::edge(band) * Samples / SamplingFreq);
+    }
+
+    // spectrum: SPECTRUM_BINS magnitudes, features: TOTAL_FEATURES outputs
+    static void extract(const float* spectrum, float* features) {
+        // Band ends are the next band's start, so the bands tile the spectrum
+        // exactly when the first and last edges line up with it.
+        static_assert(bandStart(0) == 0, "First frequency band must start at bin 0");
+        static_assert(bandStart(NUM_BANDS) == SPECTRUM_BINS, "Last frequency band must end at Nyquist");
+        static_assert(SignalConfig::TOTAL_FEATURES == NUM_BANDS + 3, "Feature layout is bands + mean/max/std");
+        static_assert(SPECTRUM_BINS <= 0x10000, "extractFixed() sums must fit 32 bits");
+
+        Accumulator acc = {0, 0, 0};
+        runBand(spectrum, features, acc, BandTag<0>());
+
+        constexpr float invBins = 1.0f / SPECTRUM_BINS;
+        features[NUM_BANDS] = acc.mean;
+        features[NUM_BANDS + 1] = acc.maxVal;
+        // Rounding in the merge can leave m2 a hair below zero for a flat spectrum
+        features[NUM_BANDS + 2] = acc.m2 > 0 ? sqrt(acc.m2 * invBins) : 0;
+    }
+
+    // Integer version for the fixed-point engine: spectrum holds SPECTRUM_BINS
+    // magnitudes in units of scale. Sums are exact, so there is nothing to shift
+    // or merge, and scale turns them into float once per feature.
+    static void extractFixed(const uint16_t* spectrum, float scale, float* features) {
+        FixedAccumulator acc = {0, 0, 0};
+        runFixedBand(spectrum, scale, features, acc, BandTag<0>());
+
+        constexpr float invBins = 1.0f / SPECTRUM_BINS;
+        // n^2 * variance = n * sum(x^2) - sum(x)^2, exact in 64 bits
+        const uint64_t spread = (uint64_t)SPECTRUM_BINS * acc.s2 - (uint64_t)acc.s1 * acc.s1;
+        features[NUM_BANDS] = acc.s1 * (scale * invBins);
+        features[NUM_BANDS + 1] = acc.maxVal * scale;
+        features[NUM_BANDS + 2] = sqrt((float)spread) * (scale * invBins);
+    }
+
+private:
+    struct Accumulator {
+        float mean;     // Running mean of bins [0, current band start)
+        float m2;       // Running sum of squared deviations from mean
+        float maxVal;
+    };
+
+    struct FixedAccumulator {
+        uint32_t s1;    // SPECTRUM_BINS 16-bit magnitudes
+        uint64_t s2;
+        uint16_t maxVal;
+    };
+
+    template <unsigned int Band> struct BandTag {};
+
+    static inline void runBand(const float*, float*, Accumulator&, BandTag<NUM_BANDS>) {}
+
+    template <unsigned int Band>
+    static inline void runBand(const float* x, float* features, Accumulator& acc, BandTag<Band>) {
+        constexpr unsigned int start = bandStart(Band);
+        constexpr unsigned int end = bandStart(Band + 1);
+        constexpr unsigned int count = end - start;
+        static_assert(count > 0, "Frequency band is narrower than one FFT bin");
+        constexpr float invCount = 1.0f / count;
+
+        // Sums are taken relative to the band's first bin to keep s2 - s1^2/n
+        // well conditioned in float
+        const float shift = x[start];
+        float s1 = 0, s2 = 0, maxVal = acc.maxVal;
+        for(unsigned int i = start; i < end; i++) {
+            float v = x[i];
+            float d = v - shift;
+            s1 += d;
+            s2 += d * d;
+            maxVal = (v > maxVal) ? v : maxVal;
+        }
+
+        const float bandMean = shift + s1 * invCount;
+        const float bandM2 = s2 - s1 * s1 * invCount;
+        features[Band] = bandMean;
+
+        // Chan et al. merge of [0, start) with [start, end): all weights are constants
+        constexpr float weightNew = static_cast<float>(count) / end;
+        constexpr float weightCross = static_cast<float>(start) * count / end;
+        const float delta = bandMean - acc.mean;
+        acc.mean += delta * weightNew;
+        acc.m2 += bandM2 + delta * delta * weightCross;
+        acc.maxVal = maxVal;
+
+        runBand(x, features, acc, BandTag<Band + 1>());
+    }
+
+    static inline void runFixedBand(const uint16_t*, float, float*, FixedAccumulator&, BandTag<NUM_BANDS>) {}
+
+    template <unsigned int Band>
+    static inline void runFixedBand(const uint16_t* x, float scale, float* features, FixedAccumulator& acc, BandTag<Band>) {
+        constexpr unsigned int start = bandStart(Band);
+        constexpr unsigned int end = bandStart(Band + 1);
+        constexpr float invCount = 1.0f / (end - start);
+
+        uint32_t s1 = 0;
+        uint64_t s2 = 0;
+        uint16_t maxVal = acc.maxVal;
+        for(unsigned int i = start; i < end; i++) {
+            uint32_t v = x[i];
+            s1 += v;
+            s2 += v * v;
+            maxVal = (v > maxVal) ? (uint16_t)v : maxVal;
+        }
+
+        features[Band] = s1 * (scale * invCount);
+        acc.s1 += s1;
+        acc.s2 += s2;
+        acc.maxVal = maxVal;
+
+        runFixedBand(x, scale, features, acc, BandTag<Band + 1>());
+    }
+};
+
+#endif
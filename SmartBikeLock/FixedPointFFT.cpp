@@ -0,0 +1,191 @@
+#include "FixedPointFFT.h"
+
+namespace {
+    constexpr int log2Size(unsigned int n) {
+        return n > 1 ? 1 + log2Size(n >> 1) : 0;
+    }
+
+    constexpr int16_t Q15_ONE = 0x7FFF;
+
+    // Largest |component| a butterfly output can reach is (1 + sqrt(2)) times its
+    // largest input, plus one for the rounded product. These inputs keep it
+    // within int16 after shifting right by 0 and 1; anything larger needs 2.
+    constexpr int32_t STAGE_MAX_0 = 13572;
+    constexpr int32_t STAGE_MAX_1 = 27144;
+
+    inline int stageShift(int32_t maxAbs) {
+        return maxAbs <= STAGE_MAX_0 ? 0 : (maxAbs <= STAGE_MAX_1 ? 1 : 2);
+    }
+
+    // Rounded arithmetic shift, left for negative shifts
+    inline int32_t shiftRound(int32_t v, int shift) {
+        if (shift <= 0) {
+            return v * (1 << -shift);
+        }
+        return (v + (1 << (shift - 1))) >> shift;
+    }
+
+    inline int32_t mulQ15(int32_t a, int32_t q15) {
+        return (a * q15 + 0x4000) >> 15;
+    }
+
+    inline int32_t absValue(int32_t v) {
+        return v < 0 ? -v : v;
+    }
+
+    inline int32_t maxAbs4(int32_t a, int32_t b, int32_t c, int32_t d) {
+        int32_t ab = absValue(a) > absValue(b) ? absValue(a) : absValue(b);
+        int32_t cd = absValue(c) > absValue(d) ? absValue(c) : absValue(d);
+        return ab > cd ? ab : cd;
+    }
+
+    uint16_t isqrt(uint32_t v) {
+        uint32_t root = 0;
+        uint32_t bit = 1UL << 30;
+        while (bit > v) {
+            bit >>= 2;
+        }
+        while (bit) {
+            if (v >= root + bit) {
+                v -= root + bit;
+                root = (root >> 1) + bit;
+            } else {
+                root >>= 1;
+            }
+            bit >>= 2;
+        }
+        return (uint16_t)root;
+    }
+
+    inline uint16_t magnitude(int32_t re, int32_t im) {
+        // |re|, |im| <= 32768, so the sum of squares fits 32 bits
+        return isqrt((uint32_t)(re * re) + (uint32_t)(im * im));
+    }
+}
+
+FixedPointFFT::FixedPointFFT() {
+    for(unsigned int i = 0; i < HALF; i++) {
+        double ratio = (double)i / (N - 1);
+        window[i] = (int16_t)lround(Q15_ONE * (0.54 - 0.46 * cos(2.0 * PI * ratio)));
+        double theta = 2.0 * PI * i / N;
+        cosTable[i] = (int16_t)lround(Q15_ONE * cos(theta));
+        sinTable[i] = (int16_t)lround(Q15_ONE * sin(theta));
+    }
+    for(unsigned int i = 0; i < N; i++) {
+        data[i] = 0;
+    }
+}
+
+int FixedPointFFT::magnitudes(const int16_t* raw, uint16_t* out) {
+    int exponent = 0;
+    int32_t maxAbs = load(raw, exponent);
+    maxAbs = transform(maxAbs, exponent);
+    split(maxAbs, exponent, out);
+    return exponent;
+}
+
+int32_t FixedPointFFT::load(const int16_t* raw, int& exponent) {
+    // N * (x - mean) is an integer, so DC comes out exactly rather than
+    // leaving the rounding error of an integer mean in bin 0
+    int32_t sum = 0;
+    for(unsigned int i = 0; i < N; i++) {
+        sum += raw[i];
+    }
+    int32_t peak = 0;
+    for(unsigned int i = 0; i < N; i++) {
+        int32_t d = absValue((int32_t)raw[i] * (int32_t)N - sum);
+        peak = d > peak ? d : peak;
+    }
+
+    // Scale the largest deviation into [2^14, 2^15)
+    int shift = 0;
+    while (shiftRound(peak, shift) > Q15_ONE) {
+        shift++;
+    }
+    while (peak > 0 && shiftRound(peak, shift - 1) <= Q15_ONE) {
+        shift--;
+    }
+    exponent = shift - log2Size(N);
+
+    int32_t maxAbs = 0;
+    for(unsigned int i = 0; i < N; i++) {
+        int32_t d = shiftRound((int32_t)raw[i] * (int32_t)N - sum, shift);
+        int32_t w = window[i < HALF ? i : N - 1 - i];
+        data[i] = (int16_t)mulQ15(d, w);
+        int32_t a = absValue(data[i]);
+        maxAbs = a > maxAbs ? a : maxAbs;
+    }
+    return maxAbs;
+}
+
+int32_t FixedPointFFT::transform(int32_t maxAbs, int& exponent) {
+    // Bit-reverse the complex points
+    for(unsigned int i = 0, j = 0; i < HALF - 1; i++) {
+        if (i < j) {
+            int16_t r = data[2 * i];
+            int16_t m = data[2 * i + 1];
+            data[2 * i] = data[2 * j];
+            data[2 * i + 1] = data[2 * j + 1];
+            data[2 * j] = r;
+            data[2 * j + 1] = m;
+        }
+        unsigned int k = HALF >> 1;
+        while (k <= j) {
+            j -= k;
+            k >>= 1;
+        }
+        j += k;
+    }
+
+    for(unsigned int span = 1; span < HALF; span <<= 1) {
+        const int shift = stageShift(maxAbs);
+        const unsigned int stride = HALF / span;   // Twiddle e^(-j*2*pi*m/(2*span)) is table entry m * stride
+        exponent += shift;
+        int32_t nextMax = 0;
+        for(unsigned int m = 0; m < span; m++) {
+            const int32_t wr = cosTable[m * stride];
+            const int32_t wi = -sinTable[m * stride];
+            for(unsigned int i = m; i < HALF; i += 2 * span) {
+                int16_t* a = &data[2 * i];
+                int16_t* b = &data[2 * (i + span)];
+                // |w| <= 1, so each sum of products is at most |b| * 2^15 and fits int32
+                const int32_t tr = (wr * b[0] - wi * b[1] + 0x4000) >> 15;
+                const int32_t ti = (wr * b[1] + wi * b[0] + 0x4000) >> 15;
+                const int32_t ar = a[0];
+                const int32_t ai = a[1];
+                a[0] = (int16_t)shiftRound(ar + tr, shift);
+                a[1] = (int16_t)shiftRound(ai + ti, shift);
+                b[0] = (int16_t)shiftRound(ar - tr, shift);
+                b[1] = (int16_t)shiftRound(ai - ti, shift);
+                int32_t big = maxAbs4(a[0], a[1], b[0], b[1]);
+                nextMax = big > nextMax ? big : nextMax;
+            }
+        }
+        maxAbs = nextMax;
+    }
+    return maxAbs;
+}
+
+void FixedPointFFT::split(int32_t maxAbs, int& exponent, uint16_t* out) const {
+    // Same unpacking as ArduinoFFT::computeReal(): E[k] = (Z[k] + conj(Z[N/2 - k])) / 2,
+    // O[k] = -j (Z[k] - conj(Z[N/2 - k])) / 2, X[k] = E[k] + W^k O[k] and
+    // X[N/2 - k] = conj(E[k] - W^k O[k]). It grows like one more butterfly stage.
+    const int shift = stageShift(maxAbs);
+    exponent += shift;
+
+    out[0] = (uint16_t)absValue(shiftRound((int32_t)data[0] + data[1], shift));
+    for(unsigned int k = 1; k <= HALF / 2; k++) {
+        const int16_t* za = &data[2 * k];
+        const int16_t* zb = &data[2 * (HALF - k)];
+        const int32_t er = shiftRound((int32_t)za[0] + zb[0], 1);
+        const int32_t ei = shiftRound((int32_t)za[1] - zb[1], 1);
+        const int32_t orr = shiftRound((int32_t)za[1] + zb[1], 1);
+        const int32_t oi = shiftRound((int32_t)zb[0] - za[0], 1);
+        const int32_t wr = cosTable[k];
+        const int32_t wi = -sinTable[k];
+        const int32_t tr = mulQ15(orr, wr) - mulQ15(oi, wi);
+        const int32_t ti = mulQ15(oi, wr) + mulQ15(orr, wi);
+        out[k] = magnitude(shiftRound(er + tr, shift), shiftRound(ei + ti, shift));
+        out[HALF - k] = magnitude(shiftRound(er - tr, shift), shiftRound(ei - ti, shift));
+    }
+}
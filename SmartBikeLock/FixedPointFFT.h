@@ -0,0 +1,37 @@
+#ifndef FIXED_POINT_FFT_H
+#define FIXED_POINT_FFT_H
+
+#include <Arduino.h>
+#include "Config.h"
+
+// Q15 version of the float FFT path (dcRemoval + Hamming + computeReal +
+// complexToMagnitudeReal) for raw accelerometer counts. Samples stay 16-bit
+// from the register to the magnitudes, with one block floating-point exponent
+// for the whole window: the DC-free window is scaled to fill the Q15 range, and
+// each radix-2 stage shifts right only as far as its largest input needs to
+// rule out overflow, instead of the fixed 1/2 per stage that costs quiet
+// windows their resolution. Products and sums are taken in 32 bits, like the
+// CMSIS-DSP q15 kernels.
+class FixedPointFFT {
+public:
+    FixedPointFFT();
+
+    // raw: SAMPLES accelerometer counts. Writes SAMPLES/2 magnitudes and returns
+    // their exponent: magnitude in counts = out[k] * 2^exponent
+    int magnitudes(const int16_t* raw, uint16_t* out);
+
+private:
+    static constexpr unsigned int N = SignalConfig::SAMPLES;
+    static constexpr unsigned int HALF = N / 2;    // Complex points of the packed half-size FFT
+
+    int16_t data[N];          // Interleaved re/im, even samples real and odd samples imaginary
+    int16_t window[HALF];     // Q15 Hamming, applied to i and N - 1 - i
+    int16_t cosTable[HALF];   // Q15 cos(2*pi*k/N)
+    int16_t sinTable[HALF];   // Q15 sin(2*pi*k/N)
+
+    int32_t load(const int16_t* raw, int& exponent);
+    int32_t transform(int32_t maxAbs, int& exponent);
+    void split(int32_t maxAbs, int& exponent, uint16_t* out) const;
+};
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef FLOAT16_H
+#define FLOAT16_H
+
+#include <stdint.h>
+#include <string.h>
+
+// IEEE 754 binary16 conversion with round-to-nearest-even, bit-identical to
+// numpy.float32.astype(numpy.float16) so both ends of a delta sync agree on the base.
+inline uint16_t floatToHalf(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    uint16_t sign = (bits >> 16) & 0x8000;
+    uint32_t absBits = bits & 0x7FFFFFFF;
+
+    if (absBits > 0x7F800000) {
+        return sign | 0x7E00;                      // NaN
+    }
+    if (absBits >= 0x477FF000) {
+        return sign | 0x7C00;                      // >= 65520 rounds to infinity
+    }
+    if (absBits < 0x38800000) {
+        // Subnormal half: adding 0.5f lets the FPU round to a multiple of 2^-24
+        float magnitude;
+        memcpy(&magnitude, &absBits, sizeof(magnitude));
+        magnitude += 0.5f;
+        uint32_t rounded;
+        memcpy(&rounded, &magnitude, sizeof(rounded));
+        return sign | (uint16_t)(rounded - 0x3F000000);
+    }
+    // Normal: rebias the exponent, round the 13 dropped mantissa bits to even
+    uint32_t rounded = absBits + 0xFFF + ((absBits >> 13) & 1);
+    return sign | (uint16_t)((rounded - (112UL << 23)) >> 13);
+}
+
+inline float halfToFloat(uint16_t half) {
+    uint32_t sign = (uint32_t)(half & 0x8000) << 16;
+    uint32_t exponent = (half >> 10) & 0x1F;
+    uint32_t mantissa = half & 0x3FF;
+    uint32_t bits;
+
+    if (exponent == 0) {
+        float magnitude = mantissa * 5.9604644775390625e-8f;  // mantissa x 2^-24, exact
+        memcpy(&bits, &magnitude, sizeof(bits));
+        bits |= sign;
+    } else if (exponent == 0x1F) {
+        bits = sign | 0x7F800000 | (mantissa << 13);
+    } else {
+        bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    }
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+#endif
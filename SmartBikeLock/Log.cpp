@@ -0,0 +1,151 @@
+#include <Arduino.h>
+#include "Log.h"
+
+namespace {
+    constexpr uint16_t RING_MASK = LogConfig::RING_SIZE - 1;
+
+    Log::Record ring[LogConfig::RING_SIZE];
+    volatile uint16_t head = 0;        // Next slot to write, moved by the producer only
+    volatile uint16_t tail = 0;        // Next slot to drain, moved by drain() only
+    volatile uint32_t written = 0;
+    volatile uint32_t dropped = 0;
+    uint32_t droppedReported = 0;
+
+    // Keeps the compiler from moving record stores/loads across the index update;
+    // a single Cortex-M4 core needs no hardware barrier on top
+    inline void barrier() {
+        __asm__ __volatile__("" ::: "memory");
+    }
+
+    Log::Record* reserve(uint8_t level, const char* format) {
+        uint16_t h = head;
+        if ((uint16_t)(h - tail) >= LogConfig::RING_SIZE) {
+            dropped = dropped + 1;
+            return nullptr;
+        }
+        Log::Record* record = &ring[h & RING_MASK];
+        record->format = format;
+        record->timeMs = millis();
+        record->level = level;
+        return record;
+    }
+
+    void commit() {
+        barrier();
+        head = head + 1;
+        written = written + 1;
+    }
+
+    void printRecord(const Log::Record& record) {
+        static const char levels[] = "-EWID";
+        Serial.print('[');
+        Serial.print((unsigned long)record.timeMs);
+        Serial.print("] ");
+        Serial.print(levels[record.level <= LOG_LEVEL_DEBUG ? record.level : 0]);
+        Serial.print(' ');
+
+        uint8_t arg = 0;
+        for (const char* p = record.format; *p; p++) {
+            if (*p != '%' || p[1] == '\0') {
+                Serial.print(*p);
+                continue;
+            }
+            char spec = *++p;
+            if (spec == '%') {
+                Serial.print('%');
+                continue;
+            }
+            if (spec == 's') {
+                Serial.print(record.argCount == 0 ? record.text : "?");
+                continue;
+            }
+            if (arg >= record.argCount) {
+                Serial.print('?');
+                continue;
+            }
+            uint32_t value = record.args[arg++];
+            switch (spec) {
+                case 'd':
+                    Serial.print((long)(int32_t)value);
+                    break;
+                case 'u':
+                    Serial.print((unsigned long)value);
+                    break;
+                case 'x':
+                    Serial.print((unsigned long)value, HEX);
+                    break;
+                case 'f': {
+                    float f;
+                    memcpy(&f, &value, sizeof(f));
+                    Serial.print(f, 3);
+                    break;
+                }
+                default:
+                    Serial.print('?');
+                    break;
+            }
+        }
+        Serial.println();
+    }
+}
+
+namespace Log {
+
+void push(uint8_t level, const char* format, const uint32_t* args, uint8_t argCount) {
+    Record* record = reserve(level, format);
+    if (!record) {
+        return;
+    }
+    record->argCount = argCount;
+    record->text[0] = '\0';
+    for (uint8_t i = 0; i < argCount; i++) {
+        record->args[i] = args[i];
+    }
+    commit();
+}
+
+void pushText(uint8_t level, const char* format, const char* text) {
+    Record* record = reserve(level, format);
+    if (!record) {
+        return;
+    }
+    // argCount 0 marks the payload as text
+    record->argCount = 0;
+    strncpy(record->text, text ? text : "", LogConfig::TEXT_SIZE - 1);
+    record->text[LogConfig::TEXT_SIZE - 1] = '\0';
+    commit();
+}
+
+size_t drain(size_t maxRecords) {
+    size_t printed = 0;
+    while (printed < maxRecords && tail != head) {
+        barrier();
+        printRecord(ring[tail & RING_MASK]);
+        barrier();
+        tail = tail + 1;
+        printed++;
+    }
+
+    uint32_t lost = dropped;
+    if (lost != droppedReported && tail == head) {
+        Serial.print("[log] ");
+        Serial.print((unsigned long)(lost - droppedReported));
+        Serial.println(" records dropped");
+        droppedReported = lost;
+    }
+    return printed;
+}
+
+size_t pending() {
+    return (uint16_t)(head - tail);
+}
+
+uint32_t getDropped() {
+    return dropped;
+}
+
+uint32_t getWritten() {
+    return written;
+}
+
+}
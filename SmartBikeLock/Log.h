@@ -0,0 +1,101 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "Config.h"
+
+// Deferred, leveled logging. A LOG_* call stores the format pointer (the literal
+// stays in flash and doubles as the message id), a millis() stamp and up to
+// LogConfig::MAX_ARGS raw 32-bit arguments in a ring buffer. Nothing is formatted
+// or written to Serial until the loop is idle and calls Log::drain().
+//
+// Formats understand %d %u %x %f and %%. %s copies up to LogConfig::TEXT_SIZE - 1
+// characters into the record and must be the only argument.
+//
+// Levels above LOG_LEVEL compile to nothing, arguments included. Set LOG_LEVEL
+// here or with -DLOG_LEVEL=... for the whole sketch.
+#define LOG_LEVEL_NONE  0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN  2
+#define LOG_LEVEL_INFO  3
+#define LOG_LEVEL_DEBUG 4
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERROR(...) Log::write(LOG_LEVEL_ERROR, __VA_ARGS__)
+#else
+#define LOG_ERROR(...) ((void)0)
+#endif
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_WARN(...) Log::write(LOG_LEVEL_WARN, __VA_ARGS__)
+#else
+#define LOG_WARN(...) ((void)0)
+#endif
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INFO(...) Log::write(LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+#define LOG_INFO(...) ((void)0)
+#endif
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(...) Log::write(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) ((void)0)
+#endif
+
+namespace Log {
+    struct Record {
+        const char* format;
+        uint32_t timeMs;
+        uint8_t level;
+        uint8_t argCount;
+        uint8_t reserved[2];
+        union {
+            uint32_t args[LogConfig::MAX_ARGS];
+            char text[LogConfig::TEXT_SIZE];
+        };
+    };
+
+    // Single producer (loop context, not ISRs), single consumer (drain()): the
+    // producer only moves head, drain() only moves tail, so neither needs a lock
+    void push(uint8_t level, const char* format, const uint32_t* args, uint8_t argCount);
+    void pushText(uint8_t level, const char* format, const char* text);
+
+    // Formats and prints up to maxRecords records, then reports drops since the last
+    // report. Returns how many records were printed.
+    size_t drain(size_t maxRecords = LogConfig::RING_SIZE);
+    size_t pending();
+    uint32_t getDropped();
+    uint32_t getWritten();
+
+    inline uint32_t packArg(int value) { return (uint32_t)value; }
+    inline uint32_t packArg(unsigned int value) { return value; }
+    inline uint32_t packArg(long value) { return (uint32_t)value; }
+    inline uint32_t packArg(unsigned long value) { return (uint32_t)value; }
+    inline uint32_t packArg(long long value) { return (uint32_t)value; }
+    inline uint32_t packArg(unsigned long long value) { return (uint32_t)value; }
+    inline uint32_t packArg(bool value) { return value ? 1 : 0; }
+    inline uint32_t packArg(float value) { uint32_t bits; memcpy(&bits, &value, sizeof(bits)); return bits; }
+    inline uint32_t packArg(double value) { return packArg((float)value); }
+    // Pointers would dangle by the time the record is drained; use a lone %s
+    uint32_t packArg(const char* value) = delete;
+
+    inline void write(uint8_t level, const char* format) {
+        push(level, format, nullptr, 0);
+    }
+    inline void write(uint8_t level, const char* format, const char* text) {
+        pushText(level, format, text);
+    }
+    template <typename... Args>
+    inline void write(uint8_t level, const char* format, Args... args) {
+        static_assert(sizeof...(Args) <= LogConfig::MAX_ARGS, "Too many log arguments");
+        const uint32_t packed[] = {packArg(args)...};
+        push(level, format, packed, sizeof...(Args));
+    }
+}
+
+#endif
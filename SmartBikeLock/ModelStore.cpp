@@ -0,0 +1,139 @@
+#include <Arduino.h>
+#include "ModelStore.h"
+#include "Crc32.h"
+#include "Log.h"
+
+namespace {
+    constexpr size_t WEIGHT_BYTES = NNConfig::MAX_WEIGHTS * sizeof(float);
+    constexpr size_t SAVE_CHUNK = 64;   // Weights per program call
+}
+
+#if defined(ARDUINO_ARCH_MBED)
+
+#include <mbed.h>
+
+namespace {
+    mbed::FlashIAP flash;
+
+    bool flashBegin(uint32_t& address) {
+        if (flash.init() != 0) {
+            return false;
+        }
+        uint32_t end = flash.get_flash_start() + flash.get_flash_size();
+        address = end - StoreConfig::TOP_GAP - StoreConfig::REGION_SIZE;
+        return flash.get_sector_size(address) == StoreConfig::PAGE_SIZE;
+    }
+
+    const uint8_t* flashMap(uint32_t address) {
+        return reinterpret_cast<const uint8_t*>(address);
+    }
+
+    bool flashErase(uint32_t address, size_t size) {
+        return flash.erase(address, size) == 0;
+    }
+
+    bool flashProgram(uint32_t address, const void* data, size_t size) {
+        return flash.program(data, address, size) == 0;
+    }
+}
+
+#elif defined(SIMULATED_FLASH)
+
+// Host build (extras/replay): the helpers above over a simulated region
+#include <SimulatedFlash.h>
+
+#else
+
+#error "ModelStore needs the Arduino mbed core's FlashIAP (Nano 33 BLE)"
+
+#endif
+
+ModelStore::ModelStore() :
+    region(nullptr),
+    address(0),
+    ready(false)
+{
+}
+
+bool ModelStore::begin() {
+    ready = flashBegin(address);
+    region = ready ? flashMap(address) : nullptr;
+    if (!ready) {
+        LOG_ERROR("Model flash region unavailable");
+    }
+    return ready;
+}
+
+const float* ModelStore::find(uint32_t* version) const {
+    if (!ready) {
+        return nullptr;
+    }
+    const Header* header = reinterpret_cast<const Header*>(region);
+    if (header->magic != StoreConfig::MAGIC || header->format != StoreConfig::FORMAT ||
+        header->numLayers != NNConfig::NUM_LAYERS || header->weightCount != NNConfig::MAX_WEIGHTS) {
+        return nullptr;
+    }
+    for (unsigned int i = 0; i < NNConfig::NUM_LAYERS; i++) {
+        if (header->layers[i] != NNConfig::LAYERS[i]) {
+            return nullptr;
+        }
+    }
+    const uint8_t* weights = region + StoreConfig::HEADER_SIZE;
+    if (crc32Final(crc32Update(CRC32_INIT, weights, WEIGHT_BYTES)) != header->crc) {
+        LOG_WARN("Stored model fails its CRC");
+        return nullptr;
+    }
+    if (version) {
+        *version = header->version;
+    }
+    return reinterpret_cast<const float*>(weights);
+}
+
+bool ModelStore::save(NeuralNetworkBikeLock& nn) {
+    if (!ready || nn.getTotalWeights() != NNConfig::MAX_WEIGHTS) {
+        return false;
+    }
+    if (nn.readsWeightsInPlace()) {
+        // Unchanged since they were loaded, and erasing would pull them from under the network
+        LOG_INFO("Weights already stored");
+        return true;
+    }
+    if (!flashErase(address, StoreConfig::REGION_SIZE)) {
+        LOG_ERROR("Model flash erase failed");
+        return false;
+    }
+
+    float chunk[SAVE_CHUNK];
+    uint32_t crc = CRC32_INIT;
+    size_t offset = 0;
+    while (offset < NNConfig::MAX_WEIGHTS) {
+        size_t n = nn.readWeights(chunk, offset, SAVE_CHUNK);
+        if (n == 0 || !flashProgram(address + StoreConfig::HEADER_SIZE + offset * sizeof(float), chunk, n * sizeof(float))) {
+            LOG_ERROR("Model flash write failed at weight %u", offset);
+            return false;
+        }
+        crc = crc32Update(crc, reinterpret_cast<const uint8_t*>(chunk), n * sizeof(float));
+        offset += n;
+    }
+
+    Header header;
+    header.magic = StoreConfig::MAGIC;
+    header.format = StoreConfig::FORMAT;
+    header.numLayers = NNConfig::NUM_LAYERS;
+    for (unsigned int i = 0; i < NNConfig::NUM_LAYERS; i++) {
+        header.layers[i] = NNConfig::LAYERS[i];
+    }
+    header.weightCount = NNConfig::MAX_WEIGHTS;
+    header.version = nn.getVersion();
+    header.crc = crc32Final(crc);
+    if (!flashProgram(address, &header, sizeof(header))) {
+        LOG_ERROR("Model flash header write failed");
+        return false;
+    }
+    LOG_INFO("Weights v%u saved to flash", header.version);
+    return true;
+}
+
+bool ModelStore::erase() {
+    return ready && flashErase(address, StoreConfig::REGION_SIZE);
+}
@@ -0,0 +1,46 @@
+#ifndef MODEL_STORE_H
+#define MODEL_STORE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "Config.h"
+#include "NeuralNetworkBikeLock.h"
+
+// Trained weights in a raw region of internal flash just below the pages
+// NanoBLEFlashPrefs uses (too small for a model: one 4 KB record). Flash is
+// memory-mapped, so find() returns a pointer init() reads in place: boot costs
+// one CRC pass and no copy.
+//
+// Layout: [Header, padded to StoreConfig::HEADER_SIZE][float32 weights, flat order].
+// save() erases the region, programs the weights and writes the header last, so a
+// save cut short by a reset leaves no header and find() ignores the region.
+class ModelStore {
+public:
+    struct Header {
+        uint32_t magic;
+        uint16_t format;
+        uint16_t numLayers;
+        uint32_t layers[NNConfig::NUM_LAYERS];
+        uint32_t weightCount;
+        uint32_t version;       // Network version when saved
+        uint32_t crc;           // CRC-32 of the weight bytes
+    };
+    static_assert(sizeof(Header) <= StoreConfig::HEADER_SIZE, "Header must fit its slot");
+    static_assert(StoreConfig::HEADER_SIZE % 16 == 0, "Weights must stay 16-byte aligned");
+
+    ModelStore();
+    bool begin();
+
+    // Weights for NNConfig::LAYERS whose CRC matches, or nullptr
+    const float* find(uint32_t* version = nullptr) const;
+    // Blocks for the page erases (tens of ms each on the nRF52840)
+    bool save(NeuralNetworkBikeLock& nn);
+    bool erase();
+
+private:
+    const uint8_t* region;      // Memory-mapped start
+    uint32_t address;           // Flash address for erase/program
+    bool ready;
+};
+
+#endif
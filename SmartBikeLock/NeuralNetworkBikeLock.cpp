@@ -2,65 +2,393 @@
 #define _1_OPTIMIZE 0B00010000
 #include "NeuralNetworkBikeLock.h"
 #include <NeuralNetwork.h>
+#include <new>
+#include "Log.h"
+#include "CycleTimer.h"
 
-NeuralNetworkBikeLock::NeuralNetworkBikeLock() : nn(nullptr), isInitialized(false) {
+namespace {
+    // The STATIC backend: one network, claimed by the first init() that asks for it
+    NeuralNetworkBikeLock::StaticModel staticModel;
+    bool staticModelClaimed = false;
+    // CSR of the pruned network, allocated by the first prune() and owned by the network that pruned
+    NeuralNetworkBikeLock::SparseModel* sparseModel = nullptr;
+    NeuralNetworkBikeLock* sparseModelOwner = nullptr;
+
+    bool matchesStaticModel(const unsigned int* layer_, unsigned int numberOfLayers) {
+        if (numberOfLayers != NNConfig::NUM_LAYERS) return false;
+        for (unsigned int i = 0; i < numberOfLayers; i++) {
+            if (layer_[i] != NNConfig::LAYERS[i]) return false;
+        }
+        return true;
+    }
+}
+
+NeuralNetworkBikeLock::NeuralNetworkBikeLock() :
+    nn(nullptr),
+    staticNet(nullptr),
+    sparseNet(nullptr),
+    standby(nullptr),
+    snapshot(nullptr),
+    snapshotModel(nullptr),
+    snapshotVersion(0),
+    snapshotGateTrained(false),
+    sparseInference(true),
+    cascadeEnabled(NNConfig::CASCADE_ENABLED),
+    cascadeThreshold(NNConfig::CASCADE_THRESHOLD),
+    gateTrained(false),
+    cascade(),
+    backend(NNConfig::DEFAULT_BACKEND),
+    isInitialized(false),
+    version(1),
+    progress(),
+    epochSize(0),
+    epochPosition(0),
+    epochLoss(0.0f),
+    batchSamples(0)
+{
 }
 
 
 
 
-void NeuralNetworkBikeLock::init(const unsigned int* layer_, float* weights, const unsigned int& NumberOflayers) {
-    Serial.println("Starting NN initialization...");
+void NeuralNetworkBikeLock::init(const unsigned int* layer_, const float* weights, const unsigned int& NumberOflayers) {
     if (!isInitialized) {
         numLayers = NumberOflayers;
         
         layers = new unsigned int[numLayers];
         memcpy(layers, layer_, numLayers * sizeof(unsigned int));
         
-        // Calculate total weights needed
-        size_t totalWeights = getTotalWeights();
-        Serial.print("Total weights to initialize: ");
-        Serial.println(totalWeights);
-        
+        if (backend == NNConfig::Backend::STATIC) {
+            // Read in place, the static network has nowhere to put random weights
+            if (staticModelClaimed || !matchesStaticModel(layer_, NumberOflayers) ||
+                (!StaticModel::TRAINABLE && weights == nullptr)) {
+                LOG_WARN("Static backend unavailable for this network, using dynamic");
+                backend = NNConfig::Backend::DYNAMIC;
+            } else {
+                staticModelClaimed = true;
+                staticNet = &staticModel;
+            }
+        }
+
         // If no weights provided, create random weights
-        if (weights == nullptr) {
+        if (staticNet) {
+            if (weights == nullptr) {
+                staticNet->randomize();
+            } else {
+                staticNet->useExternalWeights(weights);
+            }
+        } else if (weights == nullptr) {
             nn= new NeuralNetwork(layer_, NumberOflayers);
         } else {
-            nn = new NeuralNetwork(layer_, weights, NumberOflayers);
+            // The library trains the array it is given in place, and weights may be read-only
+            size_t total = 0;
+            for (unsigned int i = 0; i + 1 < NumberOflayers; i++) {
+                total += layer_[i] * layer_[i + 1];
+            }
+            float* copy = new float[total];
+            memcpy(copy, weights, total * sizeof(float));
+            nn = new NeuralNetwork(layer_, copy, NumberOflayers);
         }
         
+        // Drawn after the full network so its weights do not depend on the cascade
+        firstStage.randomize();
+        CycleTimer::begin();
+
         isInitialized = true;
-        Serial.println("Neural Network initialized successfully");
+        for (unsigned int i = 0; i + 1 < numLayers; i++) {
+            LOG_DEBUG("Layer %u weights: %u x %u", i, layers[i], layers[i + 1]);
+        }
+        if (staticNet) {
+            LOG_INFO("Neural Network initialized, static backend, weights: %u", getTotalWeights());
+        } else {
+            LOG_INFO("Neural Network initialized, dynamic backend, weights: %u", getTotalWeights());
+        }
     } else {
-        Serial.println("Neural Network already initialized");
+        LOG_WARN("Neural Network already initialized");
     }
 }
 
 void NeuralNetworkBikeLock::performLiveTraining(const float* features, int label) {
     if (!isInitialized || label < 0 || label > 2) return;  // Changed to check for binary labels
+    if (!isTrainable()) {
+        LOG_WARN("Weights are read in place, training refused");
+        return;
+    }
     
-    Serial.println("Starting training process...");
-    float expectedOutput[3] = {0.0f, 0.0f, 0.0f};
+    trainSample(features, label, false);
+    version++;
+    LOG_DEBUG("Trained on label %d, weight version %u", label, version);
+}
+
+float NeuralNetworkBikeLock::trainSample(const float* features, int label, bool accumulate) {
+    float expectedOutput[NNConfig::NUM_OUTPUTS] = {};
     expectedOutput[label] = 1.0f;
-    Serial.println("Created one-hot encoded output");
-    Serial.print("Target: [");
-    for(int i = 0; i < 3; i++) {
-        Serial.print(expectedOutput[i]);
-        if(i < 2) Serial.print(", ");
+    const float* outputs = denseFeedForward(features);
+
+    float squaredError = 0.0f;
+    for (unsigned int i = 0; i < NNConfig::NUM_OUTPUTS; i++) {
+        float error = outputs[i] - expectedOutput[i];
+        squaredError += error * error;
+    }
+    if (accumulate) {
+        if (staticNet) {
+            staticNet->accumulateGradients(expectedOutput);
+        } else {
+            nn->AccumulateGradients(expectedOutput);
+        }
+        firstStage.feedForward(features);
+        firstStage.accumulateGradients(expectedOutput);
+        gateTrained = true;
+        batchSamples++;
+        return squaredError / NNConfig::NUM_OUTPUTS;
     }
-    Serial.println("]");
-    Serial.println("Performing backpropagation...");
-    nn->FeedForward(features);
-    nn->BackProp(expectedOutput);  // Pass the array directly
-    Serial.println("Backpropagation completed");
 
-    Serial.println("Training process completed");
+    if (staticNet) {
+        staticNet->backProp(expectedOutput);
+    } else {
+        nn->BackProp(expectedOutput);  // Pass the array directly
+    }
+    if (sparseNet) {
+        sparseNet->refresh(flatWeights());
+    }
+    // The first stage trains alongside whether the cascade is on or not (a few percent
+    // of the full network's work), so it is ready whenever the cascade is enabled
+    firstStage.feedForward(features);
+    firstStage.backProp(expectedOutput);
+    gateTrained = true;
+    return squaredError / NNConfig::NUM_OUTPUTS;
+}
+
+void NeuralNetworkBikeLock::applyBatch() {
+    if (batchSamples == 0) {
+        return;
+    }
+    if (staticNet) {
+        staticNet->applyGradients(batchSamples);
+    } else {
+        nn->ApplyGradients(batchSamples);
+    }
+    if (sparseNet) {
+        sparseNet->refresh(flatWeights());
+    }
+    firstStage.applyGradients(batchSamples);
+    batchSamples = 0;
+    version++;
+}
+
+void NeuralNetworkBikeLock::dropBatch() {
+    if (batchSamples == 0) {
+        return;
+    }
+    if (staticNet) {
+        staticNet->clearGradients();
+    } else {
+        nn->setOptimizer(OPTIMIZER_SGD);   // Reallocates the sums cleared
+    }
+    firstStage.clearGradients();
+    batchSamples = 0;
+}
+
+void NeuralNetworkBikeLock::setCascade(bool enabled, float threshold) {
+    if (enabled && !gateTrained) {
+        trainFirstStage();
+    }
+    cascadeEnabled = enabled;
+    cascadeThreshold = threshold;
+    resetCascadeStats();
+}
+
+// The first stage has not trained since boot (the stored model only holds the full
+// network): TRAIN_EPOCHS SGD epochs over the replay buffer, in buffer order
+void NeuralNetworkBikeLock::trainFirstStage() {
+    if (replay.size() == 0) {
+        LOG_WARN("No samples for the cascade's first stage, every window escalates");
+        return;
+    }
+    firstStage.clearGradients();
+    for (unsigned int epoch = 0; epoch < NNConfig::TRAIN_EPOCHS; epoch++) {
+        for (size_t i = 0; i < replay.size(); i++) {
+            float expectedOutput[NNConfig::NUM_OUTPUTS] = {};
+            expectedOutput[replay[i].label] = 1.0f;
+            firstStage.feedForward(replay[i].features);
+            firstStage.backProp(expectedOutput);
+        }
+    }
+    gateTrained = true;
+    LOG_INFO("Cascade first stage trained on %u samples", replay.size());
+}
+
+void NeuralNetworkBikeLock::resetCascadeStats() {
+    cascade = CascadeStats();
+}
+
+// Inference entry point: the first stage when it is sure enough, else the full
+// network. An untrained first stage is skipped and every window escalates.
+const float* NeuralNetworkBikeLock::classify(const float* features) {
+    if (!cascadeEnabled) {
+        return feedForward(features);
+    }
+    uint32_t start = CycleTimer::now();
+    uint32_t decided = start;
+    if (gateTrained) {
+        const float* output = firstStage.feedForward(features);
+        float maxProb = output[0];
+        for (unsigned int i = 1; i < NNConfig::NUM_OUTPUTS; i++) {
+            maxProb = output[i] > maxProb ? output[i] : maxProb;
+        }
+        decided = CycleTimer::now();
+        cascade.firstStageTicks += decided - start;
+        if (maxProb >= cascadeThreshold) {
+            cascade.firstStageHits++;
+            return output;
+        }
+    }
+
+    const float* output = feedForward(features);
+    cascade.secondStageTicks += CycleTimer::now() - decided;
+    cascade.escalations++;
+    return output;
+}
+
+const float* NeuralNetworkBikeLock::feedForward(const float* features) {
+    if (sparseNet && sparseInference) {
+        return sparseNet->feedForward(features);
+    }
+    return denseFeedForward(features);
+}
+
+// Training needs the activations the dense network keeps for BackProp
+const float* NeuralNetworkBikeLock::denseFeedForward(const float* features) {
+    return staticNet ? staticNet->feedForward(features) : nn->FeedForward(features);
+}
+
+float* NeuralNetworkBikeLock::flatWeights() {
+    if (staticNet) {
+        return staticNet->getWeights();
+    }
+    #if defined(REDUCE_RAM_WEIGHTS_LVL2)
+        return nn->weights;
+    #else
+        return nn->layers[0].weights[0];   // Start of the weight arena
+    #endif
+}
+
+size_t NeuralNetworkBikeLock::prune(float sparsity) {
+    if (!isInitialized || !flatWeights() || !matchesStaticModel(layers, numLayers) ||
+        (sparseModelOwner && sparseModelOwner != this)) {
+        LOG_WARN("Network cannot be pruned");
+        return 0;
+    }
+    if (!sparseModel) {
+        sparseModel = new (std::nothrow) SparseModel();
+        if (!sparseModel) {
+            LOG_WARN("No RAM for the sparse model");
+            return 0;
+        }
+    }
+    sparseModelOwner = this;
+    sparseNet = sparseModel;
+    size_t kept = sparseNet->prune(flatWeights(), sparsity);
+    version++;
+    LOG_INFO("Pruned to %u of %u weights", kept, getTotalWeights());
+    return kept;
+}
+
+size_t NeuralNetworkBikeLock::getInferenceMacs() {
+    return (sparseNet && sparseInference) ? sparseNet->getMacs() : getTotalWeights();
+}
+
+bool NeuralNetworkBikeLock::addTrainingSample(const float* features, int label) {
+    if (!features || label < 0 || label >= (int)NNConfig::NUM_OUTPUTS) {
+        return false;
+    }
+    bool stored = replay.add(features, (int8_t)label);
+    progress.samples = replay.size();
+    return stored;
+}
+
+void NeuralNetworkBikeLock::startBackgroundTraining(uint16_t epochs) {
+    if (!isInitialized || replay.size() == 0 || epochs == 0) {
+        return;
+    }
+    if (!isTrainable()) {
+        LOG_WARN("Weights are read in place, training refused");
+        return;
+    }
+    // A batch the last run left open still counts
+    applyBatch();
+    progress.epoch = 0;
+    progress.epochs = epochs;
+    progress.active = 1;
+    epochPosition = 0;
+    epochSize = 0;
+}
+
+void NeuralNetworkBikeLock::stopBackgroundTraining() {
+    progress.active = 0;
+}
+
+void NeuralNetworkBikeLock::shuffleEpoch() {
+    // Entries added mid-epoch join the next one; FIFO overwrites just swap in the newer sample
+    epochSize = replay.size();
+    for (size_t i = 0; i < epochSize; i++) {
+        order[i] = i;
+    }
+    for (size_t i = epochSize - 1; i > 0; i--) {
+        size_t j = random(i + 1);
+        uint16_t swap = order[i];
+        order[i] = order[j];
+        order[j] = swap;
+    }
+    epochPosition = 0;
+    epochLoss = 0.0f;
+}
+
+bool NeuralNetworkBikeLock::trainSlice(unsigned long budgetUs) {
+    if (!isTraining()) {
+        return false;
+    }
+
+    // Always finishes at least one sample, then checks the budget between samples.
+    // Gradients are summed over BATCH_SIZE shuffled samples and applied once per
+    // batch; a batch the budget cuts short carries on in the next slice.
+    unsigned long start = micros();
+    bool epochDone = false;
+    do {
+        if (epochPosition == 0) {
+            shuffleEpoch();
+        }
+        size_t batchEnd = min(epochPosition - epochPosition % NNConfig::BATCH_SIZE + NNConfig::BATCH_SIZE, epochSize);
+        while (epochPosition < batchEnd) {
+            const ReplayBuffer::Entry& entry = replay[order[epochPosition++]];
+            epochLoss += trainSample(entry.features, entry.label, true);
+            if (micros() - start >= budgetUs) {
+                break;
+            }
+        }
+        if (epochPosition == batchEnd) {
+            applyBatch();
+        }
+        if (epochPosition >= epochSize) {
+            progress.epoch++;
+            progress.loss = epochLoss / epochSize;
+            epochPosition = 0;
+            epochDone = true;
+            LOG_DEBUG("Epoch %u/%u, loss %f", progress.epoch, progress.epochs, progress.loss);
+            if (progress.epoch >= progress.epochs) {
+                progress.active = 0;
+                LOG_INFO("Background training done, loss %f over %u samples", progress.loss, progress.samples);
+            }
+        }
+    } while (isTraining() && !epochDone && micros() - start < budgetUs);
+
+    return epochDone;
 }
 
 NNConfig::TheftClass NeuralNetworkBikeLock::performInference(const float* features) {
     if (!isInitialized) return NNConfig::TheftClass::NO_THEFT;
     
-    float* output = nn->FeedForward(features);
+    const float* output = classify(features);
     
     // Find the highest probability class
     float maxProb = output[0];
@@ -80,7 +408,7 @@ NNConfig::TheftClass NeuralNetworkBikeLock::performInference(const float* featur
 void NeuralNetworkBikeLock::getPredictionProbabilities(const float* features, float* probabilities) {
     if (!isInitialized) return;
     
-    float* output = nn->FeedForward(features);
+    const float* output = classify(features);
     
     // Copy probabilities
     for(int i = 0; i < 3; i++) {
@@ -88,9 +416,182 @@ void NeuralNetworkBikeLock::getPredictionProbabilities(const float* features, fl
     }
 }
 
+void NeuralNetworkBikeLock::getPredictionProbabilitiesBatch(const float* features, size_t count, float* probabilities) {
+    if (!isInitialized) return;
+
+    if (nn && !cascadeEnabled && !(sparseNet && sparseInference)) {
+        nn->FeedForwardBatch(features, count, probabilities);
+        return;
+    }
+    for (size_t i = 0; i < count; i++) {
+        getPredictionProbabilities(&features[i * NNConfig::NUM_INPUTS], &probabilities[i * NNConfig::NUM_OUTPUTS]);
+    }
+}
+
+const char* NeuralNetworkBikeLock::getDotProductBackend() {
+    return SIMD_BACKEND;
+}
+
+size_t NeuralNetworkBikeLock::readWeights(float* buffer, size_t offset, size_t count) {
+    return copyWeights(buffer, offset, count, false);
+}
+
+size_t NeuralNetworkBikeLock::writeWeights(const float* buffer, size_t offset, size_t count) {
+    return copyWeights(const_cast<float*>(buffer), offset, count, true);
+}
+
+size_t NeuralNetworkBikeLock::copyWeights(float* buffer, size_t offset, size_t count, bool toNetwork) {
+    if (!isInitialized || !buffer) return 0;
+    if (toNetwork) {
+        if (!isTrainable()) {
+            LOG_WARN("Weights are read in place, write refused");
+            return 0;
+        }
+        weightsReplaced();
+    }
+
+    if (staticNet) {
+        if (offset >= StaticModel::TOTAL_WEIGHTS) return 0;
+        if (count > StaticModel::TOTAL_WEIGHTS - offset) count = StaticModel::TOTAL_WEIGHTS - offset;
+        if (toNetwork) {
+            memcpy(staticNet->getWeights() + offset, buffer, count * sizeof(float));
+        } else {
+            memcpy(buffer, staticNet->getModel() + offset, count * sizeof(float));
+        }
+        return count;
+    }
+
+    // All layers share one contiguous array in the same order as the flat vector:
+    // nn->weights with REDUCE_RAM_WEIGHTS_LVL2, the library's weight arena without
+    size_t total = 0;
+    for (unsigned int i = 0; i < nn->numberOflayers; i++) {
+        total += nn->layers[i]._numberOfInputs * nn->layers[i]._numberOfOutputs;
+    }
+    if (offset >= total) return 0;
+    if (count > total - offset) count = total - offset;
+    if (toNetwork) {
+        memcpy(flatWeights() + offset, buffer, count * sizeof(float));
+    } else {
+        memcpy(buffer, flatWeights() + offset, count * sizeof(float));
+    }
+    return count;
+}
+
+void NeuralNetworkBikeLock::weightsReplaced() {
+    version++;
+    // Gradients of the old weights do not belong on the new ones
+    dropBatch();
+    if (sparseNet) {
+        // A model from the central replaces the pruned one
+        sparseNet = nullptr;
+        LOG_INFO("Weights written, pruning dropped");
+    }
+}
+
+bool NeuralNetworkBikeLock::beginWeightUpdate() {
+    if (!isInitialized || !NNConfig::STANDBY_WEIGHTS || !isTrainable()) {
+        return false;
+    }
+    // Only allocated while an update is in flight; one cut short is reused by the next
+    if (!standby) {
+        if (staticNet) {
+            standby = new (std::nothrow) float[getTotalWeights()];
+        } else {
+            #if defined(REDUCE_RAM_WEIGHTS_LVL2)
+                standby = new (std::nothrow) float[getTotalWeights()];
+            #endif
+        }
+    }
+    return standby != nullptr;
+}
+
+size_t NeuralNetworkBikeLock::writeWeightUpdate(const float* buffer, size_t offset, size_t count) {
+    if (!standby) {
+        return writeWeights(buffer, offset, count);
+    }
+    size_t total = getTotalWeights();
+    if (!buffer || offset >= total) return 0;
+    if (count > total - offset) count = total - offset;
+    memcpy(standby + offset, buffer, count * sizeof(float));
+    return count;
+}
+
+void NeuralNetworkBikeLock::commitWeightUpdate() {
+    if (!standby) {
+        return;     // Already live
+    }
+    // The standby is freed either way, so two copies only exist during a transfer
+    if (staticNet) {
+        staticNet->setWeights(standby);     // Static array: one copy
+        delete[] standby;
+    } else {
+        #if defined(REDUCE_RAM_WEIGHTS_LVL2)
+            delete[] nn->weights;
+            nn->weights = standby;
+        #endif
+    }
+    standby = nullptr;
+    weightsReplaced();
+}
+
+void NeuralNetworkBikeLock::cancelWeightUpdate() {
+    delete[] standby;
+    standby = nullptr;
+}
+
+bool NeuralNetworkBikeLock::saveSnapshot() {
+    if (!isInitialized || snapshot) {
+        return false;
+    }
+    snapshotModel = readsWeightsInPlace() ? staticNet->getModel() : nullptr;
+    const size_t dense = snapshotModel ? 0 : getTotalWeights();
+    snapshot = new (std::nothrow) float[dense + FirstStageModel::TOTAL_WEIGHTS];
+    if (!snapshot) {
+        LOG_WARN("No RAM for a weight snapshot");
+        return false;
+    }
+    readWeights(snapshot, 0, dense);
+    memcpy(snapshot + dense, firstStage.getModel(), FirstStageModel::TOTAL_WEIGHTS * sizeof(float));
+    snapshotVersion = version;
+    snapshotGateTrained = gateTrained;
+    return true;
+}
+
+void NeuralNetworkBikeLock::restoreSnapshot() {
+    if (!snapshot) {
+        return;
+    }
+    size_t dense = 0;
+    if (snapshotModel) {
+        // Back to reading in place, the RAM copy training made is dropped
+        staticNet->useExternalWeights(snapshotModel);
+    } else {
+        dense = getTotalWeights();
+        memcpy(flatWeights(), snapshot, dense * sizeof(float));
+    }
+    memcpy(firstStage.getWeights(), snapshot + dense, FirstStageModel::TOTAL_WEIGHTS * sizeof(float));
+    if (sparseNet) {
+        sparseNet->refresh(flatWeights());
+    }
+    version = snapshotVersion;
+    gateTrained = snapshotGateTrained;
+    delete[] snapshot;
+    snapshot = nullptr;
+    snapshotModel = nullptr;
+}
+
 bool NeuralNetworkBikeLock::getWeights(float* buffer, size_t length) {
     if (!isInitialized || !buffer) return false;
     
+    if (staticNet) {
+        if (length < StaticModel::TOTAL_WEIGHTS) {
+            LOG_ERROR("Buffer too small for weights");
+            return false;
+        }
+        memcpy(buffer, staticNet->getModel(), StaticModel::TOTAL_WEIGHTS * sizeof(float));
+        return true;
+    }
+
     size_t weightIndex = 0;
     
     for (unsigned int i = 0; i < nn->numberOflayers; i++) {
@@ -100,22 +601,14 @@ bool NeuralNetworkBikeLock::getWeights(float* buffer, size_t length) {
         unsigned int layerWeights = numInputs * numOutputs;
         
         if (weightIndex + layerWeights > length) {
-            Serial.println("Error: Buffer too small for weights");
+            LOG_ERROR("Buffer too small for weights");
             return false;
         }
         
-        #if defined(REDUCE_RAM_WEIGHTS_LVL2)
-            memcpy(&buffer[weightIndex], 
-                   nn->weights + weightIndex, 
-                   layerWeights * sizeof(float));
-            weightIndex += layerWeights;  // Only increment once for REDUCE_RAM_WEIGHTS_LVL2
-        #else
-            for (unsigned int out = 0; out < numOutputs; out++) {
-                for (unsigned int in = 0; in < numInputs; in++) {
-                    buffer[weightIndex++] = nn->layers[i].weights[out][in];
-                }
-            }
-        #endif
+        memcpy(&buffer[weightIndex], 
+               flatWeights() + weightIndex, 
+               layerWeights * sizeof(float));
+        weightIndex += layerWeights;
     }
     
     return true;
@@ -124,60 +617,36 @@ bool NeuralNetworkBikeLock::getWeights(float* buffer, size_t length) {
 
 bool NeuralNetworkBikeLock::updateNetworkWeights(const float* newWeights, size_t length) {
     if (!isInitialized || !newWeights) {
-        Serial.println("Cannot update weights: Network not initialized or invalid weights");
+        LOG_ERROR("Cannot update weights: Network not initialized or invalid weights");
         return false;
     }
     
     // Verify length matches expected total weights
     size_t expectedWeights = getTotalWeights();
     if (length != expectedWeights) {
-        Serial.print("Weight count mismatch. Expected: ");
-        Serial.print(expectedWeights);
-        Serial.print(" Got: ");
-        Serial.println(length);
+        LOG_ERROR("Weight count mismatch. Expected: %u Got: %u", expectedWeights, length);
         return false;
     }
     
-    // Update weights in the network
-    #if defined(REDUCE_RAM_WEIGHTS_LVL2)
-        memcpy(nn->weights, newWeights, length * sizeof(float));
-    #else
-        size_t weightIndex = 0;
-        for (unsigned int i = 0; i < nn->numberOflayers; i++) {
-            for (unsigned int out = 0; out < nn->layers[i]._numberOfOutputs; out++) {
-                for (unsigned int in = 0; in < nn->layers[i]._numberOfInputs; in++) {
-                    nn->layers[i].weights[out][in] = newWeights[weightIndex++];
-                }
-            }
-        }
-    #endif
-    
-    Serial.println("Network weights updated successfully");
+    // Bumps the version like any other write
+    copyWeights(const_cast<float*>(newWeights), 0, length, true);
+    LOG_INFO("Network weights updated successfully");
     return true;
 }
 
 size_t NeuralNetworkBikeLock::getTotalWeights() {
     if (!isInitialized) {
-        Serial.println("Network not initialized in getTotalWeights");
+        LOG_WARN("Network not initialized in getTotalWeights");
         return 0;
     }
     
+    if (staticNet) {
+        return StaticModel::TOTAL_WEIGHTS;
+    }
+
     size_t total = 0;
     for (unsigned int i = 0; i < nn->numberOflayers; i++) {
-        unsigned int layerWeights = nn->layers[i]._numberOfInputs * nn->layers[i]._numberOfOutputs;
-        total += layerWeights;
-        
-        Serial.print("Layer ");
-        Serial.print(i);
-        Serial.print(" weights: ");
-        Serial.print(nn->layers[i]._numberOfInputs);
-        Serial.print(" x ");
-        Serial.print(nn->layers[i]._numberOfOutputs);
-        Serial.print(" = ");
-        Serial.println(layerWeights);
+        total += nn->layers[i]._numberOfInputs * nn->layers[i]._numberOfOutputs;
     }
-    
-    Serial.print("Total weights needed: ");
-    Serial.println(total);
     return total;
 }
\ No newline at end of file
@@ -2,33 +2,174 @@
 #define NEURAL_NETWORK_BIKE_LOCK_H
 
 #include <stddef.h>
+#include <stdint.h>
 #include "Config.h"
+#include "ReplayBuffer.h"
+#include "StaticNetwork.h"
+#include "SparseNetwork.h"
 
 class NeuralNetwork;
 
 class NeuralNetworkBikeLock {
 public:
     NeuralNetworkBikeLock();
-    void init(const unsigned int* layer_, float* weights, const unsigned int& NumberOflayers);
+    // weights: nullptr for random ones. The static backend reads them in place, so they
+    // may be in flash (see ModelStore), until training or a write copies them to RAM.
+    // Without NNConfig::STATIC_WEIGHTS_IN_RAM it never copies them and needs them here.
+    void init(const unsigned int* layer_, const float* weights, const unsigned int& NumberOflayers);
+
+    // NNConfig::LAYERS as a compile-time network for the STATIC backend
+    static constexpr WeightStorage STATIC_STORAGE =
+        NNConfig::STATIC_WEIGHTS_IN_RAM ? WeightStorage::RAM : WeightStorage::IN_PLACE;
+    typedef StaticNetwork<STATIC_STORAGE, NNConfig::LAYERS[0], NNConfig::LAYERS[1], NNConfig::LAYERS[2]> StaticModel;
+    typedef SparseNetwork<NNConfig::SPARSE_CAPACITY, NNConfig::LAYERS[0], NNConfig::LAYERS[1], NNConfig::LAYERS[2]> SparseModel;
+    static_assert(NNConfig::NUM_LAYERS == 3, "StaticModel lists NNConfig::LAYERS one by one");
+    typedef StaticNetwork<WeightStorage::RAM, NNConfig::NUM_INPUTS, NNConfig::CASCADE_HIDDEN, NNConfig::NUM_OUTPUTS>
+        FirstStageModel;
+
+    // Takes effect at init(). STATIC only serves NNConfig::LAYERS and one network
+    // at a time (read in place: with stored weights); init() falls back to DYNAMIC otherwise.
+    void setBackend(NNConfig::Backend backend_) { if (!isInitialized) backend = backend_; }
+    NNConfig::Backend getBackend() const { return backend; }
+    // False for a static network read in place: training, pruning and weight writes are refused
+    bool isTrainable() const { return !staticNet || StaticModel::TRAINABLE; }
     
+    // Served on BLEConfig::TRAINING_CHAR_UUID
+    struct TrainingProgress {
+        uint16_t epoch;         // Epochs finished in the current run
+        uint16_t epochs;        // Epochs the run was started with
+        float loss;             // Mean squared error over the last finished epoch
+        uint16_t samples;       // Entries in the replay buffer
+        uint8_t active;
+        uint8_t reserved;
+    };
+    static_assert(sizeof(TrainingProgress) <= BLEConfig::ATT_MIN_MTU - 3, "TrainingProgress must fit the default MTU");
+
     // Modified training method to accept label
     void performLiveTraining(const float* features, int label);
+
+    // Background training: samples go into the replay buffer, trainSlice() runs
+    // shuffled mini-batch epochs over it for at most budgetUs per call and returns
+    // true when an epoch finished. Starting again restarts the epoch count.
+    bool addTrainingSample(const float* features, int label);
+    void startBackgroundTraining(uint16_t epochs = NNConfig::TRAIN_EPOCHS);
+    void stopBackgroundTraining();
+    bool isTraining() const { return progress.active != 0; }
+    bool trainSlice(unsigned long budgetUs = NNConfig::TRAIN_SLICE_US);
+    const TrainingProgress& getTrainingProgress() const { return progress; }
+    const ReplayBuffer& getReplayBuffer() const { return replay; }
     float getMeanSquaredError(size_t numSamples);
     
+    // Magnitude pruning of the live weights, see SparseModel. Inference then runs
+    // the sparse kernel; training keeps pruned weights at zero and a weight write
+    // from the central drops the pruning. Needs NNConfig::LAYERS and a flat weight
+    // vector. Returns the weights kept, 0 if the network cannot be pruned.
+    size_t prune(float sparsity = NNConfig::PRUNE_SPARSITY);
+    bool isPruned() const { return sparseNet != nullptr; }
+    // Pruned networks only: false runs the dense kernel over the pruned weights
+    void setSparseInference(bool enabled) { sparseInference = enabled; }
+    size_t getInferenceMacs();
+
+    // Cascade counters since the last reset. Ticks are CycleTimer ticks.
+    struct CascadeStats {
+        uint32_t firstStageHits;        // Windows the first stage decided alone
+        uint32_t escalations;           // Windows passed on to the full network
+        uint64_t firstStageTicks;       // Spent in the first stage, every window once it trained
+        uint64_t secondStageTicks;      // Spent in the full network, escalations only
+    };
+    // The first stage trains with every sample the full network does. Enabling the
+    // cascade before it ever trained (e.g. after booting a stored model) trains it
+    // from the replay buffer first; with nothing there every window escalates.
+    void setCascade(bool enabled, float threshold = NNConfig::CASCADE_THRESHOLD);
+    bool isCascadeEnabled() const { return cascadeEnabled; }
+    float getCascadeThreshold() const { return cascadeThreshold; }
+    bool isFirstStageTrained() const { return gateTrained; }
+    const CascadeStats& getCascadeStats() const { return cascade; }
+    void resetCascadeStats();
+
     // Inference methods
     NNConfig::TheftClass performInference(const float* features);
     void getPredictionProbabilities(const float* features, float* probabilities);
+    // count windows at once: features holds count rows of NUM_INPUTS and probabilities
+    // gets count rows of NUM_OUTPUTS. The dynamic dense network runs them as one batch
+    // that reads each weight once per BATCH_TILE windows; the other paths go one by one.
+    void getPredictionProbabilitiesBatch(const float* features, size_t count, float* probabilities);
+    // Dot-product kernel of the dynamic backend's FeedForward, the library's SIMD_BACKEND
+    // ("scalar", "SSE", "AVX2", "NEON", "CMSIS-DSP" or "ESP-DSP"). Only "scalar" sums
+    // in the same order as the batch kernel and the STATIC backend.
+    static const char* getDotProductBackend();
     
     // Weight management
+    // Streaming access to the flat weight vector (layer by layer, output-major):
+    // copy count weights starting at offset, returns how many were copied
+    size_t readWeights(float* buffer, size_t offset, size_t count);
+    size_t writeWeights(const float* buffer, size_t offset, size_t count);
     bool getWeights(float* buffer, size_t length);
     size_t getTotalWeights();
+    // True while inference still reads the weights init() was given, in place
+    bool readsWeightsInPlace() const { return staticNet && staticNet->isExternal(); }
     bool updateNetworkWeights(const float* newWeights, size_t length);
+    // Staged update for weights that arrive in pieces (SET_WEIGHTS): the pieces go to
+    // a standby copy allocated for the update while inference keeps the live weights,
+    // and commitWeightUpdate() switches to it (a pointer swap for the dynamic network,
+    // one copy into the static network's array) and frees what is no longer used.
+    // cancelWeightUpdate() frees it and leaves the network as it was. Without
+    // a standby (NNConfig::STANDBY_WEIGHTS off, no RAM for it, or a dynamic network
+    // without a flat weight vector) the pieces are written live.
+    bool beginWeightUpdate();   // False if the update goes to the live weights
+    size_t writeWeightUpdate(const float* buffer, size_t offset, size_t count);
+    void commitWeightUpdate();
+    void cancelWeightUpdate();
+    // Bumped whenever training or a write changes the weights, starts at 1
+    uint32_t getVersion() const { return version; }
+    // Training benchmarks: restoreSnapshot() puts back the weights, pruning and version
+    // saveSnapshot() saw, so timed training steps leave the deployed model as it was.
+    // Weights read in place are only remembered, RAM weights are copied to the heap;
+    // false if that copy does not fit.
+    bool saveSnapshot();
+    void restoreSnapshot();
     
 private:
+    size_t copyWeights(float* buffer, size_t offset, size_t count, bool toNetwork);
+    void weightsReplaced();
+    const float* classify(const float* features);
+    const float* feedForward(const float* features);
+    const float* denseFeedForward(const float* features);
+    float* flatWeights();
+    // accumulate: add to the running mini-batch instead of an SGD step
+    float trainSample(const float* features, int label, bool accumulate);
+    void applyBatch();
+    void dropBatch();
+    void shuffleEpoch();
+    void trainFirstStage();
+
     NeuralNetwork* nn;
+    StaticModel* staticNet;
+    SparseModel* sparseNet;
+    float* standby;             // Weights of the update in flight, nullptr otherwise
+    float* snapshot;            // Dense (unless read in place) then first-stage weights
+    const float* snapshotModel; // In-place weights at saveSnapshot(), nullptr if copied
+    uint32_t snapshotVersion;
+    bool snapshotGateTrained;
+    bool sparseInference;
+    FirstStageModel firstStage;
+    bool cascadeEnabled;
+    float cascadeThreshold;
+    bool gateTrained;           // The first stage trained at least once since init()
+    CascadeStats cascade;
+    NNConfig::Backend backend;
     unsigned int* layers;
     unsigned int numLayers;
     bool isInitialized;
+    uint32_t version;
+
+    ReplayBuffer replay;
+    TrainingProgress progress;
+    uint16_t order[NNConfig::REPLAY_CAPACITY];  // Shuffled replay indices of the running epoch
+    size_t epochSize;                           // Replay entries the running epoch covers
+    size_t epochPosition;
+    float epochLoss;
+    size_t batchSamples;                        // Accumulated since the last applyBatch()
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,33 @@
+#include <Arduino.h>
+#include "ReplayBuffer.h"
+
+ReplayBuffer::ReplayBuffer() : count(0), next(0), seen(0) {
+}
+
+bool ReplayBuffer::add(const float* features, int8_t label) {
+    size_t slot;
+    if (count < NNConfig::REPLAY_CAPACITY) {
+        slot = count++;
+    } else if (NNConfig::REPLAY_EVICTION == NNConfig::ReplayEviction::RESERVOIR) {
+        // Algorithm R: keep the new sample with probability capacity / seen
+        slot = random(seen + 1);
+        if (slot >= NNConfig::REPLAY_CAPACITY) {
+            seen++;
+            return false;
+        }
+    } else {
+        slot = next;
+        next = (next + 1) % NNConfig::REPLAY_CAPACITY;
+    }
+    seen++;
+
+    memcpy(entries[slot].features, features, sizeof(entries[slot].features));
+    entries[slot].label = label;
+    return true;
+}
+
+void ReplayBuffer::clear() {
+    count = 0;
+    next = 0;
+    seen = 0;
+}
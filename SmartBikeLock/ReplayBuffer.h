@@ -0,0 +1,32 @@
+#ifndef REPLAY_BUFFER_H
+#define REPLAY_BUFFER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "Config.h"
+
+// Bounded store of labelled feature vectors the background trainer replays.
+// Once full, NNConfig::REPLAY_EVICTION decides which entry a new sample replaces.
+class ReplayBuffer {
+public:
+    struct Entry {
+        float features[NNConfig::NUM_INPUTS];
+        int8_t label;
+    };
+
+    ReplayBuffer();
+    // Returns false if reservoir sampling dropped the sample
+    bool add(const float* features, int8_t label);
+    void clear();
+    size_t size() const { return count; }
+    uint32_t getSeen() const { return seen; }
+    const Entry& operator[](size_t index) const { return entries[index]; }
+
+private:
+    Entry entries[NNConfig::REPLAY_CAPACITY];
+    size_t count;
+    size_t next;        // FIFO: slot the next sample overwrites
+    uint32_t seen;      // Samples offered since the last clear()
+};
+
+#endif
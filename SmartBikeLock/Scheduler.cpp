@@ -0,0 +1,118 @@
+#include <Arduino.h>
+#include "Scheduler.h"
+
+Scheduler::Scheduler(Clock clock_) : clock(clock_), taskCount(0) {
+}
+
+int Scheduler::add(const char* name, TaskFunction function, unsigned long periodUs,
+                   unsigned long budgetUs, unsigned long deadlineUs) {
+    if (taskCount >= SchedulerConfig::MAX_TASKS || !function) {
+        return INVALID_TASK;
+    }
+    Task& task = tasks[taskCount];
+    task.name = name;
+    task.function = function;
+    task.periodUs = periodUs;
+    task.budgetUs = budgetUs;
+    task.deadlineUs = deadlineUs;
+    task.releaseUs = clock();
+    task.pending = false;
+    memset(&task.stats, 0, sizeof(task.stats));
+    return taskCount++;
+}
+
+int Scheduler::addPeriodic(const char* name, TaskFunction function, unsigned long periodUs,
+                           unsigned long budgetUs, unsigned long deadlineUs) {
+    if (periodUs == 0) {
+        return INVALID_TASK;
+    }
+    return add(name, function, periodUs, budgetUs, deadlineUs ? deadlineUs : periodUs);
+}
+
+int Scheduler::addEvent(const char* name, TaskFunction function, unsigned long budgetUs, unsigned long deadlineUs) {
+    return add(name, function, 0, budgetUs, deadlineUs);
+}
+
+void Scheduler::trigger(int task) {
+    if (task < 0 || (size_t)task >= taskCount || tasks[task].periodUs != 0 || tasks[task].pending) {
+        return;
+    }
+    tasks[task].pending = true;
+    tasks[task].releaseUs = clock();
+}
+
+bool Scheduler::isPending(int task) const {
+    return task >= 0 && (size_t)task < taskCount && tasks[task].pending;
+}
+
+void Scheduler::release(unsigned long now) {
+    for (size_t i = 0; i < taskCount; i++) {
+        Task& task = tasks[i];
+        if (task.periodUs == 0 || task.pending || (long)(now - task.releaseUs) < 0) {
+            continue;
+        }
+        // Releases that went by while the task was still behind are dropped, not queued
+        unsigned long late = now - task.releaseUs;
+        if (late >= task.periodUs) {
+            unsigned long skipped = late / task.periodUs;
+            task.stats.skippedReleases += skipped;
+            task.releaseUs += skipped * task.periodUs;
+        }
+        task.pending = true;
+    }
+}
+
+bool Scheduler::runOnce() {
+    unsigned long now = clock();
+    release(now);
+
+    // Earliest deadline first
+    Task* next = nullptr;
+    long nextSlack = 0;
+    for (size_t i = 0; i < taskCount; i++) {
+        Task& task = tasks[i];
+        if (!task.pending) {
+            continue;
+        }
+        long slack = (long)(task.releaseUs + task.deadlineUs - now);
+        if (!next || slack < nextSlack) {
+            next = &task;
+            nextSlack = slack;
+        }
+    }
+    if (!next) {
+        return false;
+    }
+
+    unsigned long deadline = next->releaseUs + next->deadlineUs;
+    next->pending = false;
+    if (next->periodUs != 0) {
+        next->releaseUs += next->periodUs;
+    }
+
+    unsigned long start = clock();
+    next->function();
+    unsigned long end = clock();
+
+    TaskStats& stats = next->stats;
+    uint32_t elapsed = end - start;
+    stats.runs++;
+    stats.lastUs = elapsed;
+    stats.totalUs += elapsed;
+    if (elapsed > stats.maxUs) {
+        stats.maxUs = elapsed;
+    }
+    if (next->budgetUs != 0 && elapsed > next->budgetUs) {
+        stats.overruns++;
+    }
+    if ((long)(end - deadline) > 0) {
+        stats.deadlineMisses++;
+    }
+    return true;
+}
+
+void Scheduler::resetStats() {
+    for (size_t i = 0; i < taskCount; i++) {
+        memset(&tasks[i].stats, 0, sizeof(tasks[i].stats));
+    }
+}
@@ -0,0 +1,75 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "Config.h"
+
+// Cooperative run-to-completion scheduler. Periodic tasks are released every
+// period, event tasks whenever trigger() is called; each release gets an absolute
+// deadline of release time + deadline. runOnce() runs the released task with the
+// earliest deadline (table order breaks ties) and returns, so loop() stays short.
+//
+// Every run is timed: longer than the task's budget counts as an overrun, finishing
+// after the deadline as a deadline miss. Times are microseconds from the clock
+// passed in, micros() on the board or a virtual clock on the host; differences are
+// wrap-safe.
+class Scheduler {
+public:
+    typedef void (*TaskFunction)();
+    typedef unsigned long (*Clock)();
+
+    struct TaskStats {
+        uint32_t runs;
+        uint32_t overruns;          // Runs longer than the budget
+        uint32_t deadlineMisses;    // Runs that finished after their deadline
+        uint32_t skippedReleases;   // Periodic releases dropped because the task was still behind
+        uint32_t lastUs;
+        uint32_t maxUs;
+        uint32_t totalUs;
+    };
+
+    static constexpr int INVALID_TASK = -1;
+
+    explicit Scheduler(Clock clock_);
+
+    // budgetUs 0 means no budget (blocking diagnostics); deadlineUs 0 defaults to
+    // the period for periodic tasks. Both return INVALID_TASK when the table is full.
+    int addPeriodic(const char* name, TaskFunction function, unsigned long periodUs,
+                    unsigned long budgetUs, unsigned long deadlineUs = 0);
+    int addEvent(const char* name, TaskFunction function, unsigned long budgetUs, unsigned long deadlineUs);
+
+    // Releases an event task; a release that is still pending keeps its deadline
+    void trigger(int task);
+    bool isPending(int task) const;
+
+    // Runs at most one task; false if nothing was released (idle)
+    bool runOnce();
+
+    size_t getTaskCount() const { return taskCount; }
+    const char* getName(int task) const { return tasks[task].name; }
+    const TaskStats& getStats(int task) const { return tasks[task].stats; }
+    void resetStats();
+
+private:
+    struct Task {
+        const char* name;
+        TaskFunction function;
+        unsigned long periodUs;     // 0: event task
+        unsigned long budgetUs;
+        unsigned long deadlineUs;
+        unsigned long releaseUs;    // Next release (periodic) or pending release (event)
+        bool pending;
+        TaskStats stats;
+    };
+
+    int add(const char* name, TaskFunction function, unsigned long periodUs,
+            unsigned long budgetUs, unsigned long deadlineUs);
+    void release(unsigned long now);
+
+    Clock clock;
+    Task tasks[SchedulerConfig::MAX_TASKS];
+    size_t taskCount;
+};
+
+#endif
@@ -1,21 +1,35 @@
 #include "SignalProcessing.h"
 
-const float SignalProcessing::freqBands[SignalConfig::FEATURE_BINS + 1] PROGMEM = {0, 6, 12, 19, 25, 31, 37, 44, 50};
-
 SignalProcessing::SignalProcessing() 
-    : FFT(vReal, vImag, SignalConfig::SAMPLES, SignalConfig::SAMPLING_FREQ), millisOld(0) {
+    : FFT(vReal, nullptr, SignalConfig::SAMPLES, SignalConfig::SAMPLING_FREQ), millisOld(0), windowEndMs(0),
+      ringHead(0), ringFill(0), samplesSinceWindow(0), nextSampleMs(0), heldSamples(0), continuous(false), windowInRing(false),
+      motionEnergy(0), noiseFloor(SignalConfig::MOTION_FLOOR_INITIAL), windowsChecked(0), windowsSkipped(0),
+      engine(SignalConfig::DEFAULT_FEATURE_ENGINE) {
     // Initialize arrays
     for(int i = 0; i < SignalConfig::SAMPLES; i++) {
         vReal[i] = 0;
-        vImag[i] = 0;
+        window[i] = 0;
+        ring[i] = 0;
+    }
+    for(unsigned int i = 0; i < SignalConfig::SAMPLES / 2; i++) {
+        spectrumQ15[i] = 0;
     }
     for(int i = 0; i < SignalConfig::TOTAL_FEATURES; i++) {
         features[i] = 0;
     }
 }
 
+int16_t SignalProcessing::readSample(int16_t previous) {
+    // Raw counts: half the buffer size of float, and converted to m/s^2 only
+    // where a float engine needs it (SignalConfig::ACCEL_MS2_PER_COUNT)
+    int16_t x, y, z;
+    if (IMU.accelerationAvailable() && IMU.readRawAcceleration(x, y, z)) {
+        return x;
+    }
+    return previous;
+}
+
 bool SignalProcessing::collectData() {
-    float x, y, z;
     millisOld = millis();
     
     // Data Collection
@@ -23,23 +37,155 @@ bool SignalProcessing::collectData() {
         while((millis() - millisOld) < SignalConfig::SAMPLING_PERIOD_MS);
         millisOld = millis();
         
-        if (IMU.accelerationAvailable()) {
-            IMU.readAcceleration(x, y, z);
-            vReal[i] = x * 9.81; // Convert to m/s^2
+        window[i] = readSample((i > 0) ? window[i-1] : 0);
+    }
+    windowEndMs = millisOld;
+    windowInRing = false;
+    return true;
+}
+
+void SignalProcessing::startContinuous() {
+    // Ring and sliding DFT must start from the same (all-zero) window
+    for(unsigned int i = 0; i < SignalConfig::SAMPLES; i++) {
+        ring[i] = 0;
+    }
+    sdft.reset();
+    ringHead = 0;
+    ringFill = 0;
+    samplesSinceWindow = 0;
+    heldSamples = 0;
+    nextSampleMs = millis();
+    continuous = true;
+}
+
+void SignalProcessing::stopContinuous() {
+    continuous = false;
+}
+
+void SignalProcessing::setFeatureEngine(SignalConfig::FeatureEngine engine_) {
+    engine = engine_;
+    if (continuous) {
+        startContinuous();
+    }
+}
+
+bool SignalProcessing::update() {
+    if (!continuous) return false;
+
+    const bool sliding = (engine == SignalConfig::FeatureEngine::SLIDING_DFT);
+    const unsigned int hop = sliding ? SignalConfig::SDFT_DECISION_HOP : SignalConfig::HOP_SIZE;
+    bool windowReady = false;
+    bool sampledThisPass = false;
+    unsigned long now = millis();
+
+    // Take every sample whose slot has passed. Slots advance by a fixed period so the
+    // sample clock does not drift; slots missed while the loop was busy repeat the last
+    // value to keep the time base the FFT bands rely on.
+    while ((long)(now - nextSampleMs) >= 0) {
+        int16_t previous = ring[(ringHead + SignalConfig::SAMPLES - 1) % SignalConfig::SAMPLES];
+        int16_t oldest = ring[ringHead];
+        if (sampledThisPass) {
+            ring[ringHead] = previous;
+            heldSamples++;
         } else {
-            vReal[i] = (i > 0) ? vReal[i-1] : 0;
+            ring[ringHead] = readSample(previous);
+            sampledThisPass = true;
+        }
+        if (sliding) {
+            sdft.push(ring[ringHead] * SignalConfig::ACCEL_MS2_PER_COUNT, oldest * SignalConfig::ACCEL_MS2_PER_COUNT);
+        }
+        ringHead = (ringHead + 1) % SignalConfig::SAMPLES;
+        if (ringFill < SignalConfig::SAMPLES) ringFill++;
+        nextSampleMs += SignalConfig::SAMPLING_PERIOD_MS;
+
+        if (++samplesSinceWindow >= hop && ringFill == SignalConfig::SAMPLES) {
+            samplesSinceWindow = 0;
+            windowReady = true;
+            windowEndMs = nextSampleMs - SignalConfig::SAMPLING_PERIOD_MS;   // Slot of the newest sample
         }
-        vImag[i] = 0;
     }
-    return true;
+
+    if (windowReady) {
+        // The sliding DFT already holds this window's features and the motion
+        // gate reads the ring in place, so only the whole-window engines copy it
+        windowInRing = sliding;
+        if (!sliding) {
+            copyWindow();
+        }
+    }
+    return windowReady;
+}
+
+void SignalProcessing::copyWindow() {
+    // Unroll the ring oldest-first into the window
+    for(unsigned int i = 0; i < SignalConfig::SAMPLES; i++) {
+        window[i] = ring[(ringHead + i) % SignalConfig::SAMPLES];
+    }
+}
+
+bool SignalProcessing::detectMotion() {
+    // Raw samples are in window, except for a sliding DFT window which never leaves
+    // the ring. Order does not matter for the RMS.
+    const int16_t* samples = windowInRing ? ring : window;
+
+    // RMS around the window mean: gravity and a tilted mount are DC and drop out.
+    // Integer sums are exact, so n^2 * variance = n * s2 - s1^2 needs no conditioning.
+    int32_t s1 = 0;
+    int64_t s2 = 0;
+    for(unsigned int i = 0; i < SignalConfig::SAMPLES; i++) {
+        int32_t v = samples[i];
+        s1 += v;
+        s2 += v * v;
+    }
+    int64_t spread = (int64_t)SignalConfig::SAMPLES * s2 - (int64_t)s1 * s1;
+    motionEnergy = sqrt((float)spread) * (SignalConfig::ACCEL_MS2_PER_COUNT / SignalConfig::SAMPLES);
+
+    windowsChecked++;
+    if (!SignalConfig::MOTION_GATE_ENABLED) return true;
+
+    bool moving = motionEnergy > SignalConfig::MOTION_GATE_RATIO * noiseFloor;
+    if (!moving) {
+        // Only quiet windows move the floor, so sustained motion can't raise it
+        noiseFloor += SignalConfig::MOTION_FLOOR_ALPHA * (motionEnergy - noiseFloor);
+        noiseFloor = constrain(noiseFloor, SignalConfig::MOTION_FLOOR_MIN, SignalConfig::MOTION_FLOOR_MAX);
+        windowsSkipped++;
+    }
+    return moving;
+}
+
+void SignalProcessing::getStationaryProbabilities(float* probabilities) const {
+    // 1.0 for a window at or below the floor, falling to 0.5 at the gate threshold
+    float activity = motionEnergy / (SignalConfig::MOTION_GATE_RATIO * noiseFloor);
+    float confidence = 1.0f - 0.5f * constrain(activity, 0.0f, 1.0f);
+    probabilities[static_cast<int>(NNConfig::TheftClass::NO_THEFT)] = confidence;
+    probabilities[static_cast<int>(NNConfig::TheftClass::CARRYING_AWAY)] = 0.5f * (1.0f - confidence);
+    probabilities[static_cast<int>(NNConfig::TheftClass::LOCK_BREACH)] = 0.5f * (1.0f - confidence);
 }
 
 void SignalProcessing::processData() {
+    if (windowInRing && engine == SignalConfig::FeatureEngine::SLIDING_DFT) {
+        // Features were kept up to date sample by sample
+        sdft.features(features);
+        return;
+    }
+
+    if (engine == SignalConfig::FeatureEngine::FIXED_Q15) {
+        // Magnitudes come back in counts x 2^exponent; float starts at the features
+        int exponent = fixedFft.magnitudes(window, spectrumQ15);
+        Plan::extractFixed(spectrumQ15, ldexpf(SignalConfig::ACCEL_MS2_PER_COUNT, exponent), features);
+        return;
+    }
+
+    for(unsigned int i = 0; i < SignalConfig::SAMPLES; i++) {
+        vReal[i] = window[i] * SignalConfig::ACCEL_MS2_PER_COUNT;
+    }
+
     // FFT Processing
     FFT.dcRemoval();
     FFT.windowing(FFTWindow::Hamming, FFTDirection::Forward);
-    FFT.compute(FFTDirection::Forward);
-    FFT.complexToMagnitude();
+    // Input is real, so a half-size complex FFT is enough
+    FFT.computeReal();
+    FFT.complexToMagnitudeReal();
     
     extractFeatures();
 }
@@ -49,35 +195,6 @@ bool SignalProcessing::begin() {
 }
 
 void SignalProcessing::extractFeatures() {
-    // Calculate frequency bin energies
-    for(int bin = 0; bin < SignalConfig::FEATURE_BINS; bin++) {
-        float binEnergy = 0;
-        int startIndex = (pgm_read_float(&freqBands[bin]) * SignalConfig::SAMPLES) / SignalConfig::SAMPLING_FREQ;
-        int endIndex = (pgm_read_float(&freqBands[bin + 1]) * SignalConfig::SAMPLES) / SignalConfig::SAMPLING_FREQ;
-        
-        for(int i = startIndex; i < endIndex; i++) {
-            binEnergy += vReal[i];
-        }
-        features[bin] = binEnergy / (endIndex - startIndex);
-    }
-    
-    // Calculate statistical features
-    float mean = 0, maxVal = 0;
-    for(int i = 0; i < SignalConfig::SAMPLES/2; i++) {
-        mean += vReal[i];
-        if(vReal[i] > maxVal) maxVal = vReal[i];
-    }
-    mean /= (SignalConfig::SAMPLES/2);
-    
-    float variance = 0;
-    for(int i = 0; i < SignalConfig::SAMPLES/2; i++) {
-        float diff = vReal[i] - mean;
-        variance += diff * diff;
-    }
-    variance /= (SignalConfig::SAMPLES/2);
-    
-    // Store statistical features
-    features[SignalConfig::FEATURE_BINS] = mean;
-    features[SignalConfig::FEATURE_BINS + 1] = maxVal;
-    features[SignalConfig::FEATURE_BINS + 2] = sqrt(variance);
-}
\ No newline at end of file
+    // Band sums and mean/max/std in one pass, boundaries fixed at compile time
+    Plan::extract(vReal, features);
+}
@@ -4,25 +4,82 @@
 #include "arduinoFFT.h"
 #include <Arduino_LSM9DS1.h>
 #include "Config.h"
+#include "SlidingDFT.h"
+#include "FixedPointFFT.h"
+#include "FeaturePlan.h"
 
 class SignalProcessing {
 public:
     SignalProcessing();
-    
+
     bool begin();
     bool collectData();
     void processData();
     const float* getFeatures() const { return features; }
-    
+    // millis() slot of the newest sample in the last collected or ready window
+    unsigned long getWindowEndMs() const { return windowEndMs; }
+
+    // Continuous acquisition: update() must be called every loop pass. It takes
+    // every sample that is due into the ring buffer and returns true when a new
+    // window (SAMPLES long, every HOP_SIZE samples) has been copied for processData().
+    void startContinuous();
+    void stopContinuous();
+    bool isContinuous() const { return continuous; }
+    bool update();
+    unsigned long getHeldSamples() const { return heldSamples; }
+
+    // Motion gate, call after collectData() or a ready update() and before processData().
+    // Returns false if the raw window is indistinguishable from sensor noise; the caller can
+    // then report getStationaryProbabilities() instead of running FFT and inference.
+    bool detectMotion();
+    void getStationaryProbabilities(float* probabilities) const;
+    float getMotionEnergy() const { return motionEnergy; }
+    float getNoiseFloor() const { return noiseFloor; }
+    unsigned long getWindowsChecked() const { return windowsChecked; }
+    unsigned long getWindowsSkipped() const { return windowsSkipped; }
+
+    // SLIDING_DFT updates the spectrum and features per sample in update() and makes
+    // a window ready every SDFT_DECISION_HOP samples; it needs continuous mode and
+    // falls back to the FFT for a collectData() window. FIXED_Q15
+    // stays in integers from the raw counts to the features. The whole-window
+    // engines leave the raw window as it is, so processData() can be run again
+    // with another engine.
+    void setFeatureEngine(SignalConfig::FeatureEngine engine_);
+    SignalConfig::FeatureEngine getFeatureEngine() const { return engine; }
+
 private:
     ArduinoFFT<float> FFT;
     float vReal[SignalConfig::SAMPLES];
-    float vImag[SignalConfig::SAMPLES];
+    int16_t window[SignalConfig::SAMPLES];    // Raw accelerometer counts, oldest first
     float features[SignalConfig::TOTAL_FEATURES];
     unsigned long millisOld;
-    
-    static const float freqBands[SignalConfig::FEATURE_BINS + 1] PROGMEM;
+    unsigned long windowEndMs;
+
+    // Continuous mode state
+    int16_t ring[SignalConfig::SAMPLES];      // Raw counts
+    unsigned int ringHead;            // Next write position (oldest sample once full)
+    unsigned int ringFill;            // Valid samples in ring, saturates at SAMPLES
+    unsigned int samplesSinceWindow;
+    unsigned long nextSampleMs;
+    unsigned long heldSamples;        // Samples repeated because the loop was late or IMU had no data
+    bool continuous;
+    bool windowInRing;                // Last ready window is a sliding DFT one, held in ring
+
+    // Motion gate state
+    float motionEnergy;               // AC RMS of the last checked window (m/s^2)
+    float noiseFloor;
+    unsigned long windowsChecked;
+    unsigned long windowsSkipped;
+
+    SlidingDFT sdft;
+    FixedPointFFT fixedFft;
+    uint16_t spectrumQ15[SignalConfig::SAMPLES / 2];
+    SignalConfig::FeatureEngine engine;
+
+    typedef FeaturePlan<SignalConfig::SAMPLES, SignalConfig::SAMPLING_FREQ, SignalConfig::FreqBands> Plan;
+    int16_t readSample(int16_t previous);
+    void copyWindow();
     void extractFeatures();
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,93 @@
+#include "SlidingDFT.h"
+
+SlidingDFT::SlidingDFT() {
+    const float r = SignalConfig::SDFT_DAMPING;
+    dampN = pow(r, SignalConfig::SAMPLES);
+
+    for(unsigned int k = 0; k < NUM_BINS; k++) {
+        double theta = 2.0 * PI * k / SignalConfig::SAMPLES;
+        cosK[k] = cos(theta);
+        sinK[k] = sin(theta);
+        twRe[k] = r * cosK[k];
+        twIm[k] = r * sinK[k];
+    }
+    reset();
+}
+
+void SlidingDFT::reset() {
+    for(unsigned int k = 0; k < NUM_BINS; k++) {
+        re[k] = 0;
+        im[k] = 0;
+    }
+    for(unsigned int band = 0; band < Plan::NUM_BANDS; band++) {
+        bandMean[band] = 0;
+    }
+    mean = 0;
+    maxVal = 0;
+    stdDev = 0;
+}
+
+void SlidingDFT::push(float newest, float oldest) {
+    // X_k(n) = e^(j*2*pi*k/N) * (r * X_k(n-1) + x[n] - r^N * x[n-N])
+    // Bin 0 is skipped: the FFT path removes DC before windowing.
+    const float delta = newest - dampN * oldest;
+    for(unsigned int k = 1; k < NUM_BINS; k++) {
+        float r0 = re[k];
+        float i0 = im[k];
+        re[k] = twRe[k] * r0 - twIm[k] * i0 + cosK[k] * delta;
+        im[k] = twIm[k] * r0 + twRe[k] * i0 + sinK[k] * delta;
+    }
+    updateStatistics();
+}
+
+float SlidingDFT::windowedMagnitude(unsigned int k) const {
+    // Hamming applied in the frequency domain: Xw[k] = 0.54 X[k] - 0.23 (X[k-1] + X[k+1]).
+    // X[0] is zero after DC removal and X[-1] = conj(X[1]) for a real signal.
+    if (k == 0) {
+        return fabs(0.46f * re[1]);
+    }
+    float wr = 0.54f * re[k] - 0.23f * ((k > 1 ? re[k - 1] : 0) + re[k + 1]);
+    float wi = 0.54f * im[k] - 0.23f * ((k > 1 ? im[k - 1] : 0) + im[k + 1]);
+    return sqrt(wr * wr + wi * wi);
+}
+
+void SlidingDFT::updateStatistics() {
+    static_assert(Plan::bandStart(0) == 0 && Plan::bandStart(Plan::NUM_BANDS) == Plan::SPECTRUM_BINS,
+                  "Frequency bands must tile the spectrum");
+    constexpr float invBins = 1.0f / Plan::SPECTRUM_BINS;
+
+    // The spectrum moves little between samples, so the previous mean keeps
+    // s2 - s1^2/n well conditioned in float
+    const float shift = mean;
+    float s1 = 0, s2 = 0, peak = 0;
+    unsigned int k = 0;
+    for(unsigned int band = 0; band < Plan::NUM_BANDS; band++) {
+        const unsigned int end = Plan::bandStart(band + 1);
+        const unsigned int count = end - Plan::bandStart(band);
+        float sum = 0;
+        for(; k < end; k++) {
+            float v = windowedMagnitude(k);
+            float d = v - shift;
+            sum += v;
+            s1 += d;
+            s2 += d * d;
+            peak = (v > peak) ? v : peak;
+        }
+        bandMean[band] = sum / count;
+    }
+
+    const float meanShift = s1 * invBins;
+    const float variance = s2 * invBins - meanShift * meanShift;
+    mean = shift + meanShift;
+    maxVal = peak;
+    stdDev = sqrt(variance > 0 ? variance : 0);
+}
+
+void SlidingDFT::features(float* out) const {
+    for(unsigned int band = 0; band < Plan::NUM_BANDS; band++) {
+        out[band] = bandMean[band];
+    }
+    out[Plan::NUM_BANDS] = mean;
+    out[Plan::NUM_BANDS + 1] = maxVal;
+    out[Plan::NUM_BANDS + 2] = stdDev;
+}
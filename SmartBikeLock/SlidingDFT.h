@@ -0,0 +1,45 @@
+#ifndef SLIDING_DFT_H
+#define SLIDING_DFT_H
+
+#include <Arduino.h>
+#include "Config.h"
+#include "FeaturePlan.h"
+
+// Damped sliding DFT over the last SAMPLES samples. Each push() updates bins
+// 1..SAMPLES/2 in O(bins) and, in a second O(bins) pass, the band means and
+// mean/max/std of the magnitude spectrum the FFT path (dcRemoval + Hamming +
+// complexToMagnitude) would produce, so a feature vector is ready after every sample.
+class SlidingDFT {
+public:
+    SlidingDFT();
+
+    void reset();
+    // newest enters the window, oldest is the sample leaving it (x[n - SAMPLES])
+    void push(float newest, float oldest);
+    // Copies the TOTAL_FEATURES features as of the last push()
+    void features(float* out) const;
+
+private:
+    typedef FeaturePlan<SignalConfig::SAMPLES, SignalConfig::SAMPLING_FREQ, SignalConfig::FreqBands> Plan;
+    // Bin SAMPLES/2 is only kept as the right neighbour for the Hamming taps
+    static constexpr unsigned int NUM_BINS = SignalConfig::SAMPLES / 2 + 1;
+
+    float re[NUM_BINS];
+    float im[NUM_BINS];
+    float twRe[NUM_BINS];   // r * cos(2*pi*k/N)
+    float twIm[NUM_BINS];   // r * sin(2*pi*k/N)
+    float cosK[NUM_BINS];
+    float sinK[NUM_BINS];
+    float dampN;            // r^N, applied to the sample leaving the window
+
+    // Running features, refreshed by every push()
+    float bandMean[Plan::NUM_BANDS];
+    float mean;             // Also the shift for the next push's sums
+    float maxVal;
+    float stdDev;
+
+    float windowedMagnitude(unsigned int k) const;
+    void updateStatistics();
+};
+
+#endif
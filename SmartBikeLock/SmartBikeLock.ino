@@ -1,143 +1,325 @@
 #include "Communication.h"
 #include "NeuralNetworkBikeLock.h"
 #include "SignalProcessing.h"
-//#include "TimingBenchmark.h"
-
-#define DEBUG // Uncomment this line if you want debug messages
+#include "TimingBenchmark.h"
+#include "Scheduler.h"
+#include "ModelStore.h"
+#include "Log.h"
 
 Communication bleComm;
 NeuralNetworkBikeLock NN;
 SignalProcessing signalProc;
-//TimingBenchmark benchmark(NN, signalProc);
+TimingBenchmark benchmark(NN, signalProc);
+Scheduler scheduler(micros);
+ModelStore modelStore;
+
+// Command the tasks below are working on; changes are picked up by serviceBle()
+Command activeCommand = Command::NONE;
+Command windowCommand = Command::NONE;      // Command the window handed to DSP was sampled for
+float probabilities[3];
+
+int dspTask;
+int inferenceTask;
+int benchmarkTask;
+int maintenanceTask;
+
+bool isBenchmark(Command command) {
+    return command == Command::START_INFERENCE_BENCHMARK || command == Command::START_TRAINING_BENCHMARK;
+}
+
+bool isTransfer(Command command) {
+    return command == Command::GET_WEIGHTS || command == Command::GET_WEIGHT_DELTA ||
+           command == Command::SET_WEIGHTS;
+}
+
+// With a standby weight copy, SET_WEIGHTS during continuous classification runs
+// alongside it: windows are classified on the live weights until the switch
+bool isBackgroundUpload(Command command) {
+    return NNConfig::STANDBY_WEIGHTS && command == Command::SET_WEIGHTS &&
+           activeCommand == Command::START_CONTINUOUS_CLASSIFICATION;
+}
+
+void finishCommand() {
+    bleComm.resetState();
+    activeCommand = Command::NONE;
+}
+
+// BLE task: keeps the link serviced and starts whatever the central wrote
+void serviceBle() {
+    bleComm.update();
+    Command command = bleComm.getCurrentCommand();
+    if (command == activeCommand || isBackgroundUpload(command)) {
+        return;
+    }
+
+    // A training benchmark puts the weights back the way they were
+    if (benchmark.isRunning()) {
+        benchmark.abort();
+        LOG_INFO("Benchmark aborted");
+    }
+    // Any other command ends continuous classification or a pending window
+    if (signalProc.isContinuous()) {
+        signalProc.stopContinuous();
+        if (activeCommand == Command::START_CONTINUOUS_CLASSIFICATION) {
+            bleComm.flushPredictions();
+            LOG_INFO("Continuous classification stopped");
+        }
+    }
+    activeCommand = command;
+
+    switch (command) {
+        case Command::START_CLASSIFICATION:
+            LOG_INFO("Starting classification...");
+            signalProc.startContinuous();
+            break;
+        case Command::START_CONTINUOUS_CLASSIFICATION:
+            LOG_INFO("Starting continuous classification...");
+            signalProc.startContinuous();
+            break;
+        case Command::START_TRAINING:
+            LOG_INFO("Starting training...");
+            signalProc.startContinuous();
+            break;
+        case Command::SET_FEATURE_ENGINE:
+            signalProc.setFeatureEngine(bleComm.getFeatureEngine());
+            LOG_INFO("Feature engine %u selected", static_cast<unsigned>(signalProc.getFeatureEngine()));
+            finishCommand();
+            break;
+        case Command::GET_CASCADE_STATS:
+            bleComm.sendCascadeReport(NN);
+            finishCommand();
+            break;
+        case Command::START_INFERENCE_BENCHMARK:
+        case Command::START_TRAINING_BENCHMARK:
+            // Sampled like a classification window, then timed by the benchmark task
+            signalProc.startContinuous();
+            break;
+        case Command::PRUNE_WEIGHTS:
+        case Command::SAVE_WEIGHTS:
+        case Command::SET_CASCADE:
+            scheduler.trigger(maintenanceTask);
+            break;
+        default:
+            // Weight transfers are driven by the transfer task
+            break;
+    }
+}
+
+// Acquisition task: one sample slot per period. Single-shot commands sample one
+// full window the same way continuous mode does, so nothing blocks for SAMPLES periods.
+void acquire() {
+    if (!signalProc.isContinuous() || !signalProc.update()) {
+        return;
+    }
+    if (activeCommand != Command::START_CONTINUOUS_CLASSIFICATION) {
+        signalProc.stopContinuous();
+    }
+    windowCommand = activeCommand;
+    scheduler.trigger(isBenchmark(windowCommand) ? benchmarkTask : dspTask);
+}
+
+void publishPrediction() {
+    bleComm.sendPrediction(probabilities, 3, signalProc.getWindowEndMs());
+    if (windowCommand == Command::START_CLASSIFICATION) {
+        LOG_INFO("Classification complete");
+        finishCommand();
+    }
+}
+
+// DSP task: motion gate and features for a ready window
+void processWindow() {
+    // The central moved on while the window waited
+    if (windowCommand != activeCommand) {
+        return;
+    }
+
+    if (windowCommand == Command::START_TRAINING) {
+        signalProc.processData();
+        // Get label from BLE characteristic
+        int8_t label = bleComm.getTrainingLabel();
+        if (label >= 0 && label <= 2) {
+            // Stored for replay; the epochs run in the training task
+            NN.addTrainingSample(signalProc.getFeatures(), label);
+            NN.startBackgroundTraining();
+            bleComm.sendTrainingProgress(NN.getTrainingProgress());
+            LOG_INFO("Training sample stored, replay buffer: %u", NN.getTrainingProgress().samples);
+        } else {
+            LOG_INFO("Invalid label received");
+        }
+        finishCommand();
+        return;
+    }
+
+    if (signalProc.detectMotion()) {
+        signalProc.processData();
+        scheduler.trigger(inferenceTask);
+        return;
+    }
+    // Nothing but sensor noise: skip FFT and inference
+    signalProc.getStationaryProbabilities(probabilities);
+    LOG_DEBUG("Stationary, skipped windows: %u/%u",
+              signalProc.getWindowsSkipped(), signalProc.getWindowsChecked());
+    publishPrediction();
+}
+
+// Inference task: classify the features DSP just extracted
+void infer() {
+    if (windowCommand != activeCommand) {
+        return;
+    }
+    NN.getPredictionProbabilities(signalProc.getFeatures(), probabilities);
+    publishPrediction();
+}
+
+// Transfer task: non-blocking, one window of MTU-sized packets per run
+void serviceTransfer() {
+    if (isBackgroundUpload(bleComm.getCurrentCommand())) {
+        if (bleComm.receiveWeights(NN)) {
+            LOG_INFO("Network weights switched, classification continues");
+        }
+        return;
+    }
+    switch (activeCommand) {
+        case Command::GET_WEIGHTS:
+            if (bleComm.sendWeights(NN)) {
+                LOG_INFO("Network weights sent");
+                activeCommand = Command::NONE;
+            }
+            break;
+        case Command::GET_WEIGHT_DELTA:
+            // Only what training changed since the central's version; turns into
+            // GET_WEIGHTS when the central is on an unknown version
+            if (bleComm.sendWeightDelta(NN)) {
+                LOG_INFO("Weight delta sent");
+                activeCommand = Command::NONE;
+            }
+            break;
+        case Command::SET_WEIGHTS:
+            if (bleComm.receiveWeights(NN)) {
+                LOG_INFO("Network weights updated");
+                finishCommand();
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+// Training task: one slice of background training, publishing progress after each epoch.
+// Weight transfers read and write the network and benchmarks time it, so training
+// waits for them to finish.
+void trainInBackground() {
+    if (!NN.isTraining() || isTransfer(activeCommand) || isBackgroundUpload(bleComm.getCurrentCommand()) ||
+        benchmark.isRunning()) {
+        return;
+    }
+    if (NN.trainSlice()) {
+        bleComm.sendTrainingProgress(NN.getTrainingProgress());
+    }
+}
+
+// Benchmark task: times the window acquire() sampled, one budgeted slice per run,
+// and releases itself again until the record is complete
+void runBenchmark() {
+    if (windowCommand != activeCommand) {
+        return;     // serviceBle() aborted it
+    }
+    if (!benchmark.isRunning()) {
+        bool training = activeCommand == Command::START_TRAINING_BENCHMARK;
+        LOG_INFO(training ? "Starting training benchmark..." : "Starting inference benchmark...");
+        if (!benchmark.begin(training ? TimingBenchmark::Kind::TRAINING : TimingBenchmark::Kind::INFERENCE,
+                             bleComm.getTrainingLabel(), bleComm.getBenchmarkIterations(),
+                             bleComm.getBenchmarkWarmup())) {
+            finishCommand();
+            return;
+        }
+    }
+    if (!benchmark.step(BenchmarkConfig::SLICE_US)) {
+        scheduler.trigger(benchmarkTask);
+        return;
+    }
+    bleComm.sendBenchmarkReport(reinterpret_cast<const uint8_t*>(&benchmark.getRecord()),
+                                sizeof(TimingBenchmark::Record));
+    finishCommand();
+}
 
+// Maintenance task: pruning scans the weights a few dozen times, saving erases
+// flash pages and enabling the cascade may first train its first stage from the
+// replay buffer, so they run without a budget
+void runMaintenance() {
+    if (activeCommand == Command::PRUNE_WEIGHTS) {
+        NN.prune();
+    } else if (activeCommand == Command::SAVE_WEIGHTS) {
+        modelStore.save(NN);
+    } else if (activeCommand == Command::SET_CASCADE) {
+        uint8_t percent = bleComm.getCascadePercent();
+        NN.setCascade(percent > 0, percent > 0 ? percent / 100.0f : NN.getCascadeThreshold());
+        LOG_INFO(percent > 0 ? "Cascade on, threshold %u%%" : "Cascade off", percent);
+    }
+    finishCommand();
+}
 
+// Stats task: reports tasks that overran or missed a deadline since the last report
+void reportStats() {
+    static uint32_t reported[SchedulerConfig::MAX_TASKS];
+    for (size_t i = 0; i < scheduler.getTaskCount(); i++) {
+        const Scheduler::TaskStats& stats = scheduler.getStats(i);
+        if (stats.overruns + stats.deadlineMisses != reported[i]) {
+            reported[i] = stats.overruns + stats.deadlineMisses;
+            LOG_WARN("Task %u: %u overruns, %u deadline misses in %u runs, max %u us",
+                     (unsigned)i, stats.overruns, stats.deadlineMisses, stats.runs, stats.maxUs);
+        }
+    }
+}
 
 void setup() {
-    #ifdef DEBUG
+    #if LOG_LEVEL > LOG_LEVEL_NONE
     Serial.begin(9600);
     delay(1000);
-    Serial.println("Starting setup...");
     #endif
+    LOG_INFO("Starting setup...");
     if (!bleComm.begin()) {
-        #ifdef DEBUG
-        Serial.println("Failed to initialize BLE communication!");
+        LOG_ERROR("Failed to initialize BLE communication!");
         while (1) {
-            Serial.println("BLE init failed");
+            LOG_ERROR("BLE init failed");
+            Log::drain();
             delay(1000);
         }
-        #endif
     }
-    #ifdef DEBUG
-    Serial.println("BLE initialized");
-    #endif
+    LOG_INFO("BLE initialized");
     if (!signalProc.begin()) {
-        #ifdef DEBUG
-        Serial.println("Failed to initialize IMU!");
+        LOG_ERROR("Failed to initialize IMU!");
         while (1) {
-            Serial.println("IMU init failed");
+            LOG_ERROR("IMU init failed");
+            Log::drain();
             delay(1000);
         }
-        #endif
     }
-    
-    #ifdef DEBUG
-    Serial.println("IMU initialized");
-    #endif
-    #ifdef DEBUG
-    Serial.println("Initializing Neural Network...");
-    #endif
-    NN.init(NNConfig::LAYERS, nullptr, NNConfig::NUM_LAYERS);
-    #ifdef DEBUG
-    Serial.println("Neural network initialized!");
-    #endif
+    LOG_INFO("IMU initialized");
+    // Saved weights are read in place from flash; random ones until the first save
+    uint32_t storedVersion = 0;
+    const float* storedWeights = modelStore.begin() ? modelStore.find(&storedVersion) : nullptr;
+    NN.init(NNConfig::LAYERS, storedWeights, NNConfig::NUM_LAYERS);
+    if (storedWeights) {
+        LOG_INFO("Weights v%u loaded from flash", storedVersion);
+    }
+
+    using namespace SchedulerConfig;
+    scheduler.addPeriodic("ble", serviceBle, BLE_PERIOD_US, BLE_BUDGET_US);
+    scheduler.addPeriodic("acquire", acquire, ACQUIRE_PERIOD_US, ACQUIRE_BUDGET_US);
+    dspTask = scheduler.addEvent("dsp", processWindow, DSP_BUDGET_US, DSP_DEADLINE_US);
+    inferenceTask = scheduler.addEvent("inference", infer, INFERENCE_BUDGET_US, INFERENCE_DEADLINE_US);
+    scheduler.addPeriodic("transfer", serviceTransfer, TRANSFER_PERIOD_US, TRANSFER_BUDGET_US);
+    scheduler.addPeriodic("train", trainInBackground, TRAIN_PERIOD_US, TRAIN_BUDGET_US);
+    benchmarkTask = scheduler.addEvent("benchmark", runBenchmark, BENCHMARK_BUDGET_US, BENCHMARK_DEADLINE_US);
+    maintenanceTask = scheduler.addEvent("maintenance", runMaintenance, 0, MAINTENANCE_DEADLINE_US);
+    scheduler.addPeriodic("stats", reportStats, STATS_PERIOD_US, BLE_BUDGET_US);
+    Log::drain();
 }
 
 void loop() {
-    bleComm.update();
-
-    switch (bleComm.getCurrentCommand()) {
-        case Command::START_CLASSIFICATION: {
-            #ifdef DEBUG
-            Serial.println("Starting classification...");
-            #endif
-            if (signalProc.collectData()) {
-                signalProc.processData();
-                const float* features = signalProc.getFeatures();
-                
-                // Perform classification
-                float probabilities[3];
-                NN. getPredictionProbabilities(features, probabilities);
-                // Send prediction probabilities
-                bleComm.sendPrediction(probabilities, 3);
-                
-                #ifdef DEBUG
-                Serial.println("Classification complete");
-                #endif
-            }
-            
-            bleComm.resetState();
-            break;
-          }
-        
-        case Command::START_TRAINING: {
-            #ifdef DEBUG
-            Serial.println("Starting training...");
-            #endif
-            if (signalProc.collectData()) {
-                signalProc.processData();
-                const float* features = signalProc.getFeatures();
-                // Get label from BLE characteristic
-                int8_t label = bleComm. getTrainingLabel();
-                if (label >= 0 && label <= 2) {
-                    NN.performLiveTraining(features, label);
-                    
-                    #ifdef DEBUG
-                    Serial.println("Training complete");
-                    #endif
-                } else {
-                    #ifdef DEBUG
-                    Serial.println("Invalid label received");
-                    #endif
-                }
-            }
-            
-            bleComm.resetState();
-            break;
-          }
-        
-        case Command::GET_WEIGHTS: {
-            size_t numWeights = NN.getTotalWeights();
-            
-            // Use Communication's tempBuffer directly
-            if (NN.getWeights(bleComm.getTempBuffer(), numWeights)) {
-                bleComm.sendWeights(bleComm.getTempBuffer(), numWeights);
-            }
-            break;
-          }
-                
-        case Command::SET_WEIGHTS: {
-            if (bleComm.receiveWeights(bleComm.getTempBuffer(), NNConfig::MAX_WEIGHTS)) {                     
-                NN.updateNetworkWeights(bleComm.getTempBuffer(), NNConfig::MAX_WEIGHTS);
-            }
-            break;
-          }
-       /* case Command::START_INFERENCE_BENCHMARK: {
-              Serial.println("Starting inference benchmark...");
-              benchmark.measureInferenceLatency();
-              bleComm.resetState();
-              break;
-          }
-
-          case Command::START_TRAINING_BENCHMARK: {
-              Serial.println("Starting training benchmark...");
-              int8_t label = bleComm.getTrainingLabel();
-              if (label >= 0 && label <= 2) {
-                  benchmark.measureTrainingTime(label);
-              }
-              bleComm.resetState();
-              break;
-          }*/
-    }
-    
-    delay(50);
-}
\ No newline at end of file
+    // Nothing released: the idle time the log is drained in
+    if (!scheduler.runOnce()) {
+        Log::drain(LogConfig::DRAIN_PER_IDLE);
+    }
+}
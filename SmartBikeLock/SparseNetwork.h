@@ -0,0 +1,150 @@
+#ifndef SPARSE_NETWORK_H
+#define SPARSE_NETWORK_H
+
+#include <Arduino.h>
+#include <math.h>
+#include "StaticNetwork.h"
+
+// Magnitude-pruned inference copy of a StaticNetwork-shaped weight vector in CSR
+// form: per layer one row per output, holding the input indices and values of
+// the weights that survived. prune() zeroes everything else in the dense vector
+// too, so dense and sparse inference agree and weight transfers carry the
+// pruned model. Rows are output-major like the dense layout, so building and
+// refreshing the CSR is one sequential pass.
+template <size_t Capacity, unsigned int... Sizes>
+class SparseNetwork {
+public:
+    typedef StaticNetworkShape<Sizes...> Shape;
+    static constexpr unsigned int NUM_LAYERS = Shape::NUM_LAYERS;
+    static constexpr size_t TOTAL_WEIGHTS = Shape::weightOffset(NUM_LAYERS);
+    static constexpr size_t TOTAL_OUTPUTS = Shape::outputOffset(NUM_LAYERS);
+    static constexpr size_t TOTAL_ROW_STARTS = TOTAL_OUTPUTS + NUM_LAYERS;   // Out + 1 per layer
+    static_assert(Capacity > 0 && Capacity <= 0xFFFF, "Row starts are 16-bit");
+    static_assert(Shape::size(0) <= 0x10000 && Shape::maxWidth() <= 0x10000, "Column indices are 16-bit");
+
+    SparseNetwork() : nonZeros(0) {}
+
+    // Keeps the largest (1 - sparsity) of each layer's weights by magnitude and
+    // zeroes the rest. sparsity is raised as far as needed for the survivors to
+    // fit Capacity. Returns the non-zeros kept.
+    size_t prune(float* dense, float sparsity) {
+        const float minSparsity = 1.0f - (float)Capacity / TOTAL_WEIGHTS;
+        sparsity = constrain(sparsity, minSparsity, 1.0f);
+
+        nonZeros = 0;
+        for (unsigned int layer = 0; layer < NUM_LAYERS; layer++) {
+            const unsigned int in = Shape::size(layer);
+            const unsigned int out = Shape::size(layer + 1);
+            float* w = &dense[Shape::weightOffset(layer)];
+            const float limit = threshold(w, (size_t)in * out, (size_t)((1.0f - sparsity) * in * out));
+
+            uint16_t* rows = &rowStart[Shape::outputOffset(layer) + layer];
+            for (unsigned int o = 0; o < out; o++) {
+                rows[o] = nonZeros;
+                float* row = &w[o * in];
+                for (unsigned int i = 0; i < in; i++) {
+                    if (fabsf(row[i]) > limit && nonZeros < Capacity) {
+                        values[nonZeros] = row[i];
+                        columns[nonZeros] = i;
+                        nonZeros++;
+                    } else {
+                        row[i] = 0.0f;
+                    }
+                }
+            }
+            rows[out] = nonZeros;
+        }
+        return nonZeros;
+    }
+
+    // Re-applies the mask after the dense weights were trained: pruned weights
+    // go back to zero, kept ones are copied into the CSR
+    void refresh(float* dense) {
+        for (unsigned int layer = 0; layer < NUM_LAYERS; layer++) {
+            const unsigned int in = Shape::size(layer);
+            const unsigned int out = Shape::size(layer + 1);
+            float* w = &dense[Shape::weightOffset(layer)];
+            const uint16_t* rows = &rowStart[Shape::outputOffset(layer) + layer];
+            for (unsigned int o = 0; o < out; o++) {
+                float* row = &w[o * in];
+                size_t k = rows[o];
+                for (unsigned int i = 0; i < in; i++) {
+                    if (k < rows[o + 1] && columns[k] == i) {
+                        values[k++] = row[i];
+                    } else {
+                        row[i] = 0.0f;
+                    }
+                }
+            }
+        }
+    }
+
+    const float* feedForward(const float* input) {
+        forward(input, LayerTag<0>());
+        return &outputs[Shape::outputOffset(NUM_LAYERS - 1)];
+    }
+
+    size_t getNonZeros() const { return nonZeros; }
+    // One multiply-accumulate per kept weight
+    size_t getMacs() const { return nonZeros; }
+    // CSR bytes in use: values, column indices and row starts
+    size_t getBytes() const { return nonZeros * (sizeof(float) + sizeof(uint16_t)) + sizeof(rowStart); }
+
+private:
+    template <unsigned int Layer> struct LayerTag {};
+
+    // Bisects for a magnitude with at most keep weights above it
+    static float threshold(const float* w, size_t n, size_t keep) {
+        float hi = 0.0f;
+        for (size_t i = 0; i < n; i++) {
+            const float magnitude = fabsf(w[i]);
+            hi = magnitude > hi ? magnitude : hi;
+        }
+        if (keep >= n) {
+            return -1.0f;
+        }
+        float lo = 0.0f;
+        for (int iteration = 0; iteration < 32; iteration++) {
+            const float mid = 0.5f * (lo + hi);
+            size_t above = 0;
+            for (size_t i = 0; i < n; i++) {
+                above += fabsf(w[i]) > mid;
+            }
+            if (above > keep) {
+                lo = mid;
+            } else {
+                hi = mid;
+            }
+        }
+        return hi;
+    }
+
+    template <unsigned int Out>
+    static inline void sparseForward(const float* in, const float* value, const uint16_t* column,
+                                     const uint16_t* rows, float* out) {
+        for (unsigned int o = 0; o < Out; o++) {
+            float sum = 0.0f;
+            for (unsigned int k = rows[o]; k < rows[o + 1]; k++) {
+                sum += in[column[k]] * value[k];
+            }
+            out[o] = StaticNetwork<WeightStorage::RAM, Sizes...>::sigmoid(sum);
+        }
+    }
+
+    inline void forward(const float*, LayerTag<NUM_LAYERS>) {}
+
+    template <unsigned int Layer>
+    inline void forward(const float* in, LayerTag<Layer>) {
+        float* out = &outputs[Shape::outputOffset(Layer)];
+        sparseForward<Shape::size(Layer + 1)>(in, values, columns, &rowStart[Shape::outputOffset(Layer) + Layer], out);
+        forward(out, LayerTag<Layer + 1>());
+    }
+
+    alignas(16) float values[Capacity];
+    alignas(16) float outputs[TOTAL_OUTPUTS];
+    uint16_t columns[Capacity];
+    uint16_t rowStart[TOTAL_ROW_STARTS];
+    size_t nonZeros;
+};
+
+#endif
@@ -0,0 +1,269 @@
+#ifndef STATIC_NETWORK_H
+#define STATIC_NETWORK_H
+
+#include <Arduino.h>
+#include <math.h>
+#include <string.h>
+
+// Layer sizes and array offsets of a StaticNetwork, all compile-time constants
+template <unsigned int... Sizes>
+struct StaticNetworkShape {
+    static constexpr unsigned int NUM_LAYERS = sizeof...(Sizes) - 1;   // Weight layers
+
+    static constexpr unsigned int size(unsigned int index) {
+        constexpr unsigned int sizes[] = {Sizes...};
+        return sizes[index];
+    }
+    // Start of layer's weights in the flat vector
+    static constexpr size_t weightOffset(unsigned int layer) {
+        size_t offset = 0;
+        for (unsigned int i = 0; i < layer; i++) {
+            offset += size(i) * size(i + 1);
+        }
+        return offset;
+    }
+    // Start of layer's outputs in the activation array
+    static constexpr size_t outputOffset(unsigned int layer) {
+        size_t offset = 0;
+        for (unsigned int i = 0; i < layer; i++) {
+            offset += size(i + 1);
+        }
+        return offset;
+    }
+    // Widest layer output, the size of one gamma buffer
+    static constexpr unsigned int maxWidth() {
+        unsigned int width = 0;
+        for (unsigned int i = 1; i <= NUM_LAYERS; i++) {
+            width = size(i) > width ? size(i) : width;
+        }
+        return width;
+    }
+};
+
+// Where a StaticNetwork keeps its weights
+enum class WeightStorage {
+    RAM,        // Own aligned array, trainable; can start from external weights and copies them on the first change
+    IN_PLACE    // Only reads external weights (e.g. memory-mapped flash): no weight or gradient RAM, inference only
+};
+
+// The weight and gradient arrays of a RAM network; an in-place network has none
+template <WeightStorage Storage, size_t Count>
+struct StaticWeightArrays {
+    float* weights() { return weightArray; }
+    const float* weights() const { return weightArray; }
+    float* gradients() { return gradientArray; }
+
+    alignas(16) float weightArray[Count];
+    alignas(16) float gradientArray[Count];     // Mini-batch sums
+};
+
+template <size_t Count>
+struct StaticWeightArrays<WeightStorage::IN_PLACE, Count> {
+    float* weights() { return nullptr; }
+    const float* weights() const { return nullptr; }
+    float* gradients() { return nullptr; }
+};
+
+// Fully connected sigmoid network with its shape fixed at compile time, e.g.
+// StaticNetwork<WeightStorage::RAM, 11, 1000, 3>. It does what the NeuralNetwork
+// library does with the options NeuralNetworkBikeLock builds it with
+// (REDUCE_RAM_WEIGHTS_LVL2, NO_BIAS, sigmoid, MSE, learning rate 0.33): same flat
+// output-major weight vector, same random init sequence, same per-sample backprop.
+// Weights, mini-batch gradients, activations and the backprop gammas are aligned
+// member arrays, so nothing is allocated, and every layer is a kernel instantiated
+// with constant sizes the compiler can unroll and vectorise. Inference can also
+// read the weights in place from read-only memory such as memory-mapped flash.
+// With RAM storage the first change copies them to RAM; IN_PLACE storage has no
+// weight or gradient arrays, so randomize(), training and setWeights() do nothing.
+template <WeightStorage Storage, unsigned int... Sizes>
+class StaticNetwork {
+public:
+    typedef StaticNetworkShape<Sizes...> Shape;
+    static_assert(sizeof...(Sizes) >= 2, "A network needs an input and an output size");
+
+    static constexpr unsigned int NUM_LAYERS = Shape::NUM_LAYERS;
+    static constexpr unsigned int NUM_INPUTS = Shape::size(0);
+    static constexpr unsigned int NUM_OUTPUTS = Shape::size(NUM_LAYERS);
+    static constexpr size_t TOTAL_WEIGHTS = Shape::weightOffset(NUM_LAYERS);
+    static constexpr size_t TOTAL_OUTPUTS = Shape::outputOffset(NUM_LAYERS);
+    static constexpr unsigned int MAX_WIDTH = Shape::maxWidth();
+    static constexpr bool TRAINABLE = Storage == WeightStorage::RAM;
+
+    StaticNetwork() : arrays(), model(arrays.weights()), input(nullptr), learningRate(0.33f) {}
+
+    // Same draws in the same order as the library, so a given seed gives the same weights
+    void randomize() {
+        if (!TRAINABLE) {
+            return;
+        }
+        float* weights = arrays.weights();
+        model = weights;
+        for (size_t i = 0; i < TOTAL_WEIGHTS; i++) {
+            weights[i] = (float)random(-90000, 90000) / 100000;
+        }
+    }
+
+    // input must hold NUM_INPUTS values and stay valid until backProp()
+    const float* feedForward(const float* input_) {
+        input = input_;
+        forward(input_, LayerTag<0>());
+        return &outputs[Shape::outputOffset(NUM_LAYERS - 1)];
+    }
+
+    // One SGD step towards expected for the last feedForward() input
+    void backProp(const float* expected) {
+        if (!TRAINABLE) {
+            return;
+        }
+        float* weights = getWeights();
+        setOutputDelta(expected);
+        backward(LayerTag<NUM_LAYERS - 1>(), weights, learningRate);
+    }
+
+    // Mini-batch training: accumulateGradients() after each feedForward() of the batch,
+    // then applyGradients(batchSize) once. Same gradients as backProp(), summed into
+    // their own array instead of changing the weights, so weights read in place stay
+    // there until the batch is applied.
+    void accumulateGradients(const float* expected) {
+        if (!TRAINABLE) {
+            return;
+        }
+        setOutputDelta(expected);
+        // A rate of -1 turns each step into the plain gradient
+        backward(LayerTag<NUM_LAYERS - 1>(), arrays.gradients(), -1.0f);
+    }
+    // One SGD step with the summed gradients divided by batchSize, then clears them
+    void applyGradients(unsigned int batchSize) {
+        if (!TRAINABLE || batchSize == 0) {
+            return;
+        }
+        float* w = getWeights();
+        float* gradients = arrays.gradients();
+        const float scale = 1.0f / batchSize;
+        for (size_t i = 0; i < TOTAL_WEIGHTS; i++) {
+            w[i] -= (gradients[i] * scale) * learningRate;
+            gradients[i] = 0.0f;
+        }
+    }
+    // Drops what was accumulated since the last applyGradients()
+    void clearGradients() {
+        if (TRAINABLE) {
+            memset(arrays.gradients(), 0, TOTAL_WEIGHTS * sizeof(float));
+        }
+    }
+
+    // Runs inference from external until the weights are next changed.
+    // external holds TOTAL_WEIGHTS floats and must stay valid.
+    void useExternalWeights(const float* external) { model = external; }
+    bool isExternal() const { return model != arrays.weights(); }
+    // Weights inference reads, possibly read-only; nullptr for IN_PLACE before useExternalWeights()
+    const float* getModel() const { return model; }
+    // Writable weights, copied into RAM first if they were external; nullptr for IN_PLACE
+    float* getWeights() {
+        float* weights = arrays.weights();
+        if (TRAINABLE && model != weights) {
+            memcpy(weights, model, TOTAL_WEIGHTS * sizeof(float));
+            model = weights;
+        }
+        return weights;
+    }
+    // Copies source (TOTAL_WEIGHTS floats) into the RAM weights and runs from them
+    void setWeights(const float* source) {
+        if (TRAINABLE) {
+            memcpy(arrays.weights(), source, TOTAL_WEIGHTS * sizeof(float));
+            model = arrays.weights();
+        }
+    }
+    void setLearningRate(float rate) { learningRate = rate; }
+
+    static inline float sigmoid(float x) {
+        return 1.0f / (1.0f + expf(-x));
+    }
+
+private:
+    template <unsigned int Layer> struct LayerTag {};
+
+    template <unsigned int In, unsigned int Out>
+    static inline void denseForward(const float* in, const float* w, float* out) {
+        for (unsigned int o = 0; o < Out; o++) {
+            const float* row = &w[o * In];
+            float sum = 0.0f;
+            for (unsigned int i = 0; i < In; i++) {
+                sum += in[i] * row[i];
+            }
+            out[o] = sigmoid(sum);
+        }
+    }
+
+    void setOutputDelta(const float* expected) {
+        constexpr unsigned int last = NUM_LAYERS - 1;
+        const float* out = &outputs[Shape::outputOffset(last)];
+        float* delta = gamma[last & 1];
+        for (unsigned int i = 0; i < NUM_OUTPUTS; i++) {
+            delta[i] = out[i] - expected[i];
+        }
+    }
+
+    // delta: dE/d(output) of this layer. Like the library, the previous layer's
+    // delta is taken against each weight before it is updated. The first layer
+    // has nobody to pass it to, so it skips that work. target gets -rate x the
+    // gradient added: the weights themselves for an SGD step, or the gradient sums.
+    template <unsigned int In, unsigned int Out, bool Propagate>
+    static inline void denseBackward(const float* in, const float* out, const float* delta,
+                                     const float* w, float* target, float* prevDelta, float rate) {
+        if (Propagate) {
+            for (unsigned int i = 0; i < In; i++) {
+                prevDelta[i] = 0.0f;
+            }
+        }
+        for (unsigned int o = 0; o < Out; o++) {
+            const float g = delta[o] * (out[o] - out[o] * out[o]);   // Sigmoid derivative from f(x)
+            const float step = -(g * rate);
+            const float* row = &w[o * In];
+            float* targetRow = &target[o * In];
+            for (unsigned int i = 0; i < In; i++) {
+                if (Propagate) {
+                    prevDelta[i] += g * row[i];
+                }
+                targetRow[i] += step * in[i];
+            }
+        }
+    }
+
+    inline void forward(const float*, LayerTag<NUM_LAYERS>) {}
+
+    template <unsigned int Layer>
+    inline void forward(const float* in, LayerTag<Layer>) {
+        float* out = &outputs[Shape::outputOffset(Layer)];
+        denseForward<Shape::size(Layer), Shape::size(Layer + 1)>(in, &model[Shape::weightOffset(Layer)], out);
+        forward(out, LayerTag<Layer + 1>());
+    }
+
+    inline const float* layerInput(LayerTag<0>) const { return input; }
+
+    template <unsigned int Layer>
+    inline const float* layerInput(LayerTag<Layer>) const { return &outputs[Shape::outputOffset(Layer - 1)]; }
+
+    inline void backward(LayerTag<0>, float* target, float rate) {
+        denseBackward<Shape::size(0), Shape::size(1), false>(input, outputs, gamma[0], model, target, nullptr, rate);
+    }
+
+    // Layer reads its delta from gamma[Layer & 1] and leaves the previous layer's in the other half
+    template <unsigned int Layer>
+    inline void backward(LayerTag<Layer>, float* target, float rate) {
+        constexpr size_t offset = Shape::weightOffset(Layer);
+        denseBackward<Shape::size(Layer), Shape::size(Layer + 1), true>(
+            layerInput(LayerTag<Layer>()), &outputs[Shape::outputOffset(Layer)], gamma[Layer & 1],
+            &model[offset], &target[offset], gamma[(Layer + 1) & 1], rate);
+        backward(LayerTag<Layer - 1>(), target, rate);
+    }
+
+    StaticWeightArrays<Storage, TOTAL_WEIGHTS> arrays;
+    const float* model;         // Weights inference reads: the RAM array or external
+    alignas(16) float outputs[TOTAL_OUTPUTS];
+    alignas(16) float gamma[2][MAX_WIDTH];
+    const float* input;
+    float learningRate;
+};
+
+#endif
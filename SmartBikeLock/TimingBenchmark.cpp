@@ -0,0 +1,186 @@
+#include "TimingBenchmark.h"
+#include "Log.h"
+
+void LatencyHistogram::reset() {
+    for(unsigned int i = 0; i < NUM_BUCKETS; i++) {
+        buckets[i] = 0;
+    }
+    total = 0;
+    minTicks = 0xFFFFFFFFUL;
+    maxTicks = 0;
+}
+
+unsigned int LatencyHistogram::bucketOf(uint32_t ticks) {
+    if (ticks < SUB_BUCKETS) return ticks;
+    // Top bit selects the octave, the next three bits the sub-bucket
+    unsigned int msb = 31 - __builtin_clz(ticks);
+    unsigned int shift = msb - 3;
+    return (shift + 1) * SUB_BUCKETS + ((ticks >> shift) & (SUB_BUCKETS - 1));
+}
+
+uint32_t LatencyHistogram::bucketMidpoint(unsigned int bucket) {
+    if (bucket < SUB_BUCKETS) return bucket;
+    unsigned int shift = bucket / SUB_BUCKETS - 1;
+    uint32_t lower = (uint32_t)(SUB_BUCKETS + bucket % SUB_BUCKETS) << shift;
+    return lower + ((1UL << shift) >> 1);
+}
+
+void LatencyHistogram::record(uint32_t ticks) {
+    uint16_t& bucket = buckets[bucketOf(ticks)];
+    if (bucket < 0xFFFF) bucket++;
+    total++;
+    if (ticks < minTicks) minTicks = ticks;
+    if (ticks > maxTicks) maxTicks = ticks;
+}
+
+uint32_t LatencyHistogram::percentile(float fraction) const {
+    if (total == 0) return 0;
+    uint32_t rank = (uint32_t)ceil(fraction * total);
+    if (rank < 1) rank = 1;
+
+    uint32_t seen = 0;
+    for(unsigned int i = 0; i < NUM_BUCKETS; i++) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            // Bucket resolution can overshoot the exact extremes
+            uint32_t value = bucketMidpoint(i);
+            if (value < minTicks) value = minTicks;
+            if (value > maxTicks) value = maxTicks;
+            return value;
+        }
+    }
+    return maxTicks;
+}
+
+TimingBenchmark::TimingBenchmark(NeuralNetworkBikeLock& nn_, SignalProcessing& signalProc_)
+    : nn(nn_), signalProc(signalProc_), kind(Kind::INFERENCE), label(-1), iterations(0), warmup(0),
+      passes(0), running(false) {
+    memset(&record, 0, sizeof(record));
+}
+
+bool TimingBenchmark::begin(Kind kind_, int label_, uint16_t iterations_, uint16_t warmup_) {
+    abort();
+    if (kind_ == Kind::TRAINING) {
+        if (label_ < 0 || label_ > 2) {
+            LOG_INFO("Invalid label received");
+            return false;
+        }
+        if (!nn.saveSnapshot()) {
+            LOG_WARN("Training benchmark needs a weight snapshot, not started");
+            return false;
+        }
+        LOG_INFO("Measuring training time...");
+    } else {
+        LOG_INFO("Measuring inference latency...");
+    }
+
+    kind = kind_;
+    label = label_;
+    iterations = iterations_;
+    if (iterations == 0) iterations = 1;
+    if (iterations > BenchmarkConfig::MAX_ITERATIONS) iterations = BenchmarkConfig::MAX_ITERATIONS;
+    warmup = warmup_;
+    passes = 0;
+    running = true;
+
+    CycleTimer::begin();
+    for(int i = 0; i < NUM_STAGES; i++) {
+        histograms[i].reset();
+    }
+    return true;
+}
+
+void TimingBenchmark::runOnce(uint32_t* ticks) {
+    uint32_t startTotal = CycleTimer::now();
+
+    // processData() leaves the window as it is, so every pass sees the same input
+    uint32_t start = CycleTimer::now();
+    signalProc.processData();
+    const float* features = signalProc.getFeatures();
+    ticks[STAGE_FEATURES] = CycleTimer::now() - start;
+
+    start = CycleTimer::now();
+    if (kind == Kind::TRAINING) {
+        nn.performLiveTraining(features, label);
+    } else {
+        float probabilities[3];
+        nn.getPredictionProbabilities(features, probabilities);
+    }
+    ticks[STAGE_MODEL] = CycleTimer::now() - start;
+
+    ticks[STAGE_TOTAL] = CycleTimer::now() - startTotal;
+}
+
+bool TimingBenchmark::step(unsigned long budgetUs) {
+    if (!running) {
+        return false;
+    }
+
+    // Warm-up passes settle caches, the BLE stack and allocator state and are not recorded
+    const uint32_t total = (uint32_t)warmup + iterations;
+    unsigned long start = micros();
+    uint32_t ticks[NUM_STAGES];
+    do {
+        runOnce(ticks);
+        if (passes++ >= warmup) {
+            for(int s = 0; s < NUM_STAGES; s++) {
+                histograms[s].record(ticks[s]);
+            }
+        }
+    } while (passes < total && micros() - start < budgetUs);
+
+    if (passes < total) {
+        return false;
+    }
+    finish();
+    return true;
+}
+
+void TimingBenchmark::abort() {
+    if (!running) {
+        return;
+    }
+    running = false;
+    if (kind == Kind::TRAINING) {
+        nn.restoreSnapshot();
+    }
+}
+
+void TimingBenchmark::finish() {
+    abort();
+
+    record.version = RECORD_VERSION;
+    record.kind = static_cast<uint8_t>(kind);
+    record.iterations = iterations;
+    record.tickHz = CycleTimer::ticksPerSecond();
+    for(int s = 0; s < NUM_STAGES; s++) {
+        StageSummary& summary = record.stages[s];
+        summary.min = histograms[s].minimum();
+        summary.p50 = histograms[s].percentile(0.50f);
+        summary.p95 = histograms[s].percentile(0.95f);
+        summary.p99 = histograms[s].percentile(0.99f);
+        summary.max = histograms[s].maximum();
+    }
+    printReport();
+}
+
+void TimingBenchmark::printReport() const {
+    // One format literal per line: the log stores the pointer, not the text
+    const bool training = record.kind == static_cast<uint8_t>(Kind::TRAINING);
+    const char* const stageFormats[NUM_STAGES] = {
+        "Features: %f / %f / %f / %f / %f",
+        training ? "Training: %f / %f / %f / %f / %f" : "Inference: %f / %f / %f / %f / %f",
+        "Total: %f / %f / %f / %f / %f"};
+    const float usPerTick = 1e6f / record.tickHz;
+
+    if (training) {
+        LOG_INFO("=== Training timing, us over %u iterations (min/p50/p95/p99/max) ===", record.iterations);
+    } else {
+        LOG_INFO("=== Inference timing, us over %u iterations (min/p50/p95/p99/max) ===", record.iterations);
+    }
+    for(int s = 0; s < NUM_STAGES; s++) {
+        const StageSummary& summary = record.stages[s];
+        LOG_INFO(stageFormats[s], summary.min * usPerTick, summary.p50 * usPerTick, summary.p95 * usPerTick,
+                 summary.p99 * usPerTick, summary.max * usPerTick);
+    }
+}
@@ -1,178 +1,114 @@
 #ifndef TIMING_BENCHMARK_H
 #define TIMING_BENCHMARK_H
 
+#include <Arduino.h>
+#include "Config.h"
 #include "NeuralNetworkBikeLock.h"
 #include "SignalProcessing.h"
+#include "CycleTimer.h"
+
+// Log-linear latency histogram: exact below 8 ticks, then 8 buckets per power
+// of two (<= 12.5% relative error). Memory is fixed no matter how many samples
+// are recorded; min and max are kept exactly.
+class LatencyHistogram {
+public:
+    static constexpr unsigned int SUB_BUCKETS = 8;
+    static constexpr unsigned int NUM_BUCKETS = 30 * SUB_BUCKETS;
+
+    LatencyHistogram() { reset(); }
+
+    void reset();
+    void record(uint32_t ticks);
+    uint32_t count() const { return total; }
+    uint32_t minimum() const { return total ? minTicks : 0; }
+    uint32_t maximum() const { return maxTicks; }
+    // Value at or below which the given fraction of samples falls
+    uint32_t percentile(float fraction) const;
 
-class TimingBenchmark {
 private:
-    struct TimingMetrics {
-        unsigned long dataCollectionTime;
-        unsigned long featureExtractionTime;
-        unsigned long inferenceTime;
-        unsigned long trainingTime;
-        unsigned long totalTime;
+    uint16_t buckets[NUM_BUCKETS];
+    uint32_t total;
+    uint32_t minTicks;
+    uint32_t maxTicks;
+
+    static unsigned int bucketOf(uint32_t ticks);
+    static uint32_t bucketMidpoint(unsigned int bucket);
+};
+
+// Times the feature and model stages of the live pipeline on one window that was
+// already sampled (collectData() or a ready update()), so nothing blocks for a
+// window's worth of sampling. step() runs passes for a time budget and returns, so
+// the scheduler keeps BLE serviced in between. A training benchmark runs on a
+// snapshot (NeuralNetworkBikeLock::saveSnapshot()) and leaves the model as it was.
+class TimingBenchmark {
+public:
+    enum class Kind : uint8_t {
+        INFERENCE = 0,
+        TRAINING = 1
     };
 
-    TimingMetrics metrics;
+    enum Stage {
+        STAGE_FEATURES = 0,   // processData()
+        STAGE_MODEL,          // Inference or one training step
+        STAGE_TOTAL,
+        NUM_STAGES
+    };
+
+    struct StageSummary {
+        uint32_t min;
+        uint32_t p50;
+        uint32_t p95;
+        uint32_t p99;
+        uint32_t max;
+    };
+
+    // Sent as-is over BLE (little-endian, no padding). Times are in ticks;
+    // divide by tickHz for seconds.
+    struct Record {
+        uint8_t version;
+        uint8_t kind;
+        uint16_t iterations;
+        uint32_t tickHz;
+        StageSummary stages[NUM_STAGES];
+    };
+
+    static constexpr uint8_t RECORD_VERSION = 2;    // 1 had a collectData() stage first
+
+    TimingBenchmark(NeuralNetworkBikeLock& nn_, SignalProcessing& signalProc_);
+
+    // False for an invalid training label or when the weight snapshot does not fit
+    bool begin(Kind kind, int label,
+               uint16_t iterations = BenchmarkConfig::DEFAULT_ITERATIONS,
+               uint16_t warmup = BenchmarkConfig::DEFAULT_WARMUP);
+    // Runs passes until budgetUs is used up (at least one). Returns true once the
+    // record is complete; the report is then logged and the snapshot restored.
+    bool step(unsigned long budgetUs = BenchmarkConfig::SLICE_US);
+    // Stops a running benchmark without a record, restoring the snapshot
+    void abort();
+    bool isRunning() const { return running; }
+
+    const Record& getRecord() const { return record; }
+    void printReport() const;
+
+private:
     NeuralNetworkBikeLock& nn;
     SignalProcessing& signalProc;
-    
-    static const int NUM_ITERATIONS = 10;
-    
-public:
-    TimingBenchmark(NeuralNetworkBikeLock& nn_, SignalProcessing& signalProc_) 
-        : nn(nn_), signalProc(signalProc_) {
-        resetMetrics();
-    }
-    
-    void resetMetrics() {
-        metrics = {0, 0, 0, 0, 0};
-    }
-    
-    void measureInferenceLatency() {
-        Serial.println("\nMeasuring inference latency...");
-        resetMetrics();
-        
-        for(int i = 0; i < NUM_ITERATIONS; i++) {
-            unsigned long startTotal = micros();
-            
-            // Measure data collection
-            unsigned long start = micros();
-            signalProc.collectData();
-            unsigned long dataCollectionTime = micros() - start;
-            
-            // Measure feature extraction
-            start = micros();
-            signalProc.processData();
-            const float* features = signalProc.getFeatures();
-            unsigned long featureTime = micros() - start;
-            
-            // Measure inference
-            start = micros();
-            float probabilities[3];
-            nn.getPredictionProbabilities(features, probabilities);
-            unsigned long inferenceTime = micros() - start;
-            
-            // Update metrics
-            metrics.dataCollectionTime += dataCollectionTime;
-            metrics.featureExtractionTime += featureTime;
-            metrics.inferenceTime += inferenceTime;
-            metrics.totalTime += (micros() - startTotal);
-            
-            if((i + 1) % 10 == 0) {
-                Serial.print("Completed ");
-                Serial.print(i + 1);
-                Serial.println(" iterations");
-            }
-        }
-        
-        // Calculate averages
-        metrics.dataCollectionTime /= NUM_ITERATIONS;
-        metrics.featureExtractionTime /= NUM_ITERATIONS;
-        metrics.inferenceTime /= NUM_ITERATIONS;
-        metrics.totalTime /= NUM_ITERATIONS;
-        
-        printInferenceMetrics();
-    }
-    
-    void measureTrainingTime(int label) {
-        Serial.println("\nMeasuring training time...");
-        resetMetrics();
-        
-        for(int i = 0; i < NUM_ITERATIONS; i++) {
-            unsigned long startTotal = micros();
-            
-            // Measure data collection
-            unsigned long start = micros();
-            signalProc.collectData();
-            unsigned long dataCollectionTime = micros() - start;
-            
-            // Measure feature extraction
-            start = micros();
-            signalProc.processData();
-            const float* features = signalProc.getFeatures();
-            unsigned long featureTime = micros() - start;
-            
-            // Measure training
-            start = micros();
-            nn.performLiveTraining(features, label);
-            unsigned long trainingTime = micros() - start;
-            
-            // Update metrics
-            metrics.dataCollectionTime += dataCollectionTime;
-            metrics.featureExtractionTime += featureTime;
-            metrics.trainingTime += trainingTime;
-            metrics.totalTime += (micros() - startTotal);
-            
-            if((i + 1) % 10 == 0) {
-                Serial.print("Completed ");
-                Serial.print(i + 1);
-                Serial.println(" iterations");
-            }
-        }
-        
-        // Calculate averages
-        metrics.dataCollectionTime /= NUM_ITERATIONS;
-        metrics.featureExtractionTime /= NUM_ITERATIONS;
-        metrics.trainingTime /= NUM_ITERATIONS;
-        metrics.totalTime /= NUM_ITERATIONS;
-        
-        printTrainingMetrics();
-    }
-    
-private:
-    void printInferenceMetrics() {
-        Serial.println("\n=== Inference Timing Results ===");
-        Serial.println("Average times over 5 iterations:");
-        Serial.print("Data Collection: "); 
-        Serial.print(metrics.dataCollectionTime);
-        Serial.println(" microseconds");
-        
-        Serial.print("Feature Extraction: ");
-        Serial.print(metrics.featureExtractionTime);
-        Serial.println(" microseconds");
-        
-        Serial.print("Inference: ");
-        Serial.print(metrics.inferenceTime);
-        Serial.println(" microseconds");
-        
-        Serial.print("Total Latency: ");
-        Serial.print(metrics.totalTime);
-        Serial.println(" microseconds");
-        
-        // Convert to milliseconds for easier reading
-        float totalMs = metrics.totalTime / 1000.0;
-        Serial.print("Total Latency: ");
-        Serial.print(totalMs);
-        Serial.println(" milliseconds");
-    }
-    
-    void printTrainingMetrics() {
-        Serial.println("\n=== Training Timing Results ===");
-        Serial.println("Average times over 5 iterations:");
-        Serial.print("Data Collection: ");
-        Serial.print(metrics.dataCollectionTime);
-        Serial.println(" microseconds");
-        
-        Serial.print("Feature Extraction: ");
-        Serial.print(metrics.featureExtractionTime);
-        Serial.println(" microseconds");
-        
-        Serial.print("Training: ");
-        Serial.print(metrics.trainingTime);
-        Serial.println(" microseconds");
-        
-        Serial.print("Total Time: ");
-        Serial.print(metrics.totalTime);
-        Serial.println(" microseconds");
-        
-        // Convert to milliseconds for easier reading
-        float totalMs = metrics.totalTime / 1000.0;
-        Serial.print("Total Time: ");
-        Serial.print(totalMs);
-        Serial.println(" milliseconds");
-    }
+    LatencyHistogram histograms[NUM_STAGES];
+    Record record;
+    Kind kind;
+    int label;
+    uint16_t iterations;
+    uint16_t warmup;
+    uint32_t passes;        // Warm-up and timed passes run so far
+    bool running;
+
+    void runOnce(uint32_t* ticks);
+    void finish();
 };
 
+static_assert(sizeof(TimingBenchmark::Record) == 8 + TimingBenchmark::NUM_STAGES * 5 * sizeof(uint32_t),
+              "Benchmark record must stay unpadded, the BLE client parses it byte by byte");
+static_assert(sizeof(TimingBenchmark::Record) <= BLEConfig::BENCHMARK_REPORT_SIZE,
+              "Benchmark record does not fit the BLE characteristic");
+
 #endif
@@ -0,0 +1,119 @@
+#include <Arduino.h>
+#include "WeightSync.h"
+#include "Crc32.h"
+#include "Float16.h"
+#include <math.h>
+
+namespace {
+    constexpr size_t READ_CHUNK = 64;
+}
+
+WeightSync::WeightSync() :
+    length(0),
+    baseVersion(0),
+    cursor(0),
+    runEnd(0),
+    changedCount(0)
+{
+}
+
+void WeightSync::rebase(NeuralNetworkBikeLock& nn, uint32_t version) {
+    float chunk[READ_CHUNK];
+    length = 0;
+    while (length < NNConfig::MAX_WEIGHTS) {
+        size_t n = nn.readWeights(chunk, length, min(READ_CHUNK, NNConfig::MAX_WEIGHTS - length));
+        if (n == 0) {
+            break;
+        }
+        for (size_t i = 0; i < n; i++) {
+            base[length + i] = floatToHalf(chunk[i]);
+        }
+        length += n;
+    }
+    baseVersion = (length > 0) ? version : 0;
+    cursor = length;
+}
+
+void WeightSync::invalidate() {
+    baseVersion = 0;
+    cursor = length;
+}
+
+bool WeightSync::encode(float weight, uint16_t baseValue, uint16_t& delta) const {
+    // Moved by less than one fp16 step or the minimum change: leave it for a later sync
+    float change = weight - halfToFloat(baseValue);
+    if (fabsf(change) < BLEConfig::DELTA_MIN_CHANGE || floatToHalf(weight) == baseValue) {
+        return false;
+    }
+    delta = floatToHalf(change);
+    return true;
+}
+
+void WeightSync::beginDelta() {
+    cursor = 0;
+    runEnd = 0;
+    changedCount = 0;
+}
+
+size_t WeightSync::nextRuns(NeuralNetworkBikeLock& nn, uint8_t* body, size_t capacity) {
+    float chunk[READ_CHUNK];
+    size_t chunkStart = cursor;
+    size_t chunkLength = 0;
+    uint8_t* run = nullptr;
+    size_t used = 0;
+
+    while (cursor < length) {
+        if (cursor >= chunkStart + chunkLength) {
+            chunkStart = cursor;
+            chunkLength = nn.readWeights(chunk, cursor, READ_CHUNK);
+            if (chunkLength == 0) {
+                cursor = length;
+                break;
+            }
+        }
+
+        uint16_t delta;
+        if (!encode(chunk[cursor - chunkStart], base[cursor], delta)) {
+            run = nullptr;
+            cursor++;
+            continue;
+        }
+        if (run == nullptr || run[2] == BLEConfig::DELTA_RUN_MAX) {
+            if (used + BLEConfig::DELTA_RUN_HEADER_SIZE + sizeof(delta) > capacity) {
+                break;
+            }
+            uint16_t skip = cursor - runEnd;
+            run = &body[used];
+            run[0] = skip & 0xFF;
+            run[1] = skip >> 8;
+            run[2] = 0;
+            used += BLEConfig::DELTA_RUN_HEADER_SIZE;
+        } else if (used + sizeof(delta) > capacity) {
+            break;
+        }
+        body[used++] = delta & 0xFF;
+        body[used++] = delta >> 8;
+        run[2]++;
+
+        // Same arithmetic as the central: both halves widen exactly, one float add, one fp16 rounding
+        base[cursor] = floatToHalf(halfToFloat(base[cursor]) + halfToFloat(delta));
+        changedCount++;
+        cursor++;
+        runEnd = cursor;
+    }
+    return used;
+}
+
+void WeightSync::finishDelta(uint32_t version) {
+    baseVersion = version;
+}
+
+uint32_t WeightSync::baseCrc() const {
+    // Little-endian uint16 per weight, the byte order of numpy's float16 array
+    uint32_t crc = CRC32_INIT;
+    for (size_t i = 0; i < length; i++) {
+        uint8_t bytes[2] = {(uint8_t)(base[i] & 0xFF), (uint8_t)(base[i] >> 8)};
+        crc = crc32Update(crc, bytes, sizeof(bytes));
+    }
+    return crc32Final(crc);
+}
@@ -0,0 +1,43 @@
+#ifndef WEIGHT_SYNC_H
+#define WEIGHT_SYNC_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "Config.h"
+#include "NeuralNetworkBikeLock.h"
+
+// Keeps an fp16 copy of the weights the central last received (the base) and
+// encodes what changed since as run-length index runs of fp16 deltas. Both sides
+// update the base with the same float add and fp16 rounding, so they stay
+// bit-identical across syncs (see BLEConfig for the wire format).
+class WeightSync {
+public:
+    WeightSync();
+
+    // Snapshot the network as the base the central now holds
+    void rebase(NeuralNetworkBikeLock& nn, uint32_t version);
+    // Forget the base, e.g. after an interrupted delta; the next sync is a full one
+    void invalidate();
+    uint32_t getBaseVersion() const { return baseVersion; }
+
+    // Delta encoder: nextRuns() fills one packet body with runs and applies them
+    // to the base, finishDelta() records the new version
+    void beginDelta();
+    size_t nextRuns(NeuralNetworkBikeLock& nn, uint8_t* body, size_t capacity);
+    bool deltaDone() const { return cursor >= length; }
+    void finishDelta(uint32_t version);
+    uint32_t getChangedCount() const { return changedCount; }
+    uint32_t baseCrc() const;
+
+private:
+    bool encode(float weight, uint16_t baseValue, uint16_t& delta) const;
+
+    uint16_t base[NNConfig::MAX_WEIGHTS];
+    size_t length;
+    uint32_t baseVersion;   // 0: no base
+    size_t cursor;
+    size_t runEnd;
+    uint32_t changedCount;
+};
+
+#endif
@@ -0,0 +1,98 @@
+// Host stand-in for the Arduino core, just enough to build the SmartBikeLock
+// sources on Linux. Time is virtual: every millis()/micros() call advances it by
+// a fixed poll step so the firmware's busy-wait sampling loops terminate without
+// sleeping, and delay() simply moves the clock forward.
+#ifndef REPLAY_ARDUINO_H
+#define REPLAY_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <type_traits>
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+#define PI 3.1415926535897932384626433832795
+#define HALF_PI 1.5707963267948966192313216916398
+#define TWO_PI 6.283185307179586476925286766559
+#define DEG_TO_RAD 0.017453292519943295769236907684886
+#define RAD_TO_DEG 57.295779513082320876798154814105
+
+#define DEC 10
+#define HEX 16
+#define BIN 2
+
+#ifndef sq
+#define sq(x) ((x)*(x))
+#endif
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+// No separate program memory on the host
+#define PROGMEM
+#define F(str) (str)
+#define pgm_read_byte(addr) (*(const uint8_t*)(addr))
+#define pgm_read_word(addr) (*(const uint16_t*)(addr))
+#define pgm_read_dword(addr) (*(const uint32_t*)(addr))
+#define pgm_read_float(addr) (*(const float*)(addr))
+#define pgm_read_float_near(addr) (*(const float*)(addr))
+#define memcpy_P memcpy
+
+// By value: decltype of the conditional alone would be a reference to a parameter
+template <typename T, typename U>
+inline typename std::decay<decltype(true ? T() : U())>::type min(T a, U b) { return (a < b) ? a : b; }
+template <typename T, typename U>
+inline typename std::decay<decltype(true ? T() : U())>::type max(T a, U b) { return (a > b) ? a : b; }
+
+// Virtual clock
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void set_micros(unsigned long long us);      // Jump the clock (harness only)
+void set_poll_step_us(unsigned long us);     // Time that passes per millis()/micros() call
+
+inline void noInterrupts() {}
+inline void interrupts() {}
+
+long random(long howbig);
+long random(long howsmall, long howbig);
+void randomSeed(unsigned long seed);
+
+// Serial output goes to stderr and is muted unless the harness enables it
+class HostSerial {
+public:
+    void begin(unsigned long) {}
+    void end() {}
+    operator bool() const { return true; }
+    void setEnabled(bool enabled_) { enabled = enabled_; }
+
+    size_t print(const char* s);
+    size_t print(char c);
+    size_t print(int n, int base = DEC) { return print((long)n, base); }
+    size_t print(unsigned int n, int base = DEC) { return print((unsigned long)n, base); }
+    size_t print(long n, int base = DEC);
+    size_t print(unsigned long n, int base = DEC);
+    size_t print(long long n, int base = DEC) { return print((long)n, base); }
+    size_t print(unsigned long long n, int base = DEC) { return print((unsigned long)n, base); }
+    size_t print(double n, int digits = 2);
+
+    template <typename T> size_t println(T value) { size_t n = print(value); return n + println(); }
+    template <typename T> size_t println(T value, int format) { size_t n = print(value, format); return n + println(); }
+    size_t println();
+
+    size_t write(uint8_t c) { return print((char)c); }
+    size_t write(const uint8_t* buffer, size_t size);
+    int available() { return 0; }
+    int read() { return -1; }
+    void flush() {}
+
+private:
+    bool enabled = false;
+};
+
+extern HostSerial Serial;
+
+#endif
@@ -0,0 +1,122 @@
+// In-memory BLE stand-in with the subset of the ArduinoBLE API the firmware uses.
+// There is no radio: the harness plays the central through the fake*() calls and
+// reads back what the peripheral notified.
+#ifndef REPLAY_ARDUINO_BLE_H
+#define REPLAY_ARDUINO_BLE_H
+
+#include <Arduino.h>
+#include <string>
+
+enum BLEProperty {
+    BLEBroadcast = 0x01,
+    BLERead = 0x02,
+    BLEWriteWithoutResponse = 0x04,
+    BLEWrite = 0x08,
+    BLENotify = 0x10,
+    BLEIndicate = 0x20
+};
+
+enum BLEDeviceEvent {
+    BLEConnected = 0,
+    BLEDisconnected,
+    BLEDiscovered,
+    BLEDeviceLastEvent
+};
+
+class BLEDevice {
+public:
+    // std::string stands in for Arduino's String: callers only use c_str()
+    std::string address() const { return "00:00:00:00:00:00"; }
+};
+
+typedef void (*BLEDeviceEventHandler)(BLEDevice device);
+
+class BLECharacteristic {
+public:
+    static const int MAX_VALUE_SIZE = 512;
+
+    BLECharacteristic(const char* uuid, uint8_t properties, int valueSize, bool fixedLength = false);
+
+    const char* uuid() const { return _uuid; }
+    uint8_t properties() const { return _properties; }
+    int valueSize() const { return _valueSize; }
+    const uint8_t* value() const { return _value; }
+    int valueLength() const { return _valueLength; }
+
+    // Returns true once per central write
+    bool written();
+    bool subscribed() const { return _subscribed; }
+    int readValue(void* value, int length);
+    template <typename T> int readValue(T& value) { return readValue(&value, sizeof(T)); }
+
+    int writeValue(const uint8_t value[], int length);
+    int writeValue(const void* value, int length) { return writeValue((const uint8_t*)value, length); }
+    template <typename T> int writeValue(T value) { return writeValue((const uint8_t*)&value, sizeof(T)); }
+
+    // Harness side: a central write, and what the peripheral has sent so far
+    typedef void (*FakeNotifyHandler)(const uint8_t* value, int length, void* context);
+    void fakeWrite(const void* value, int length);
+    void fakeSubscribe(bool subscribed) { _subscribed = subscribed; }
+    void fakeOnNotify(FakeNotifyHandler handler, void* context) { _notifyHandler = handler; _notifyContext = context; }
+    unsigned long notifyCount() const { return _notifyCount; }
+    unsigned long notifyBytes() const { return _notifyBytes; }
+
+private:
+    const char* _uuid;
+    uint8_t _properties;
+    int _valueSize;
+    uint8_t _value[MAX_VALUE_SIZE];
+    int _valueLength;
+    bool _written;
+    bool _subscribed;
+    unsigned long _notifyCount;
+    unsigned long _notifyBytes;
+    FakeNotifyHandler _notifyHandler;
+    void* _notifyContext;
+};
+
+class BLEService {
+public:
+    explicit BLEService(const char* uuid) : _uuid(uuid) {}
+    const char* uuid() const { return _uuid; }
+    void addCharacteristic(BLECharacteristic& characteristic);
+
+private:
+    const char* _uuid;
+};
+
+class BLELocalDevice {
+public:
+    int begin() { return 1; }
+    void end() {}
+    void poll(unsigned long = 0);
+    bool connected() const { return _connected; }
+    bool disconnect();
+    std::string address() const { return "00:00:00:00:00:00"; }
+
+    bool setLocalName(const char*) { return true; }
+    bool setAdvertisedService(const BLEService&) { return true; }
+    void setConnectionInterval(uint16_t, uint16_t) {}
+    void addService(BLEService&) {}
+    int advertise() { return 1; }
+    void stopAdvertise() {}
+    void setEventHandler(BLEDeviceEvent event, BLEDeviceEventHandler handler);
+
+    // Harness side: connect or drop the simulated central, look up a characteristic
+    // added to any service by its UUID (nullptr if unknown)
+    void fakeConnect(bool connected);
+    BLECharacteristic* fakeCharacteristic(const char* uuid) const;
+    void fakeRegister(BLECharacteristic& characteristic);
+
+private:
+    static const int MAX_CHARACTERISTICS = 32;
+
+    bool _connected = false;
+    BLECharacteristic* _characteristics[MAX_CHARACTERISTICS] = {};
+    int _characteristicCount = 0;
+    BLEDeviceEventHandler _handlers[BLEDeviceLastEvent] = {};
+};
+
+extern BLELocalDevice BLE;
+
+#endif
@@ -0,0 +1,60 @@
+// Shadows the library header: pulls in the real LSM9DS1Class (its read methods
+// are virtual) and points IMU at a replay subclass fed from recorded data.
+#ifndef REPLAY_ARDUINO_LSM9DS1_H
+#define REPLAY_ARDUINO_LSM9DS1_H
+
+#include "LSM9DS1.h"
+#include <string>
+#include <vector>
+
+// One START_RECORDING ... END_RECORDING block as printed by
+// AnotherSampling::streamDatasets(): accel in g, gyro in deg/s
+struct Recording {
+    int index;
+    int label;
+    std::vector<float> samples;   // AccelX, AccelY, AccelZ, GyroX, GyroY, GyroZ per sample
+
+    static const int CHANNELS = 6;
+    size_t sampleCount() const { return samples.size() / CHANNELS; }
+};
+
+class ReplayIMU : public LSM9DS1Class {
+public:
+    ReplayIMU();
+
+    // Parses the streamed CSV (other serial output in the file is ignored)
+    bool load(const std::string& path);
+    void addRecording(const Recording& recording) { recordings.push_back(recording); }
+    const std::vector<Recording>& getRecordings() const { return recordings; }
+
+    // Replays one recording, or all of them back to back
+    void select(size_t recording);
+    void selectAll();
+    bool exhausted() const;
+    unsigned long samplesRead() const { return readCount; }
+
+    int readAcceleration(float& x, float& y, float& z) override;
+    // Recorded g quantised to the register counts the real sensor would return
+    int readRawAcceleration(int16_t& x, int16_t& y, int16_t& z) override;
+    int accelerationAvailable() override;
+    float accelerationSampleRate() override;
+    int readGyroscope(float& x, float& y, float& z) override;
+    int gyroscopeAvailable() override;
+    float gyroscopeSampleRate() override;
+
+private:
+    std::vector<Recording> recordings;
+    size_t first;          // Range of recordings being replayed
+    size_t last;
+    size_t current;
+    size_t position;       // Sample within recordings[current]
+    unsigned long readCount;
+
+    const float* nextSample();
+};
+
+extern ReplayIMU IMU_REPLAY;
+#undef IMU
+#define IMU IMU_REPLAY
+
+#endif
@@ -0,0 +1,43 @@
+// Host stand-in for the nRF52840 flash behind ModelStore: the same four helpers
+// ModelStore.cpp defines over mbed::FlashIAP, on a RAM copy of the model region.
+// Erased NOR flash reads 0xFF and programming can only clear bits. Only
+// ModelStore.cpp includes it, when built with SIMULATED_FLASH.
+#ifndef REPLAY_SIMULATED_FLASH_H
+#define REPLAY_SIMULATED_FLASH_H
+
+#include <stdint.h>
+#include <string.h>
+#include "Config.h"
+
+namespace {
+    alignas(16) uint8_t simulatedFlash[StoreConfig::REGION_SIZE];
+    bool simulatedFlashErased = false;
+
+    bool flashBegin(uint32_t& address) {
+        if (!simulatedFlashErased) {
+            memset(simulatedFlash, 0xFF, sizeof(simulatedFlash));
+            simulatedFlashErased = true;
+        }
+        address = 0;
+        return true;
+    }
+
+    const uint8_t* flashMap(uint32_t address) {
+        return simulatedFlash + address;
+    }
+
+    bool flashErase(uint32_t address, size_t size) {
+        memset(simulatedFlash + address, 0xFF, size);
+        return true;
+    }
+
+    bool flashProgram(uint32_t address, const void* data, size_t size) {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < size; i++) {
+            simulatedFlash[address + i] &= bytes[i];
+        }
+        return true;
+    }
+}
+
+#endif
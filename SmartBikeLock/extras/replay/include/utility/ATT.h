@@ -0,0 +1,21 @@
+// Stand-in for ArduinoBLE's ATT layer: only the negotiated MTU, which the harness sets
+#ifndef REPLAY_ATT_H
+#define REPLAY_ATT_H
+
+#include <Arduino.h>
+
+class ATTClass {
+public:
+    // 23 until the central negotiates more, like a fresh connection
+    uint16_t mtu() const;
+
+    // Harness side: the MTU the simulated central exchanged
+    void fakeSetMtu(uint16_t mtu) { _mtu = mtu; }
+
+private:
+    uint16_t _mtu = 23;
+};
+
+extern ATTClass& ATT;
+
+#endif
@@ -0,0 +1,28 @@
+// Stand-in for ArduinoBLE's HCI layer: models the controller's ACL buffer credits.
+// Every notification takes a buffer; poll() plays a connection event that sends
+// all of them. A send with no free buffer counts as a stall, where the real
+// sendAclPkt() would have blocked in poll().
+#ifndef REPLAY_HCI_H
+#define REPLAY_HCI_H
+
+#include <Arduino.h>
+
+class HCIClass {
+public:
+    void poll() { _pendingPkt = 0; }
+    uint8_t availableAclPackets() const { return (_pendingPkt < _maxPkt) ? (_maxPkt - _pendingPkt) : 0; }
+
+    // Harness side
+    void fakeSetAclBuffers(uint8_t maxPkt) { _maxPkt = maxPkt; _pendingPkt = 0; }
+    void fakeSendAclPkt();
+    unsigned long fakeStalls() const { return _stalls; }
+
+private:
+    uint8_t _maxPkt = 4;
+    uint8_t _pendingPkt = 0;
+    unsigned long _stalls = 0;
+};
+
+extern HCIClass& HCI;
+
+#endif
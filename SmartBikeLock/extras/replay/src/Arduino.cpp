@@ -0,0 +1,83 @@
+#include <Arduino.h>
+#include <stdio.h>
+
+HostSerial Serial;
+
+static unsigned long long currentMicros = 0;
+static unsigned long pollStepUs = 1000;
+
+unsigned long micros() {
+    unsigned long now = (unsigned long)currentMicros;
+    currentMicros += pollStepUs;
+    return now;
+}
+
+unsigned long millis() {
+    unsigned long now = (unsigned long)(currentMicros / 1000);
+    currentMicros += pollStepUs;
+    return now;
+}
+
+void delay(unsigned long ms) {
+    currentMicros += (unsigned long long)ms * 1000;
+}
+
+void delayMicroseconds(unsigned int us) {
+    currentMicros += us;
+}
+
+void set_micros(unsigned long long us) {
+    currentMicros = us;
+}
+
+void set_poll_step_us(unsigned long us) {
+    pollStepUs = us;
+}
+
+long random(long howbig) {
+    if (howbig == 0) return 0;
+    return rand() % howbig;
+}
+
+long random(long howsmall, long howbig) {
+    if (howsmall >= howbig) return howsmall;
+    return random(howbig - howsmall) + howsmall;
+}
+
+void randomSeed(unsigned long seed) {
+    if (seed != 0) srand((unsigned int)seed);
+}
+
+size_t HostSerial::print(const char* s) {
+    if (!enabled) return strlen(s);
+    return fputs(s, stderr) >= 0 ? strlen(s) : 0;
+}
+
+size_t HostSerial::print(char c) {
+    if (enabled) fputc(c, stderr);
+    return 1;
+}
+
+size_t HostSerial::print(long n, int base) {
+    if (!enabled) return 0;
+    return fprintf(stderr, base == HEX ? "%lX" : "%ld", n);
+}
+
+size_t HostSerial::print(unsigned long n, int base) {
+    if (!enabled) return 0;
+    return fprintf(stderr, base == HEX ? "%lX" : "%lu", n);
+}
+
+size_t HostSerial::print(double n, int digits) {
+    if (!enabled) return 0;
+    return fprintf(stderr, "%.*f", digits, n);
+}
+
+size_t HostSerial::println() {
+    return print('\n');
+}
+
+size_t HostSerial::write(const uint8_t* buffer, size_t size) {
+    if (enabled) fwrite(buffer, 1, size, stderr);
+    return size;
+}
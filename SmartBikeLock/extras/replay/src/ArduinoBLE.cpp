@@ -0,0 +1,116 @@
+#include <ArduinoBLE.h>
+#include <utility/ATT.h>
+#include <utility/HCI.h>
+#include <strings.h>
+
+BLELocalDevice BLE;
+
+static ATTClass ATTObj;
+ATTClass& ATT = ATTObj;
+static HCIClass HCIObj;
+HCIClass& HCI = HCIObj;
+
+uint16_t ATTClass::mtu() const {
+    return BLE.connected() ? _mtu : 23;
+}
+
+void HCIClass::fakeSendAclPkt() {
+    if (_pendingPkt >= _maxPkt) {
+        _stalls++;
+        poll();
+    }
+    _pendingPkt++;
+}
+
+BLECharacteristic::BLECharacteristic(const char* uuid, uint8_t properties, int valueSize, bool) :
+    _uuid(uuid),
+    _properties(properties),
+    _valueSize(min(valueSize, MAX_VALUE_SIZE)),
+    _valueLength(0),
+    _written(false),
+    _subscribed(false),
+    _notifyCount(0),
+    _notifyBytes(0),
+    _notifyHandler(nullptr),
+    _notifyContext(nullptr)
+{
+    memset(_value, 0, sizeof(_value));
+}
+
+bool BLECharacteristic::written() {
+    bool result = _written;
+    _written = false;
+    return result;
+}
+
+int BLECharacteristic::readValue(void* value, int length) {
+    int n = min(length, _valueLength);
+    memcpy(value, _value, n);
+    return n;
+}
+
+int BLECharacteristic::writeValue(const uint8_t value[], int length) {
+    if (length > _valueSize) return 0;
+    memcpy(_value, value, length);
+    _valueLength = length;
+    if ((_properties & (BLENotify | BLEIndicate)) && BLE.connected()) {
+        // The peer only gets what fits the MTU, as in ATTClass::handleNotify()
+        length = min(length, ATT.mtu() - 3);
+        HCI.fakeSendAclPkt();
+        _notifyCount++;
+        _notifyBytes += length;
+        if (_notifyHandler) {
+            _notifyHandler(value, length, _notifyContext);
+        }
+    }
+    return 1;
+}
+
+void BLECharacteristic::fakeWrite(const void* value, int length) {
+    _valueLength = min(length, _valueSize);
+    memcpy(_value, value, _valueLength);
+    _written = true;
+}
+
+void BLEService::addCharacteristic(BLECharacteristic& characteristic) {
+    BLE.fakeRegister(characteristic);
+}
+
+void BLELocalDevice::poll(unsigned long) {
+    HCI.poll();
+}
+
+bool BLELocalDevice::disconnect() {
+    fakeConnect(false);
+    return true;
+}
+
+void BLELocalDevice::setEventHandler(BLEDeviceEvent event, BLEDeviceEventHandler handler) {
+    if (event < BLEDeviceLastEvent) {
+        _handlers[event] = handler;
+    }
+}
+
+void BLELocalDevice::fakeConnect(bool connected) {
+    if (connected == _connected) return;
+    _connected = connected;
+    BLEDeviceEventHandler handler = _handlers[connected ? BLEConnected : BLEDisconnected];
+    if (handler) {
+        handler(BLEDevice());
+    }
+}
+
+void BLELocalDevice::fakeRegister(BLECharacteristic& characteristic) {
+    if (fakeCharacteristic(characteristic.uuid()) == nullptr && _characteristicCount < MAX_CHARACTERISTICS) {
+        _characteristics[_characteristicCount++] = &characteristic;
+    }
+}
+
+BLECharacteristic* BLELocalDevice::fakeCharacteristic(const char* uuid) const {
+    for (int i = 0; i < _characteristicCount; i++) {
+        if (strcasecmp(_characteristics[i]->uuid(), uuid) == 0) {
+            return _characteristics[i];
+        }
+    }
+    return nullptr;
+}
@@ -0,0 +1,130 @@
+#include <Arduino_LSM9DS1.h>
+#include <Wire.h>
+#include <fstream>
+#include <stdio.h>
+
+ReplayIMU IMU_REPLAY;
+
+ReplayIMU::ReplayIMU() :
+    LSM9DS1Class(Wire), first(0), last(0), current(0), position(0), readCount(0) {
+}
+
+bool ReplayIMU::load(const std::string& path) {
+    std::ifstream file(path.c_str());
+    if (!file) return false;
+
+    std::string line;
+    bool inRecording = false;
+    Recording recording;
+
+    while (std::getline(file, line)) {
+        if (!line.empty() && line[line.size() - 1] == '\r') {
+            line.erase(line.size() - 1);
+        }
+        if (line.compare(0, 16, "START_RECORDING,") == 0) {
+            recording = Recording();
+            if (sscanf(line.c_str() + 16, "%d,%d", &recording.index, &recording.label) != 2) {
+                continue;
+            }
+            inRecording = true;
+        } else if (line == "END_RECORDING") {
+            if (inRecording && recording.sampleCount() > 0) {
+                recordings.push_back(recording);
+            }
+            inRecording = false;
+        } else if (inRecording) {
+            int sample;
+            float v[Recording::CHANNELS];
+            // Header line and anything else that doesn't parse is skipped
+            if (sscanf(line.c_str(), "%d,%f,%f,%f,%f,%f,%f", &sample,
+                       &v[0], &v[1], &v[2], &v[3], &v[4], &v[5]) == 1 + Recording::CHANNELS) {
+                recording.samples.insert(recording.samples.end(), v, v + Recording::CHANNELS);
+            }
+        }
+    }
+    return !recordings.empty();
+}
+
+void ReplayIMU::select(size_t recording) {
+    first = recording;
+    last = recording + 1;
+    current = first;
+    position = 0;
+}
+
+void ReplayIMU::selectAll() {
+    first = 0;
+    last = recordings.size();
+    current = first;
+    position = 0;
+}
+
+bool ReplayIMU::exhausted() const {
+    return current >= last || current >= recordings.size();
+}
+
+const float* ReplayIMU::nextSample() {
+    while (!exhausted() && position >= recordings[current].sampleCount()) {
+        current++;
+        position = 0;
+    }
+    if (exhausted()) return nullptr;
+    return &recordings[current].samples[Recording::CHANNELS * position++];
+}
+
+int ReplayIMU::readAcceleration(float& x, float& y, float& z) {
+    const float* sample = nextSample();
+    if (!sample) {
+        x = y = z = NAN;
+        return 0;
+    }
+    x = sample[0];
+    y = sample[1];
+    z = sample[2];
+    readCount++;
+    return 1;
+}
+
+int ReplayIMU::readRawAcceleration(int16_t& x, int16_t& y, int16_t& z) {
+    float g[3];
+    if (!readAcceleration(g[0], g[1], g[2])) {
+        x = y = z = 0;
+        return 0;
+    }
+    int16_t* counts[3] = {&x, &y, &z};
+    for (int i = 0; i < 3; i++) {
+        long c = lroundf(g[i] * 32768.0f / 4.0f);
+        *counts[i] = (int16_t)(c < -32768 ? -32768 : (c > 32767 ? 32767 : c));
+    }
+    return 1;
+}
+
+int ReplayIMU::accelerationAvailable() {
+    // A sample is "in the FIFO" as long as the recording has data left
+    return exhausted() ? 0 : 1;
+}
+
+float ReplayIMU::accelerationSampleRate() {
+    return 119.0f;
+}
+
+int ReplayIMU::readGyroscope(float& x, float& y, float& z) {
+    // Gyro values belong to the sample last returned by readAcceleration()
+    if (exhausted() || position == 0) {
+        x = y = z = 0;
+        return 0;
+    }
+    const float* sample = &recordings[current].samples[Recording::CHANNELS * (position - 1)];
+    x = sample[3];
+    y = sample[4];
+    z = sample[5];
+    return 1;
+}
+
+int ReplayIMU::gyroscopeAvailable() {
+    return exhausted() ? 0 : 1;
+}
+
+float ReplayIMU::gyroscopeSampleRate() {
+    return 119.0f;
+}
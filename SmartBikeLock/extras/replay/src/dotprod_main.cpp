@@ -0,0 +1,94 @@
+// Dot-product backend check for the NeuralNetwork library.
+//
+// CMakeLists.txt builds this once per SIMD_BACKEND the host compiler can target
+// and per weight layout (flat REDUCE_RAM_WEIGHTS_LVL2 as NeuralNetworkBikeLock
+// uses it, and per-row). FeedForwardBatch always sums in the plain loop's order,
+// so it is the reference: the scalar build must match FeedForward bit for bit,
+// the vector builds within TOLERANCE. Each network also gets one benchmark row.
+//
+// Exit status is 0 on success, 1 on a mismatch and 77 (skipped) if this CPU
+// lacks the instructions the build targets.
+
+#include <Arduino.h>
+#include <NeuralNetwork.h>
+
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+
+namespace {
+
+// Outputs are sigmoids in [0, 1], the vector backends only reorder the sums
+const float TOLERANCE = 1e-5f;
+const unsigned int SAMPLES = 64;
+
+typedef std::chrono::steady_clock Clock;
+
+bool checkNetwork(const unsigned int* layers, const char* name) {
+    const unsigned int inputs = layers[0];
+    const unsigned int outputs = layers[2];
+    const unsigned long macs = (unsigned long)layers[0] * layers[1] + (unsigned long)layers[1] * layers[2];
+
+    randomSeed(1);
+    NeuralNetwork nn(layers, 3);
+    float* x = new float[SAMPLES * inputs];
+    float* expected = new float[SAMPLES * outputs];
+    for (unsigned int i = 0; i < SAMPLES * inputs; i++) {
+        x[i] = random(-1000, 1000) / 1000.0f;
+    }
+    nn.FeedForwardBatch(x, SAMPLES, expected);
+
+    float maxDiff = 0;
+    bool exact = true;
+    for (unsigned int s = 0; s < SAMPLES; s++) {
+        const float* y = nn.FeedForward(&x[s * inputs]);
+        exact = exact && memcmp(y, &expected[s * outputs], outputs * sizeof(float)) == 0;
+        for (unsigned int i = 0; i < outputs; i++) {
+            float d = fabsf(y[i] - expected[s * outputs + i]);
+            maxDiff = d > maxDiff ? d : maxDiff;
+        }
+    }
+
+    // About 20 ms of FeedForward per network
+    const unsigned long passes = 20000000UL / (macs * SAMPLES) + 1;
+    Clock::time_point start = Clock::now();
+    for (unsigned long p = 0; p < passes; p++) {
+        for (unsigned int s = 0; s < SAMPLES; s++) {
+            nn.FeedForward(&x[s * inputs]);
+        }
+    }
+    double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / (passes * SAMPLES);
+
+    bool scalar = strcmp(SIMD_BACKEND, "scalar") == 0;
+    bool ok = scalar ? exact : maxDiff <= TOLERANCE;
+    printf("  %-9s %-5s %-11s %10.0f ns %8.0f MMAC/s   max diff %-8.2g %s\n", SIMD_BACKEND,
+#if defined(REDUCE_RAM_WEIGHTS_LVL2)
+           "flat",
+#else
+           "rows",
+#endif
+           name, ns, macs * 1e3 / ns, maxDiff, ok ? "ok" : (scalar ? "FAILED: not bit-exact" : "FAILED: above tolerance"));
+
+    delete[] x;
+    delete[] expected;
+    return ok;
+}
+
+}
+
+int main() {
+#if defined(AVX2_SUPPORTS_SIMD)
+    if (!__builtin_cpu_supports("avx2") || !__builtin_cpu_supports("fma")) {
+        printf("  %-9s skipped, this CPU has no AVX2/FMA\n", SIMD_BACKEND);
+        return 77;
+    }
+#endif
+
+    const unsigned int bikeLock[] = {11, 1000, 3};     // NNConfig::LAYERS
+    const unsigned int aligned[] = {64, 128, 10};
+    const unsigned int ragged[] = {13, 37, 5};         // Every vector tail length
+    bool ok = checkNetwork(bikeLock, "11-1000-3");
+    ok = checkNetwork(aligned, "64-128-10") && ok;
+    ok = checkNetwork(ragged, "13-37-5") && ok;
+    return ok ? 0 : 1;
+}
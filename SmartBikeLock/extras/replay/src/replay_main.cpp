@@ -0,0 +1,1873 @@
+// Host replay harness for SmartBikeLock.
+//
+// Runs the firmware's SignalProcessing, NeuralNetworkBikeLock and Communication
+// code against recorded IMU data and reports per-stage timings in nanoseconds
+// plus window throughput. Recordings use the CSV AnotherSampling streams over
+// serial (START_RECORDING,<index>,<label> ... END_RECORDING).
+//
+//   replay [options] [recordings.csv]
+//     --continuous    Drive startContinuous()/update() over all recordings back to back
+//     --sdft          Use the sliding DFT feature engine (implies --continuous)
+//     --repeat N      Replay the data set N times (default 1)
+//     --synthetic N   Add N generated recordings per class (used when no CSV is given)
+//     --benchmark N   Run the inference and the training TimingBenchmark for N iterations
+//                     in budgeted slices via the BLE benchmark characteristic, print the
+//                     binary records and check that training left the weights as they were
+//     --weights       Round-trip the weights over the streaming GET/SET transfer, with a
+//                     disconnect and resume in each direction, and check offsets, CRC,
+//                     error handling and that SET only switches to complete, intact weights
+//     --delta N       Delta-sync the weights after N live training steps and compare the
+//                     stream size with a full transfer
+//     --mtu N         ATT MTU the simulated central negotiates (default 247)
+//     --train N       Store every recording in the replay buffer and run N background
+//                     epochs in loop()-sized slices, checking loss and BLE progress
+//     --stream        Subscribe to the batched prediction stream and check every record
+//     --scheduler     Drive the task scheduler from a virtual clock and check release
+//                     counts, earliest-deadline order, overrun and deadline-miss statistics
+//     --log           Check the deferred log ring: overflow, drop count, idle draining
+//     --backends N    Run N inferences and N training steps on the static and the dynamic
+//                     network backend from the same seed, compare timings and check
+//                     that outputs and trained weights agree and that training steps
+//                     make no heap allocation
+//     --batch N       Classify the same windows one at a time and in batches of 1, 2, 4 ... N
+//                     on the dynamic network, print throughput per batch size and check
+//                     that batched outputs are bit-identical (within 1e-5 when FeedForward
+//                     uses a vector dot-product)
+//     --prune P       Magnitude-prune the network to P percent sparsity and compare the sparse
+//                     kernel with dense inference: MACs, time, accuracy, CSR size
+//     --cascade P     Train, then classify every recording with the two-stage cascade at a
+//                     P percent threshold and compare cost and accuracy with the full network;
+//                     also an untrained first stage, SET_CASCADE and GET_CASCADE_STATS
+//     --store         Save the weights to the simulated flash region and boot networks from it:
+//                     in-place reads, copy on first training step, a read-only IN_PLACE model,
+//                     CRC and erase handling
+//     --q15           Run the float and the fixed-point feature engines on the same raw windows
+//                     and check that the Q15 features stay within 0.1% of the largest float one
+//     --features N    Time the legacy three-pass feature extractor and FeaturePlan::extract()
+//                     N times per window and check that their features agree within 1e-5
+//     --fft           Run computeReal() + complexToMagnitudeReal() and the complex compute() +
+//                     complexToMagnitude() on every window and check that all SAMPLES/2 + 1
+//                     magnitudes agree within 1e-5 of the largest one
+//     --verbose       Show the firmware's log on stderr, drained at exit
+//
+// Exit status is non-zero if no window was classified or a prediction was not finite.
+
+#include <Arduino.h>
+#include <Arduino_LSM9DS1.h>
+#include <ArduinoBLE.h>
+
+#include "Config.h"
+#include "SignalProcessing.h"
+#include "NeuralNetworkBikeLock.h"
+#include "Communication.h"
+#include "FeaturePlan.h"
+#include "TimingBenchmark.h"
+#include "Crc32.h"
+#include "Float16.h"
+#include "Log.h"
+#include "Scheduler.h"
+#include "ModelStore.h"
+#include <utility/ATT.h>
+#include <utility/HCI.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <new>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+// Every operator new in the process, so a check can show that a code path leaves the heap alone
+static size_t heapAllocations = 0;
+
+void* operator new(size_t size) {
+    heapAllocations++;
+    void* p = malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+void* operator new[](size_t size) { return operator new(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    heapAllocations++;
+    return malloc(size ? size : 1);
+}
+void* operator new[](size_t size, const std::nothrow_t& tag) noexcept { return operator new(size, tag); }
+void operator delete(void* p) noexcept { free(p); }
+void operator delete[](void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+void operator delete[](void* p, size_t) noexcept { free(p); }
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+uint64_t elapsedNs(Clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+}
+
+class StageTimer {
+public:
+    explicit StageTimer(const char* name_) : name(name_) {}
+
+    void add(uint64_t ns) { samples.push_back(ns); }
+    uint64_t total() const {
+        uint64_t sum = 0;
+        for (size_t i = 0; i < samples.size(); i++) sum += samples[i];
+        return sum;
+    }
+
+    void print() {
+        if (samples.empty()) return;
+        std::sort(samples.begin(), samples.end());
+        printf("  %-18s n=%-6zu mean=%10.0f  p50=%10llu  p99=%10llu  max=%10llu\n",
+               name, samples.size(), (double)total() / samples.size(),
+               (unsigned long long)percentile(0.50), (unsigned long long)percentile(0.99),
+               (unsigned long long)samples.back());
+    }
+
+private:
+    const char* name;
+    std::vector<uint64_t> samples;
+
+    uint64_t percentile(double p) const {
+        size_t i = (size_t)(p * (samples.size() - 1) + 0.5);
+        return samples[i];
+    }
+};
+
+// Three classes with distinct spectra: resting noise, slow sway while being
+// carried away, and high-frequency vibration from working on the lock
+void addSyntheticRecordings(ReplayIMU& imu, int perClass) {
+    srand(1234);
+    int index = 0;
+    for (int n = 0; n < perClass; n++) {
+        for (int label = 0; label < 3; label++) {
+            Recording recording;
+            recording.index = index++;
+            recording.label = label;
+            float phase = (rand() % 1000) / 1000.0f * TWO_PI;
+            for (unsigned int i = 0; i < SignalConfig::SAMPLES; i++) {
+                float t = (float)i / SignalConfig::SAMPLING_FREQ;
+                float noise = ((rand() % 2001) - 1000) / 1000.0f * 0.01f;
+                float x = noise;
+                if (label == 1) x += 0.3f * sin(TWO_PI * 1.5f * t + phase) + 0.1f * sin(TWO_PI * 4.0f * t);
+                if (label == 2) x += 0.5f * sin(TWO_PI * 22.0f * t + phase) + 0.2f * sin(TWO_PI * 37.0f * t);
+                float sample[Recording::CHANNELS] = {x, noise, 1.0f + noise, 0, 0, 0};
+                recording.samples.insert(recording.samples.end(), sample, sample + Recording::CHANNELS);
+            }
+            imu.addRecording(recording);
+        }
+    }
+}
+
+bool allFinite(const float* values, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        if (!isfinite(values[i])) return false;
+    }
+    return true;
+}
+
+int argmax(const float* values, size_t length) {
+    int best = 0;
+    for (size_t i = 1; i < length; i++) {
+        if (values[i] > values[best]) best = (int)i;
+    }
+    return best;
+}
+
+// Same steps as SignalProcessing::processData(), timed one by one
+void timeDspBreakdown(const Recording& recording, StageTimer& window, StageTimer& fft,
+                      StageTimer& magnitude, StageTimer& features) {
+    typedef FeaturePlan<SignalConfig::SAMPLES, SignalConfig::SAMPLING_FREQ, SignalConfig::FreqBands> Plan;
+    static float vReal[SignalConfig::SAMPLES];
+    float out[SignalConfig::TOTAL_FEATURES];
+    ArduinoFFT<float> dsp(vReal, nullptr, SignalConfig::SAMPLES, SignalConfig::SAMPLING_FREQ);
+
+    for (unsigned int i = 0; i < SignalConfig::SAMPLES; i++) {
+        size_t s = min((size_t)i, recording.sampleCount() - 1);
+        vReal[i] = recording.samples[Recording::CHANNELS * s] * 9.81f;
+    }
+
+    Clock::time_point t = Clock::now();
+    dsp.dcRemoval();
+    dsp.windowing(FFTWindow::Hamming, FFTDirection::Forward);
+    window.add(elapsedNs(t));
+
+    t = Clock::now();
+    dsp.computeReal();
+    fft.add(elapsedNs(t));
+
+    t = Clock::now();
+    dsp.complexToMagnitudeReal();
+    magnitude.add(elapsedNs(t));
+
+    t = Clock::now();
+    Plan::extract(vReal, out);
+    features.add(elapsedNs(t));
+}
+
+// Features and label of one window per recording
+void collectFeatureSet(SignalProcessing& signalProc, std::vector<std::vector<float> >& features,
+                       std::vector<int>& labels) {
+    const std::vector<Recording>& recordings = IMU.getRecordings();
+    for (size_t i = 0; i < recordings.size(); i++) {
+        IMU.select(i);
+        signalProc.collectData();
+        signalProc.processData();
+        features.push_back(std::vector<float>(signalProc.getFeatures(), signalProc.getFeatures() + NNConfig::NUM_INPUTS));
+        labels.push_back(recordings[i].label);
+    }
+}
+
+// The three-pass extractor SignalProcessing used before FeaturePlan: band sums
+// with runtime boundaries, then mean/max, then a second pass for the variance.
+// Kept as the reference for --features.
+void legacyExtractFeatures(const float* vReal, float* features) {
+    for(int bin = 0; bin < SignalConfig::FEATURE_BINS; bin++) {
+        float binEnergy = 0;
+        int startIndex = (SignalConfig::FreqBands::edge(bin) * SignalConfig::SAMPLES) / SignalConfig::SAMPLING_FREQ;
+        int endIndex = (SignalConfig::FreqBands::edge(bin + 1) * SignalConfig::SAMPLES) / SignalConfig::SAMPLING_FREQ;
+
+        for(int i = startIndex; i < endIndex; i++) {
+            binEnergy += vReal[i];
+        }
+        features[bin] = binEnergy / (endIndex - startIndex);
+    }
+
+    float mean = 0, maxVal = 0;
+    for(int i = 0; i < SignalConfig::SAMPLES/2; i++) {
+        mean += vReal[i];
+        if(vReal[i] > maxVal) maxVal = vReal[i];
+    }
+    mean /= (SignalConfig::SAMPLES/2);
+
+    float variance = 0;
+    for(int i = 0; i < SignalConfig::SAMPLES/2; i++) {
+        float diff = vReal[i] - mean;
+        variance += diff * diff;
+    }
+    variance /= (SignalConfig::SAMPLES/2);
+
+    features[SignalConfig::FEATURE_BINS] = mean;
+    features[SignalConfig::FEATURE_BINS + 1] = maxVal;
+    features[SignalConfig::FEATURE_BINS + 2] = sqrt(variance);
+}
+
+// Plays the sketch's benchmark task: sends the command, times a collected window
+// in budgeted slices with BLE serviced in between. Returns the slices it took.
+int runBenchmarkCommand(Communication& bleComm, TimingBenchmark& benchmark, SignalProcessing& signalProc,
+                        Command command, TimingBenchmark::Kind kind) {
+    uint8_t value = static_cast<uint8_t>(command);
+    BLE.fakeCharacteristic(BLEConfig::CONTROL_CHAR_UUID)->fakeWrite(&value, sizeof(value));
+    bleComm.update();
+
+    IMU.select(0);
+    signalProc.collectData();
+    if (!benchmark.begin(kind, bleComm.getTrainingLabel(), bleComm.getBenchmarkIterations(), bleComm.getBenchmarkWarmup())) {
+        return 0;
+    }
+    int slices = 1;
+    // Far below the firmware's slice, so even the host needs several
+    while (!benchmark.step(100)) {
+        bleComm.update();
+        slices++;
+    }
+    bleComm.sendBenchmarkReport(reinterpret_cast<const uint8_t*>(&benchmark.getRecord()),
+                                sizeof(TimingBenchmark::Record));
+    bleComm.resetState();
+    return slices;
+}
+
+// Plays the central: writes the settings, runs an inference and a training benchmark and
+// reads back the records. Training benchmarks must leave weights and version untouched,
+// also when a new command aborts them halfway.
+int runBenchmark(Communication& bleComm, NeuralNetworkBikeLock& nn, SignalProcessing& signalProc, uint16_t iterations) {
+    static TimingBenchmark benchmark(nn, signalProc);
+    uint16_t settings[2] = {iterations, 2};
+    BLE.fakeCharacteristic(BLEConfig::BENCHMARK_CHAR_UUID)->fakeWrite(settings, sizeof(settings));
+    int8_t label = 1;
+    BLE.fakeCharacteristic(BLEConfig::LABEL_CHAR_UUID)->fakeWrite(&label, sizeof(label));
+
+    std::vector<float> before(nn.getTotalWeights()), after(nn.getTotalWeights());
+    nn.getWeights(before.data(), before.size());
+    const uint32_t version = nn.getVersion();
+
+    BLECharacteristic* report = BLE.fakeCharacteristic(BLEConfig::BENCHMARK_CHAR_UUID);
+    static const char* const names[2][TimingBenchmark::NUM_STAGES] = {{"features", "inference", "total"},
+                                                                      {"features", "training", "total"}};
+    const Command commands[2] = {Command::START_INFERENCE_BENCHMARK, Command::START_TRAINING_BENCHMARK};
+    for (int k = 0; k < 2; k++) {
+        TimingBenchmark::Kind kind = static_cast<TimingBenchmark::Kind>(k);
+        int slices = runBenchmarkCommand(bleComm, benchmark, signalProc, commands[k], kind);
+        TimingBenchmark::Record record;
+        if (slices == 0 || report->notifyCount() != (uint32_t)k + 1 ||
+            report->readValue(&record, sizeof(record)) != sizeof(record) || record.kind != k) {
+            fprintf(stderr, "FAILED: benchmark record not sent\n");
+            return 1;
+        }
+
+        printf("Benchmark record v%u (%s): %u iterations in %d slices, %lu ticks/s, %zu bytes\n", record.version,
+               k ? "training" : "inference", record.iterations, slices, (unsigned long)record.tickHz, sizeof(record));
+        printf("  %-10s %10s %10s %10s %10s %10s\n", "stage", "min", "p50", "p95", "p99", "max");
+        for (int s = 0; s < TimingBenchmark::NUM_STAGES; s++) {
+            const TimingBenchmark::StageSummary& st = record.stages[s];
+            printf("  %-10s %10lu %10lu %10lu %10lu %10lu\n", names[k][s], (unsigned long)st.min, (unsigned long)st.p50,
+                   (unsigned long)st.p95, (unsigned long)st.p99, (unsigned long)st.max);
+            if (!(st.min <= st.p50 && st.p50 <= st.p95 && st.p95 <= st.p99 && st.p99 <= st.max)) {
+                fprintf(stderr, "FAILED: percentiles out of order\n");
+                return 1;
+            }
+        }
+        if (record.iterations != iterations) {
+            fprintf(stderr, "FAILED: %u iterations recorded, %u requested\n", record.iterations, iterations);
+            return 1;
+        }
+    }
+
+    // A command written mid-benchmark aborts it, the way serviceBle() does
+    IMU.select(0);
+    signalProc.collectData();
+    benchmark.begin(TimingBenchmark::Kind::TRAINING, label, iterations, 0);
+    benchmark.step(100);
+    bool abortedMidway = benchmark.isRunning();
+    benchmark.abort();
+
+    nn.getWeights(after.data(), after.size());
+    bool restored = before == after && nn.getVersion() == version;
+    printf("Training benchmarks (one aborted %s): weights and version %s\n", abortedMidway ? "midway" : "after finishing",
+           restored ? "restored" : "CHANGED");
+    if (!restored) {
+        fprintf(stderr, "FAILED: training benchmark changed the deployed model\n");
+        return 1;
+    }
+    return 0;
+}
+
+void collectPacket(const uint8_t* value, int length, void* context) {
+    static_cast<std::vector<std::vector<uint8_t> >*>(context)->push_back(std::vector<uint8_t>(value, value + length));
+}
+
+void sendCommand(Communication& bleComm, Command command) {
+    uint8_t value = static_cast<uint8_t>(command);
+    BLE.fakeCharacteristic(BLEConfig::CONTROL_CHAR_UUID)->fakeWrite(&value, sizeof(value));
+    bleComm.update();
+}
+
+uint32_t packetOffset(const std::vector<uint8_t>& packet) {
+    uint32_t offset;
+    memcpy(&offset, packet.data(), sizeof(offset));
+    return offset;
+}
+
+Communication::TransferStatus readTransferStatus() {
+    Communication::TransferStatus status = {};
+    BLE.fakeCharacteristic(BLEConfig::TRANSFER_CHAR_UUID)->readValue(&status, sizeof(status));
+    return status;
+}
+
+// Drops and restores the link the way a central would see it
+void reconnect(Communication& bleComm, bool connected) {
+    BLE.fakeConnect(connected);
+    bleComm.update();
+}
+
+// Ideal 2M PHY airtime of one notification: LL packet plus empty ack and two T_IFS gaps
+unsigned long airtimeUs2M(size_t attPayload) {
+    const size_t overhead = 2 + 4 + 2 + 3;      // Preamble, access address, LL header, CRC
+    const size_t llPayload = attPayload + 3 + 4;  // ATT opcode and handle, L2CAP header
+    return (unsigned long)((overhead + llPayload) * 4 + 150 + overhead * 4 + 150);
+}
+
+// Central writes packets [from, to); returns what the last receiveWeights() call reported
+bool writePackets(Communication& bleComm, NeuralNetworkBikeLock& nn, const std::vector<std::vector<uint8_t> >& packets,
+                  size_t from, size_t to) {
+    BLECharacteristic* write = BLE.fakeCharacteristic(BLEConfig::WEIGHTS_WRITE_CHAR_UUID);
+    bool result = false;
+    for (size_t i = from; i < to; i++) {
+        write->fakeWrite(packets[i].data(), (int)packets[i].size());
+        bleComm.update();
+        result = bleComm.receiveWeights(nn);
+        if (result && i + 1 != packets.size()) return false;   // Completed early
+    }
+    return result;
+}
+
+// Plays the central for SET_WEIGHTS
+bool pushPackets(Communication& bleComm, NeuralNetworkBikeLock& nn, const std::vector<std::vector<uint8_t> >& packets) {
+    sendCommand(bleComm, Command::SET_WEIGHTS);
+    return writePackets(bleComm, nn, packets, 0, packets.size());
+}
+
+std::vector<std::vector<uint8_t> > buildPackets(const std::vector<float>& weights, size_t chunkFloats, uint32_t crcXor) {
+    std::vector<std::vector<uint8_t> > packets;
+    uint32_t crc = CRC32_INIT;
+    for (size_t offset = 0; offset < weights.size(); offset += chunkFloats) {
+        size_t n = min(chunkFloats, weights.size() - offset);
+        std::vector<uint8_t> packet(BLEConfig::WEIGHT_HEADER_SIZE + n * sizeof(float));
+        uint32_t header = (uint32_t)offset;
+        memcpy(packet.data(), &header, sizeof(header));
+        memcpy(&packet[BLEConfig::WEIGHT_HEADER_SIZE], &weights[offset], n * sizeof(float));
+        crc = crc32Update(crc, &packet[BLEConfig::WEIGHT_HEADER_SIZE], n * sizeof(float));
+        packets.push_back(packet);
+    }
+    uint32_t trailer[3] = {BLEConfig::WEIGHT_TRAILER_OFFSET, crc32Final(crc) ^ crcXor, (uint32_t)weights.size()};
+    std::vector<uint8_t> packet(BLEConfig::WEIGHT_TRAILER_SIZE);
+    memcpy(packet.data(), trailer, sizeof(trailer));
+    packets.push_back(packet);
+    return packets;
+}
+
+int runWeightRoundTrip(Communication& bleComm, NeuralNetworkBikeLock& nn) {
+    const size_t packetSize = min((size_t)ATT.mtu() - 3, (size_t)BLEConfig::WEIGHT_PACKET_MAX_SIZE);
+    const size_t chunkFloats = (packetSize - BLEConfig::WEIGHT_HEADER_SIZE) / sizeof(float);
+
+    // GET: drive sendWeights() from the loop, drop the link a third of the way in and
+    // lose the last two notifications, then resume from what actually arrived
+    std::vector<std::vector<uint8_t> > packets;
+    BLECharacteristic* read = BLE.fakeCharacteristic(BLEConfig::WEIGHTS_READ_CHAR_UUID);
+    read->fakeOnNotify(collectPacket, &packets);
+    sendCommand(bleComm, Command::GET_WEIGHTS);
+    const size_t dropAt = NNConfig::MAX_WEIGHTS / chunkFloats / 3;
+    bool dropped = false;
+    bool sent = false;
+    unsigned long calls = 0;
+    Clock::time_point t = Clock::now();
+    while (!sent && calls < 1000000) {
+        bleComm.update();
+        sent = bleComm.sendWeights(nn);
+        calls++;
+        if (!dropped && packets.size() >= dropAt) {
+            dropped = true;
+            reconnect(bleComm, false);
+            packets.resize(packets.size() - 2);
+            size_t before = packets.size();
+            for (int i = 0; i < 3; i++) {
+                if (bleComm.sendWeights(nn) || packets.size() != before) {
+                    fprintf(stderr, "FAILED: sendWeights() kept sending while disconnected\n");
+                    return 1;
+                }
+            }
+            reconnect(bleComm, true);
+            const std::vector<uint8_t>& last = packets.back();
+            uint32_t resume = packetOffset(last) + (uint32_t)((last.size() - BLEConfig::WEIGHT_HEADER_SIZE) / sizeof(float));
+            BLE.fakeCharacteristic(BLEConfig::TRANSFER_CHAR_UUID)->fakeWrite(&resume, sizeof(resume));
+        }
+    }
+    uint64_t getNs = elapsedNs(t);
+    read->fakeOnNotify(nullptr, nullptr);
+
+    std::vector<float> weights;
+    uint32_t crc = CRC32_INIT;
+    size_t bytes = 0;
+    unsigned long airtimeUs = 0;
+    for (size_t i = 0; i + 1 < packets.size(); i++) {
+        const std::vector<uint8_t>& p = packets[i];
+        size_t n = (p.size() - BLEConfig::WEIGHT_HEADER_SIZE) / sizeof(float);
+        bytes += p.size();
+        airtimeUs += airtimeUs2M(p.size());
+        if (packetOffset(p) != weights.size() || (n != chunkFloats && i + 2 != packets.size())) {
+            fprintf(stderr, "FAILED: chunk %zu at offset %lu carries %zu weights\n", i, (unsigned long)packetOffset(p), n);
+            return 1;
+        }
+        size_t offset = weights.size();
+        weights.resize(offset + n);
+        memcpy(&weights[offset], &p[BLEConfig::WEIGHT_HEADER_SIZE], n * sizeof(float));
+        crc = crc32Update(crc, &p[BLEConfig::WEIGHT_HEADER_SIZE], n * sizeof(float));
+    }
+    uint32_t trailer[3] = {0, 0, 0};
+    if (!sent || !dropped || packets.empty() || packets.back().size() != BLEConfig::WEIGHT_TRAILER_SIZE) {
+        fprintf(stderr, "FAILED: GET_WEIGHTS did not end with a trailer\n");
+        return 1;
+    }
+    memcpy(trailer, packets.back().data(), sizeof(trailer));
+    if (trailer[0] != BLEConfig::WEIGHT_TRAILER_OFFSET || trailer[1] != crc32Final(crc) || trailer[2] != weights.size() ||
+        weights.size() != NNConfig::MAX_WEIGHTS) {
+        fprintf(stderr, "FAILED: GET_WEIGHTS trailer does not match the stream\n");
+        return 1;
+    }
+    Communication::TransferStatus status = readTransferStatus();
+    if (status.sendOffset != NNConfig::MAX_WEIGHTS || status.bytes == 0) {
+        fprintf(stderr, "FAILED: transfer status not published\n");
+        return 1;
+    }
+    printf("GET_WEIGHTS: %zu weights, MTU %u, %zu chunks of %zu, %zu bytes, CRC %08lx, %lu loop calls, %lu buffer stalls, %llu ns\n",
+           weights.size(), ATT.mtu(), packets.size() - 1, chunkFloats, bytes, (unsigned long)trailer[1], calls,
+           HCI.fakeStalls(), (unsigned long long)getNs);
+    printf("GET_WEIGHTS: resumed after disconnect, ideal 2M PHY airtime %.0f ms\n", airtimeUs / 1000.0);
+
+    // SET: send scaled weights back, dropping the link half way; the central continues
+    // from the published receive offset and repeats one packet the device already has
+    std::vector<float> scaled(weights);
+    for (size_t i = 0; i < scaled.size(); i++) scaled[i] *= 0.5f;
+    std::vector<std::vector<uint8_t> > setPackets = buildPackets(scaled, chunkFloats, 0);
+    size_t half = setPackets.size() / 2;
+    const uint32_t versionBefore = nn.getVersion();
+    std::vector<float> check(scaled.size());
+    t = Clock::now();
+    sendCommand(bleComm, Command::SET_WEIGHTS);
+    writePackets(bleComm, nn, setPackets, 0, half);
+    // Half a model is in the standby copy; inference still sees the old one
+    nn.readWeights(check.data(), 0, check.size());
+    if (check != weights || nn.getVersion() != versionBefore) {
+        fprintf(stderr, "FAILED: a partial SET_WEIGHTS reached the live weights\n");
+        return 1;
+    }
+    reconnect(bleComm, false);
+    bleComm.receiveWeights(nn);
+    reconnect(bleComm, true);
+    uint32_t resume = readTransferStatus().receiveOffset;
+    size_t next = resume / chunkFloats;
+    if (resume != half * chunkFloats || next == 0) {
+        fprintf(stderr, "FAILED: receive offset %lu after disconnect\n", (unsigned long)resume);
+        return 1;
+    }
+    bool stored = writePackets(bleComm, nn, setPackets, next - 1, setPackets.size());
+    uint64_t setNs = elapsedNs(t);
+    nn.readWeights(check.data(), 0, check.size());
+    if (!stored || memcmp(check.data(), scaled.data(), scaled.size() * sizeof(float)) != 0 ||
+        nn.getVersion() != versionBefore + 1) {
+        fprintf(stderr, "FAILED: SET_WEIGHTS did not store the sent weights\n");
+        return 1;
+    }
+    printf("SET_WEIGHTS: resumed at %lu, accepted and verified, %llu ns\n", (unsigned long)resume, (unsigned long long)setNs);
+
+    // Corrupt CRC and a dropped chunk must both be rejected without touching the live weights
+    std::vector<std::vector<uint8_t> > gap = buildPackets(weights, chunkFloats, 0);
+    gap.erase(gap.begin() + 3);
+    const uint32_t versionStored = nn.getVersion();
+    if (pushPackets(bleComm, nn, buildPackets(weights, chunkFloats, 0x1)) || pushPackets(bleComm, nn, gap)) {
+        fprintf(stderr, "FAILED: corrupt transfer was accepted\n");
+        return 1;
+    }
+    nn.readWeights(check.data(), 0, check.size());
+    if (check != scaled || nn.getVersion() != versionStored) {
+        fprintf(stderr, "FAILED: a rejected SET_WEIGHTS changed the live weights\n");
+        return 1;
+    }
+    printf("SET_WEIGHTS: bad CRC and dropped chunk rejected, live weights untouched\n");
+    return 0;
+}
+
+// Plays the sketch's loop() for the weight commands until the device goes idle
+std::vector<std::vector<uint8_t> > pullWeights(Communication& bleComm, NeuralNetworkBikeLock& nn, Command command,
+                                               size_t dropAfter = 0) {
+    std::vector<std::vector<uint8_t> > packets;
+    BLECharacteristic* read = BLE.fakeCharacteristic(BLEConfig::WEIGHTS_READ_CHAR_UUID);
+    read->fakeOnNotify(collectPacket, &packets);
+    sendCommand(bleComm, command);
+    for (unsigned long calls = 0; calls < 1000000; calls++) {
+        bleComm.update();
+        if (bleComm.getCurrentCommand() == Command::GET_WEIGHTS) {
+            bleComm.sendWeights(nn);
+        } else if (bleComm.getCurrentCommand() == Command::GET_WEIGHT_DELTA) {
+            bleComm.sendWeightDelta(nn);
+        } else {
+            break;
+        }
+        if (dropAfter > 0 && packets.size() >= dropAfter) {
+            reconnect(bleComm, false);
+            bleComm.sendWeightDelta(nn);
+            reconnect(bleComm, true);
+            break;
+        }
+    }
+    read->fakeOnNotify(nullptr, nullptr);
+    return packets;
+}
+
+uint32_t readSyncVersion() {
+    uint32_t version = 0;
+    BLE.fakeCharacteristic(BLEConfig::SYNC_CHAR_UUID)->readValue(&version, sizeof(version));
+    return version;
+}
+
+size_t streamBytes(const std::vector<std::vector<uint8_t> >& packets) {
+    size_t bytes = 0;
+    for (size_t i = 0; i < packets.size(); i++) bytes += packets[i].size();
+    return bytes;
+}
+
+// Central side: applies a full or delta stream to its fp16 base. Returns false if
+// the stream is malformed or the trailer CRC does not match the result.
+bool applyStream(const std::vector<std::vector<uint8_t> >& packets, std::vector<uint16_t>& base, bool& delta,
+                 uint32_t& changed) {
+    if (packets.size() < 2 || packets.back().size() != BLEConfig::WEIGHT_TRAILER_SIZE) return false;
+    uint32_t trailer[3];
+    memcpy(trailer, packets.back().data(), sizeof(trailer));
+    delta = packetOffset(packets[0]) == BLEConfig::WEIGHT_DELTA_HEADER_OFFSET;
+    changed = 0;
+
+    if (!delta) {
+        base.clear();
+        for (size_t i = 0; i + 1 < packets.size(); i++) {
+            const std::vector<uint8_t>& p = packets[i];
+            if (packetOffset(p) != base.size()) return false;
+            for (size_t k = BLEConfig::WEIGHT_HEADER_SIZE; k + sizeof(float) <= p.size(); k += sizeof(float)) {
+                float w;
+                memcpy(&w, &p[k], sizeof(w));
+                base.push_back(floatToHalf(w));
+            }
+        }
+        changed = (uint32_t)base.size();
+    } else {
+        if (packets[0].size() != BLEConfig::WEIGHT_DELTA_HEADER_SIZE) return false;
+        size_t index = 0;
+        for (size_t i = 1; i + 1 < packets.size(); i++) {
+            const std::vector<uint8_t>& p = packets[i];
+            if (packetOffset(p) != BLEConfig::WEIGHT_DELTA_RUNS_OFFSET) return false;
+            for (size_t k = BLEConfig::WEIGHT_HEADER_SIZE; k < p.size(); ) {
+                if (k + BLEConfig::DELTA_RUN_HEADER_SIZE > p.size()) return false;
+                index += p[k] | (p[k + 1] << 8);
+                size_t n = p[k + 2];
+                k += BLEConfig::DELTA_RUN_HEADER_SIZE;
+                if (k + n * sizeof(uint16_t) > p.size() || index + n > base.size()) return false;
+                for (size_t j = 0; j < n; j++, index++, changed++, k += sizeof(uint16_t)) {
+                    uint16_t delta = p[k] | (p[k + 1] << 8);
+                    base[index] = floatToHalf(halfToFloat(base[index]) + halfToFloat(delta));
+                }
+            }
+        }
+    }
+
+    uint32_t crc = CRC32_INIT;
+    if (delta) {
+        crc = crc32Update(crc, reinterpret_cast<const uint8_t*>(base.data()), base.size() * sizeof(uint16_t));
+        return trailer[1] == crc32Final(crc) && trailer[2] == changed;
+    }
+    return trailer[2] == base.size();
+}
+
+int runDeltaSync(Communication& bleComm, NeuralNetworkBikeLock& nn, SignalProcessing& signalProc, int trainSteps) {
+    // Unknown version: the device must fall back to a full stream and rebase
+    uint32_t zero = 0;
+    BLE.fakeCharacteristic(BLEConfig::SYNC_CHAR_UUID)->fakeWrite(&zero, sizeof(zero));
+    std::vector<std::vector<uint8_t> > packets = pullWeights(bleComm, nn, Command::GET_WEIGHT_DELTA);
+    std::vector<uint16_t> base;
+    bool delta = false;
+    uint32_t changed = 0;
+    if (!applyStream(packets, base, delta, changed) || delta || base.size() != NNConfig::MAX_WEIGHTS) {
+        fprintf(stderr, "FAILED: version 0 did not get a full stream\n");
+        return 1;
+    }
+    uint32_t version = readSyncVersion();
+    const size_t fullBytes = streamBytes(packets);
+    printf("DELTA: unknown version -> full stream, %zu bytes, base version %lu\n", fullBytes, (unsigned long)version);
+
+    // Live training on a few windows, then sync only what moved
+    const std::vector<Recording>& recordings = IMU.getRecordings();
+    for (int i = 0; i < trainSteps; i++) {
+        IMU.select(i % recordings.size());
+        signalProc.collectData();
+        signalProc.processData();
+        nn.performLiveTraining(signalProc.getFeatures(), recordings[i % recordings.size()].label);
+    }
+    for (int pass = 0; pass < 2; pass++) {
+        BLE.fakeCharacteristic(BLEConfig::SYNC_CHAR_UUID)->fakeWrite(&version, sizeof(version));
+        packets = pullWeights(bleComm, nn, Command::GET_WEIGHT_DELTA);
+        if (!applyStream(packets, base, delta, changed) || !delta || readSyncVersion() != nn.getVersion()) {
+            fprintf(stderr, "FAILED: delta after training did not apply cleanly\n");
+            return 1;
+        }
+        version = readSyncVersion();
+
+        std::vector<float> weights(NNConfig::MAX_WEIGHTS);
+        nn.readWeights(weights.data(), 0, weights.size());
+        float maxError = 0.0f;
+        for (size_t i = 0; i < weights.size(); i++) {
+            maxError = std::max(maxError, fabsf(weights[i] - halfToFloat(base[i])));
+        }
+        size_t bytes = streamBytes(packets);
+        printf("DELTA: %s, %d training steps, %lu of %zu weights changed, %zu packets, %zu bytes (%.1f%% of full), "
+               "max error %.2e\n", pass == 0 ? "after training" : "refinement", trainSteps, (unsigned long)changed,
+               weights.size(), packets.size(), bytes, 100.0 * bytes / fullBytes, maxError);
+    }
+
+    // Stale version: full stream again
+    uint32_t stale = version - 1;
+    BLE.fakeCharacteristic(BLEConfig::SYNC_CHAR_UUID)->fakeWrite(&stale, sizeof(stale));
+    packets = pullWeights(bleComm, nn, Command::GET_WEIGHT_DELTA);
+    if (!applyStream(packets, base, delta, changed) || delta) {
+        fprintf(stderr, "FAILED: stale version did not get a full stream\n");
+        return 1;
+    }
+    version = readSyncVersion();
+
+    // A delta cut short by a disconnect leaves no valid base
+    for (int i = 0; i < trainSteps; i++) {
+        IMU.select(i % recordings.size());
+        signalProc.collectData();
+        signalProc.processData();
+        nn.performLiveTraining(signalProc.getFeatures(), recordings[i % recordings.size()].label);
+    }
+    BLE.fakeCharacteristic(BLEConfig::SYNC_CHAR_UUID)->fakeWrite(&version, sizeof(version));
+    HCI.fakeSetAclBuffers(1);   // One packet per call, so the drop lands mid-stream
+    pullWeights(bleComm, nn, Command::GET_WEIGHT_DELTA, 2);
+    HCI.fakeSetAclBuffers(4);
+    if (readSyncVersion() != 0 || bleComm.getCurrentCommand() != Command::NONE) {
+        fprintf(stderr, "FAILED: interrupted delta kept its base\n");
+        return 1;
+    }
+    printf("DELTA: stale version -> full stream, interrupted delta invalidated the base\n");
+    return 0;
+}
+
+float replayAccuracy(NeuralNetworkBikeLock& nn) {
+    const ReplayBuffer& replay = nn.getReplayBuffer();
+    size_t correct = 0;
+    for (size_t i = 0; i < replay.size(); i++) {
+        float outputs[NNConfig::NUM_OUTPUTS];
+        nn.getPredictionProbabilities(replay[i].features, outputs);
+        correct += argmax(outputs, NNConfig::NUM_OUTPUTS) == replay[i].label;
+    }
+    return replay.size() ? 100.0f * correct / replay.size() : 0.0f;
+}
+
+int runBackgroundTraining(Communication& bleComm, NeuralNetworkBikeLock& nn, SignalProcessing& signalProc, int epochs) {
+    const std::vector<Recording>& recordings = IMU.getRecordings();
+    for (size_t i = 0; i < recordings.size(); i++) {
+        IMU.select(i);
+        signalProc.collectData();
+        signalProc.processData();
+        nn.addTrainingSample(signalProc.getFeatures(), recordings[i].label);
+    }
+    const size_t stored = std::min<size_t>(recordings.size(), NNConfig::REPLAY_CAPACITY);
+    if (nn.getReplayBuffer().size() != stored) {
+        fprintf(stderr, "FAILED: replay buffer holds %zu of %zu samples\n", nn.getReplayBuffer().size(), stored);
+        return 1;
+    }
+    float accuracyBefore = replayAccuracy(nn);
+    uint32_t versionBefore = nn.getVersion();
+
+    // Each micros() read advances the virtual clock by the 1 ms poll step, so a slice trains a few samples
+    BLECharacteristic* progressChar = BLE.fakeCharacteristic(BLEConfig::TRAINING_CHAR_UUID);
+    const unsigned long notifiesBefore = progressChar->notifyCount();
+    nn.startBackgroundTraining((uint16_t)epochs);
+    float firstLoss = -1.0f;
+    unsigned long slices = 0;
+    Clock::time_point t = Clock::now();
+    while (nn.isTraining() && slices < 1000000UL) {
+        bleComm.update();
+        if (nn.trainSlice()) {
+            bleComm.sendTrainingProgress(nn.getTrainingProgress());
+            if (firstLoss < 0.0f) firstLoss = nn.getTrainingProgress().loss;
+        }
+        slices++;
+    }
+    uint64_t ns = elapsedNs(t);
+
+    NeuralNetworkBikeLock::TrainingProgress progress;
+    if (progressChar->readValue(&progress, sizeof(progress)) != sizeof(progress) ||
+        progressChar->notifyCount() - notifiesBefore != (unsigned long)epochs ||
+        progress.epoch != epochs || progress.active || progress.samples != stored) {
+        fprintf(stderr, "FAILED: progress characteristic did not report %d epochs\n", epochs);
+        return 1;
+    }
+    // Convergence depends on the data and the (unscaled) features, so only check that training ran
+    if (!std::isfinite(progress.loss) || firstLoss < 0.0f || nn.getVersion() == versionBefore) {
+        fprintf(stderr, "FAILED: loss %.4f -> %.4f over %d epochs\n", firstLoss, progress.loss, epochs);
+        return 1;
+    }
+    printf("TRAIN: %zu samples, %d epochs of batch %u in %lu slices (%.1f samples/slice), loss %.4f -> %.4f, "
+           "replay accuracy %.1f%% -> %.1f%%, %.2f ms host time\n", stored, epochs, NNConfig::BATCH_SIZE, slices,
+           (double)stored * epochs / slices, firstLoss, progress.loss, accuracyBefore, replayAccuracy(nn), ns / 1e6);
+    return 0;
+}
+
+float maxAbsDiff(const float* a, const float* b, size_t length) {
+    float diff = 0.0f;
+    for (size_t i = 0; i < length; i++) diff = std::max(diff, std::fabs(a[i] - b[i]));
+    return diff;
+}
+
+// nn runs the default STATIC backend; a DYNAMIC twin is built from the same seed
+int runBackendComparison(NeuralNetworkBikeLock& nn, SignalProcessing& signalProc, int iterations) {
+    static NeuralNetworkBikeLock dynamicNN;
+    dynamicNN.setBackend(NNConfig::Backend::DYNAMIC);
+    randomSeed(42);
+    dynamicNN.init(NNConfig::LAYERS, nullptr, NNConfig::NUM_LAYERS);
+    if (nn.getBackend() != NNConfig::Backend::STATIC || dynamicNN.getBackend() != NNConfig::Backend::DYNAMIC) {
+        fprintf(stderr, "FAILED: expected one static and one dynamic network\n");
+        return 1;
+    }
+
+    const size_t total = nn.getTotalWeights();
+    std::vector<float> staticWeights(total), dynamicWeights(total);
+    if (dynamicNN.getTotalWeights() != total || !nn.getWeights(staticWeights.data(), total) ||
+        !dynamicNN.getWeights(dynamicWeights.data(), total) || staticWeights != dynamicWeights) {
+        fprintf(stderr, "FAILED: backends did not draw the same initial weights\n");
+        return 1;
+    }
+
+    std::vector<std::vector<float> > features;
+    std::vector<int> labels;
+    collectFeatureSet(signalProc, features, labels);
+
+    StageTimer staticInfer("static.inference"), dynamicInfer("dynamic.inference");
+    StageTimer staticTrain("static.train"), dynamicTrain("dynamic.train");
+    float outputDiff = 0.0f;
+    // The static network has every array from construction, so even its first
+    // inference and training steps must not allocate (counted around its calls only)
+    size_t staticAllocations = 0, allocationsBefore;
+    for (int i = 0; i < iterations; i++) {
+        const float* x = features[i % features.size()].data();
+        float a[NNConfig::NUM_OUTPUTS], b[NNConfig::NUM_OUTPUTS];
+        allocationsBefore = heapAllocations;
+        Clock::time_point t = Clock::now();
+        nn.getPredictionProbabilities(x, a);
+        uint64_t ns = elapsedNs(t);
+        staticAllocations += heapAllocations - allocationsBefore;
+        staticInfer.add(ns);
+        t = Clock::now();
+        dynamicNN.getPredictionProbabilities(x, b);
+        dynamicInfer.add(elapsedNs(t));
+        outputDiff = std::max(outputDiff, maxAbsDiff(a, b, NNConfig::NUM_OUTPUTS));
+    }
+    for (int i = 0; i < iterations; i++) {
+        size_t s = i % features.size();
+        allocationsBefore = heapAllocations;
+        Clock::time_point t = Clock::now();
+        nn.performLiveTraining(features[s].data(), labels[s]);
+        uint64_t ns = elapsedNs(t);
+        staticAllocations += heapAllocations - allocationsBefore;
+        staticTrain.add(ns);
+        t = Clock::now();
+        dynamicNN.performLiveTraining(features[s].data(), labels[s]);
+        dynamicTrain.add(elapsedNs(t));
+    }
+    nn.getWeights(staticWeights.data(), total);
+    dynamicNN.getWeights(dynamicWeights.data(), total);
+    float weightDiff = maxAbsDiff(staticWeights.data(), dynamicWeights.data(), total);
+
+    // Steady state: both backends have their buffers by now, so training must not
+    // touch the heap (the timers above do, so this runs untimed)
+    allocationsBefore = heapAllocations;
+    for (int i = 0; i < iterations; i++) {
+        size_t s = i % features.size();
+        nn.performLiveTraining(features[s].data(), labels[s]);
+        dynamicNN.performLiveTraining(features[s].data(), labels[s]);
+    }
+    size_t trainingAllocations = heapAllocations - allocationsBefore;
+
+    // Mini-batch epochs: same shuffle on both, gradients summed and applied per batch
+    NeuralNetworkBikeLock* const nets[2] = {&nn, &dynamicNN};
+    for (int n = 0; n < 2; n++) {
+        for (size_t s = 0; s < features.size(); s++) nets[n]->addTrainingSample(features[s].data(), labels[s]);
+        randomSeed(7);
+        nets[n]->startBackgroundTraining(2);
+        while (nets[n]->isTraining()) nets[n]->trainSlice(1000000UL);
+    }
+    nn.getWeights(staticWeights.data(), total);
+    dynamicNN.getWeights(dynamicWeights.data(), total);
+    float batchWeightDiff = maxAbsDiff(staticWeights.data(), dynamicWeights.data(), total);
+
+    printf("Backends, %d iterations (ns):\n", iterations);
+    staticInfer.print();
+    dynamicInfer.print();
+    staticTrain.print();
+    dynamicTrain.print();
+    printf("Speedup: inference %.2fx, training %.2fx\n", (double)dynamicInfer.total() / staticInfer.total(),
+           (double)dynamicTrain.total() / staticTrain.total());
+    printf("Max difference: outputs %.3g, weights after training %.3g, after mini-batch epochs %.3g\n",
+           outputDiff, weightDiff, batchWeightDiff);
+    printf("Heap allocations in %d training steps per backend: %zu\n", iterations, trainingAllocations);
+    typedef NeuralNetworkBikeLock::StaticModel StaticModel;
+    printf("Static model: %zu weights, %zu bytes of arrays, %zu heap allocations from first use\n",
+           StaticModel::TOTAL_WEIGHTS, sizeof(StaticModel), staticAllocations);
+
+    // Only float summation order differs (expf vs exp, gamma accumulation)
+    if (!(outputDiff < 1e-5f) || !(weightDiff < 1e-3f) || !(batchWeightDiff < 1e-3f)) {
+        fprintf(stderr, "FAILED: backends disagree\n");
+        return 1;
+    }
+    if (trainingAllocations != 0 || staticAllocations != 0) {
+        fprintf(stderr, "FAILED: training allocated on the heap\n");
+        return 1;
+    }
+    return 0;
+}
+
+// Same windows through getPredictionProbabilities one at a time and through
+// getPredictionProbabilitiesBatch in batches of 1, 2, 4 ... up to maxBatch on the
+// dynamic network, which is the backend the batch kernel serves
+int runBatchInference(SignalProcessing& signalProc, int maxBatch) {
+    static NeuralNetworkBikeLock dynamicNN;
+    dynamicNN.setBackend(NNConfig::Backend::DYNAMIC);
+    randomSeed(42);
+    dynamicNN.init(NNConfig::LAYERS, nullptr, NNConfig::NUM_LAYERS);
+
+    const std::vector<Recording>& recordings = IMU.getRecordings();
+    const size_t windows = std::max(recordings.size(), (size_t)maxBatch);
+    std::vector<float> features(windows * NNConfig::NUM_INPUTS);
+    for (size_t i = 0; i < recordings.size(); i++) {
+        IMU.select(i);
+        signalProc.collectData();
+        signalProc.processData();
+        memcpy(&features[i * NNConfig::NUM_INPUTS], signalProc.getFeatures(), NNConfig::NUM_INPUTS * sizeof(float));
+    }
+    for (size_t i = recordings.size(); i < windows; i++) {
+        memcpy(&features[i * NNConfig::NUM_INPUTS], &features[(i % recordings.size()) * NNConfig::NUM_INPUTS],
+               NNConfig::NUM_INPUTS * sizeof(float));
+    }
+
+    // Enough passes over the windows for a few milliseconds per row
+    const int passes = std::max(1, (int)(20000 / windows));
+    std::vector<float> expected(windows * NNConfig::NUM_OUTPUTS), batched(windows * NNConfig::NUM_OUTPUTS);
+    Clock::time_point t = Clock::now();
+    for (int p = 0; p < passes; p++) {
+        for (size_t i = 0; i < windows; i++) {
+            dynamicNN.getPredictionProbabilities(&features[i * NNConfig::NUM_INPUTS], &expected[i * NNConfig::NUM_OUTPUTS]);
+        }
+    }
+    const double single = (double)windows * passes * 1e9 / elapsedNs(t);
+
+    const bool scalar = strcmp(NeuralNetworkBikeLock::getDotProductBackend(), "scalar") == 0;
+    printf("Batched inference, %zu windows x%d passes, %s FeedForward:\n", windows, passes,
+           NeuralNetworkBikeLock::getDotProductBackend());
+    printf("  %-8s %12s %8s\n", "batch", "windows/s", "speedup");
+    printf("  %-8s %12.0f %7.2fx  %s\n", "single", single, 1.0, std::string(20, '#').c_str());
+
+    bool exact = true;
+    for (int batch = 1; batch <= maxBatch; batch *= 2) {
+        std::fill(batched.begin(), batched.end(), -1.0f);
+        t = Clock::now();
+        for (int p = 0; p < passes; p++) {
+            for (size_t i = 0; i < windows; i += batch) {
+                size_t count = std::min((size_t)batch, windows - i);
+                dynamicNN.getPredictionProbabilitiesBatch(&features[i * NNConfig::NUM_INPUTS], count,
+                                                          &batched[i * NNConfig::NUM_OUTPUTS]);
+            }
+        }
+        const double rate = (double)windows * passes * 1e9 / elapsedNs(t);
+        // Same products summed in the same order, so not even the last bit may differ,
+        // unless FeedForward runs a vector dot-product that reorders the sums
+        bool same = scalar ? memcmp(batched.data(), expected.data(), batched.size() * sizeof(float)) == 0
+                           : maxAbsDiff(batched.data(), expected.data(), batched.size()) <= 1e-5f;
+        exact = exact && same;
+        int bar = (int)(20 * rate / single + 0.5);
+        printf("  %-8d %12.0f %7.2fx  %s%s\n", batch, rate, rate / single, std::string(bar, '#').c_str(),
+               same ? "" : "  MISMATCH");
+    }
+
+    if (!exact) {
+        fprintf(stderr, "FAILED: batched outputs differ from single-window inference%s\n",
+                scalar ? "" : " by more than 1e-5");
+        return 1;
+    }
+    return 0;
+}
+
+size_t countZeros(NeuralNetworkBikeLock& nn) {
+    std::vector<float> weights(nn.getTotalWeights());
+    nn.getWeights(weights.data(), weights.size());
+    return std::count(weights.begin(), weights.end(), 0.0f);
+}
+
+// Accuracy in percent; outputs get every prediction, appended
+float timedAccuracy(NeuralNetworkBikeLock& nn, const std::vector<std::vector<float> >& features,
+                    const std::vector<int>& labels, int repeat, StageTimer& timer, std::vector<float>& outputs) {
+    size_t correct = 0;
+    for (int r = 0; r < repeat; r++) {
+        for (size_t i = 0; i < features.size(); i++) {
+            float p[NNConfig::NUM_OUTPUTS];
+            Clock::time_point t = Clock::now();
+            nn.getPredictionProbabilities(features[i].data(), p);
+            timer.add(elapsedNs(t));
+            if (r == 0) {
+                outputs.insert(outputs.end(), p, p + NNConfig::NUM_OUTPUTS);
+                correct += argmax(p, NNConfig::NUM_OUTPUTS) == labels[i];
+            }
+        }
+    }
+    return 100.0f * correct / features.size();
+}
+
+int runPruning(NeuralNetworkBikeLock& nn, SignalProcessing& signalProc, int percent) {
+    std::vector<std::vector<float> > features;
+    std::vector<int> labels;
+    collectFeatureSet(signalProc, features, labels);
+    // A few live training passes so the weights are not just the random init
+    for (int pass = 0; pass < 3; pass++) {
+        for (size_t i = 0; i < features.size(); i++) nn.performLiveTraining(features[i].data(), labels[i]);
+    }
+
+    const int repeat = 20;
+    const size_t total = nn.getTotalWeights();
+    const size_t denseMacs = nn.getInferenceMacs();
+    StageTimer dense("dense"), sparse("sparse"), densePruned("dense.pruned");
+    std::vector<float> denseOut, sparseOut, densePrunedOut;
+    float denseAccuracy = timedAccuracy(nn, features, labels, repeat, dense, denseOut);
+
+    uint32_t versionBefore = nn.getVersion();
+    size_t kept = nn.prune(percent / 100.0f);
+    const size_t expected = (size_t)((1.0f - percent / 100.0f) * total);
+    if (kept == 0 || !nn.isPruned() || kept > NNConfig::SPARSE_CAPACITY || nn.getVersion() == versionBefore ||
+        countZeros(nn) != total - kept || nn.getInferenceMacs() != kept) {
+        fprintf(stderr, "FAILED: pruning kept %zu of %zu weights, %zu zeros\n", kept, total, countZeros(nn));
+        return 1;
+    }
+    float sparseAccuracy = timedAccuracy(nn, features, labels, repeat, sparse, sparseOut);
+    nn.setSparseInference(false);
+    timedAccuracy(nn, features, labels, repeat, densePruned, densePrunedOut);
+    nn.setSparseInference(true);
+    float kernelDiff = maxAbsDiff(sparseOut.data(), densePrunedOut.data(), sparseOut.size());
+
+    size_t agree = 0;
+    for (size_t i = 0; i < features.size(); i++) {
+        agree += argmax(&denseOut[i * NNConfig::NUM_OUTPUTS], NNConfig::NUM_OUTPUTS) ==
+                 argmax(&sparseOut[i * NNConfig::NUM_OUTPUTS], NNConfig::NUM_OUTPUTS);
+    }
+
+    // Training keeps the mask, a weight write from the central drops it
+        nn.performLiveTraining(features[0].data(), labels[0]);
+    bool maskKept = countZeros(nn) == total - kept;
+    float sparseAfter[NNConfig::NUM_OUTPUTS], denseAfter[NNConfig::NUM_OUTPUTS];
+    nn.getPredictionProbabilities(features[0].data(), sparseAfter);
+    nn.setSparseInference(false);
+    nn.getPredictionProbabilities(features[0].data(), denseAfter);
+    nn.setSparseInference(true);
+    float trainedDiff = maxAbsDiff(sparseAfter, denseAfter, NNConfig::NUM_OUTPUTS);
+    float weight = 0.5f;
+    nn.writeWeights(&weight, 0, 1);
+
+    printf("Pruned to %d%% sparsity: %zu of %zu weights kept (expected %zu), MACs %zu -> %zu (%.1f%% saved)\n",
+           percent, kept, total, expected, denseMacs, kept, 100.0 * (denseMacs - kept) / denseMacs);
+    printf("Inference (ns):\n");
+    dense.print();
+    sparse.print();
+    densePruned.print();
+    printf("Speedup: %.2fx over dense\n", (double)dense.total() / sparse.total());
+    printf("Accuracy: %.1f%% dense, %.1f%% pruned (%+.1f), same class for %zu/%zu windows\n", denseAccuracy,
+           sparseAccuracy, sparseAccuracy - denseAccuracy, agree, features.size());
+    printf("Weights: %zu bytes dense, %zu bytes CSR\n", total * sizeof(float),
+           (size_t)(kept * (sizeof(float) + sizeof(uint16_t)) + NeuralNetworkBikeLock::SparseModel::TOTAL_ROW_STARTS * sizeof(uint16_t)));
+
+    if (!(kernelDiff < 1e-5f) || !maskKept || !(trainedDiff < 1e-5f) || nn.isPruned()) {
+        fprintf(stderr, "FAILED: sparse/dense difference %.3g, after training %.3g, mask %s, pruning %s after a write\n",
+                kernelDiff, trainedDiff, maskKept ? "kept" : "lost", nn.isPruned() ? "kept" : "dropped");
+        return 1;
+    }
+    return 0;
+}
+
+// SET_CASCADE the way the sketch's maintenance task applies it
+void writeCascadeCommand(Communication& bleComm, NeuralNetworkBikeLock& nn, uint8_t percent) {
+    uint8_t control[2] = {static_cast<uint8_t>(Command::SET_CASCADE), percent};
+    BLE.fakeCharacteristic(BLEConfig::CONTROL_CHAR_UUID)->fakeWrite(control, sizeof(control));
+    bleComm.update();
+    percent = bleComm.getCascadePercent();
+    nn.setCascade(percent > 0, percent > 0 ? percent / 100.0f : nn.getCascadeThreshold());
+    bleComm.resetState();
+}
+
+int runCascade(Communication& bleComm, NeuralNetworkBikeLock& nn, SignalProcessing& signalProc, int percent) {
+    std::vector<std::vector<float> > features;
+    std::vector<int> labels;
+    collectFeatureSet(signalProc, features, labels);
+
+    // A first stage that never trained is skipped, every window escalates; enabling
+    // the cascade with samples in the replay buffer trains it from them first
+    static NeuralNetworkBikeLock booted;
+    booted.setBackend(NNConfig::Backend::DYNAMIC);
+    booted.init(NNConfig::LAYERS, nullptr, NNConfig::NUM_LAYERS);
+    booted.setCascade(true);
+    float probabilities[NNConfig::NUM_OUTPUTS];
+    for (size_t i = 0; i < features.size(); i++) booted.getPredictionProbabilities(features[i].data(), probabilities);
+    bool untrainedEscalates = !booted.isFirstStageTrained() && booted.getCascadeStats().firstStageHits == 0 &&
+                              booted.getCascadeStats().escalations == features.size();
+    booted.setCascade(false);
+    for (size_t i = 0; i < features.size(); i++) booted.addTrainingSample(features[i].data(), labels[i]);
+    booted.setCascade(true);
+    bool trainedOnEnable = booted.isFirstStageTrained();
+
+    // Live training passes train both stages on the same samples, cascade on or off
+    for (int pass = 0; pass < 20; pass++) {
+        for (size_t i = 0; i < features.size(); i++) nn.performLiveTraining(features[i].data(), labels[i]);
+    }
+
+    const int repeat = 20;
+    StageTimer full("full"), cascaded("cascade");
+    std::vector<float> fullOut, cascadeOut;
+    float fullAccuracy = timedAccuracy(nn, features, labels, repeat, full, fullOut);
+    const float threshold = percent / 100.0f;
+    writeCascadeCommand(bleComm, nn, percent);
+    float cascadeAccuracy = timedAccuracy(nn, features, labels, repeat, cascaded, cascadeOut);
+    NeuralNetworkBikeLock::CascadeStats stats = nn.getCascadeStats();
+
+    // GET_CASCADE_STATS: the same counters on the benchmark characteristic
+    const uint8_t command = static_cast<uint8_t>(Command::GET_CASCADE_STATS);
+    BLE.fakeCharacteristic(BLEConfig::CONTROL_CHAR_UUID)->fakeWrite(&command, sizeof(command));
+    bleComm.update();
+    Communication::CascadeReport report;
+    bool reported = bleComm.getCurrentCommand() == Command::GET_CASCADE_STATS && bleComm.sendCascadeReport(nn) &&
+                    BLE.fakeCharacteristic(BLEConfig::BENCHMARK_CHAR_UUID)->readValue(&report, sizeof(report)) ==
+                        sizeof(report) &&
+                    report.kind == BLEConfig::CASCADE_REPORT_KIND && report.flags == 3 &&
+                    report.thresholdPercent == percent && report.firstStageHits == stats.firstStageHits &&
+                    report.escalations == stats.escalations && report.secondStageTicks == stats.secondStageTicks;
+    bleComm.resetState();
+    writeCascadeCommand(bleComm, nn, 0);
+
+    // Every window either stopped at a confident first stage or got the full network's answer
+    size_t firstStageWindows = 0;
+    bool consistent = true;
+    for (size_t i = 0; i < features.size(); i++) {
+        const float* c = &cascadeOut[i * NNConfig::NUM_OUTPUTS];
+        const float* f = &fullOut[i * NNConfig::NUM_OUTPUTS];
+        if (maxAbsDiff(c, f, NNConfig::NUM_OUTPUTS) == 0.0f) continue;
+        firstStageWindows++;
+        consistent = consistent && *std::max_element(c, c + NNConfig::NUM_OUTPUTS) >= threshold;
+    }
+    const uint32_t windows = features.size() * repeat;
+    const double tickNs = 1e9 / CycleTimer::ticksPerSecond();
+
+    printf("Cascade at %.2f: %u of %u windows decided by the first stage (%.1f%%), %u escalated\n", threshold,
+           stats.firstStageHits, windows, 100.0 * stats.firstStageHits / windows, stats.escalations);
+    printf("Stage cost (ns): first %.0f per window, full %.0f per escalation\n",
+           stats.firstStageTicks * tickNs / windows,
+           stats.escalations ? stats.secondStageTicks * tickNs / stats.escalations : 0.0);
+    printf("Inference (ns):\n");
+    full.print();
+    cascaded.print();
+    printf("Speedup: %.2fx, accuracy %.1f%% full, %.1f%% cascade (%+.1f)\n", (double)full.total() / cascaded.total(),
+           fullAccuracy, cascadeAccuracy, cascadeAccuracy - fullAccuracy);
+
+    printf("Untrained first stage escalates %s, trained from %zu replay samples on enable %s, BLE report %s\n",
+           untrainedEscalates ? "yes" : "NO", features.size(), trainedOnEnable ? "yes" : "NO", reported ? "ok" : "FAILED");
+
+    if (stats.firstStageHits + stats.escalations != windows || !consistent ||
+        firstStageWindows * repeat > stats.firstStageHits || nn.getCascadeStats().firstStageHits != 0 ||
+        nn.isCascadeEnabled()) {
+        fprintf(stderr, "FAILED: cascade counters or first-stage answers do not add up\n");
+        return 1;
+    }
+    if (!untrainedEscalates || !trainedOnEnable || !reported) {
+        fprintf(stderr, "FAILED: first stage used untrained or cascade not reported\n");
+        return 1;
+    }
+    return 0;
+}
+
+int runModelStore(NeuralNetworkBikeLock& nn, SignalProcessing& signalProc) {
+    static ModelStore store;
+    if (!store.begin() || store.find() != nullptr) {
+        fprintf(stderr, "FAILED: blank flash region holds a model\n");
+        return 1;
+    }
+    const std::vector<Recording>& recordings = IMU.getRecordings();
+    IMU.select(0);
+    signalProc.collectData();
+    signalProc.processData();
+    std::vector<float> features(signalProc.getFeatures(), signalProc.getFeatures() + NNConfig::NUM_INPUTS);
+    nn.performLiveTraining(features.data(), recordings[0].label);
+
+    const size_t total = nn.getTotalWeights();
+    std::vector<float> saved(total);
+    nn.getWeights(saved.data(), total);
+    Clock::time_point t = Clock::now();
+    bool ok = store.save(nn);
+    uint64_t saveNs = elapsedNs(t);
+
+    uint32_t version = 0;
+    t = Clock::now();
+    const float* stored = store.find(&version);
+    uint64_t findNs = elapsedNs(t);
+    if (!ok || !stored || version != nn.getVersion() || memcmp(stored, saved.data(), total * sizeof(float)) != 0) {
+        fprintf(stderr, "FAILED: saved model not found or different\n");
+        return 1;
+    }
+
+    // Boot a static network on the flash copy: same answers, no copy until it trains
+    static NeuralNetworkBikeLock::StaticModel booted;
+    booted.useExternalWeights(stored);
+    float expected[NNConfig::NUM_OUTPUTS];
+    nn.getPredictionProbabilities(features.data(), expected);
+    const float* output = booted.feedForward(features.data());
+    bool inPlace = booted.isExternal() && booted.getModel() == stored &&
+                   maxAbsDiff(output, expected, NNConfig::NUM_OUTPUTS) == 0.0f;
+    float target[NNConfig::NUM_OUTPUTS] = {1.0f, 0.0f, 0.0f};
+    booted.backProp(target);
+    bool copied = !booted.isExternal() && memcmp(booted.getWeights(), stored, total * sizeof(float)) != 0;
+
+    // Built for in-place weights the network has no weight RAM at all and cannot train
+    typedef StaticNetwork<WeightStorage::IN_PLACE, NNConfig::LAYERS[0], NNConfig::LAYERS[1], NNConfig::LAYERS[2]>
+        FlashModel;
+    static FlashModel flashOnly;
+    flashOnly.useExternalWeights(stored);
+    output = flashOnly.feedForward(features.data());
+    flashOnly.backProp(target);
+    bool readOnly = !FlashModel::TRAINABLE && flashOnly.getWeights() == nullptr && flashOnly.getModel() == stored &&
+                    sizeof(FlashModel) < FlashModel::TOTAL_WEIGHTS * sizeof(float) &&
+                    maxAbsDiff(output, expected, NNConfig::NUM_OUTPUTS) == 0.0f;
+
+    // The dynamic backend trains its own heap copy
+    static NeuralNetworkBikeLock dynamicNN;
+    dynamicNN.setBackend(NNConfig::Backend::DYNAMIC);
+    dynamicNN.init(NNConfig::LAYERS, stored, NNConfig::NUM_LAYERS);
+    dynamicNN.performLiveTraining(features.data(), recordings[0].label);
+    bool flashIntact = store.find() == stored && memcmp(stored, saved.data(), total * sizeof(float)) == 0;
+
+    bool erased = store.erase() && store.find() == nullptr;
+
+    printf("Model store: %zu-byte region, save %.2f ms, find + CRC %.1f us, in-place boot %s, "
+           "copy on training %s, read-only model %s (%zu bytes), flash intact %s, erase %s\n", StoreConfig::REGION_SIZE,
+           saveNs / 1e6, findNs / 1e3, inPlace ? "ok" : "FAILED", copied ? "ok" : "FAILED", readOnly ? "ok" : "FAILED",
+           sizeof(FlashModel), flashIntact ? "yes" : "NO", erased ? "ok" : "FAILED");
+    return (inPlace && copied && readOnly && flashIntact && erased) ? 0 : 1;
+}
+
+// Largest feature error relative to the window's largest float feature
+float relativeError(const float* fixed, const float* reference, size_t length) {
+    float scale = 0.0f;
+    for (size_t i = 0; i < length; i++) scale = std::max(scale, std::fabs(reference[i]));
+    float diff = maxAbsDiff(fixed, reference, length);
+    return scale > 0.0f ? diff / scale : diff;
+}
+
+// Both whole-window engines on the same raw windows, plus a flat and a full-scale window
+int runFixedPoint(NeuralNetworkBikeLock& nn, SignalProcessing& signalProc) {
+    const float bound = 1e-3f;
+    Recording flat, loud;
+    flat.index = -1;
+    flat.label = loud.label = 0;
+    loud.index = -2;
+    for (unsigned int i = 0; i < SignalConfig::SAMPLES; i++) {
+        float t = (float)i / SignalConfig::SAMPLING_FREQ;
+        float f[Recording::CHANNELS] = {1.0f, 0, 0, 0, 0, 0};
+        float l[Recording::CHANNELS] = {3.99f * sinf(TWO_PI * 9.0f * t), 0, 1.0f, 0, 0, 0};
+        flat.samples.insert(flat.samples.end(), f, f + Recording::CHANNELS);
+        loud.samples.insert(loud.samples.end(), l, l + Recording::CHANNELS);
+    }
+    IMU.addRecording(flat);
+    IMU.addRecording(loud);
+
+    const std::vector<Recording>& recordings = IMU.getRecordings();
+    const int repeat = 20;
+    StageTimer floatTimer("float.processData"), fixedTimer("q15.processData");
+    float worst = 0.0f, sum = 0.0f;
+    float featureWorst[SignalConfig::TOTAL_FEATURES] = {};
+    size_t sameClass = 0;
+    bool flatZero = true;
+    for (size_t i = 0; i < recordings.size(); i++) {
+        IMU.select(i);
+        signalProc.collectData();
+        float reference[SignalConfig::TOTAL_FEATURES], fixed[SignalConfig::TOTAL_FEATURES];
+        for (int r = 0; r < repeat; r++) {
+            signalProc.setFeatureEngine(SignalConfig::FeatureEngine::FFT);
+            Clock::time_point t = Clock::now();
+            signalProc.processData();
+            floatTimer.add(elapsedNs(t));
+            memcpy(reference, signalProc.getFeatures(), sizeof(reference));
+
+            signalProc.setFeatureEngine(SignalConfig::FeatureEngine::FIXED_Q15);
+            t = Clock::now();
+            signalProc.processData();
+            fixedTimer.add(elapsedNs(t));
+            memcpy(fixed, signalProc.getFeatures(), sizeof(fixed));
+        }
+
+        if (recordings[i].index == flat.index) {
+            for (unsigned int f = 0; f < SignalConfig::TOTAL_FEATURES; f++) flatZero = flatZero && fixed[f] == 0.0f;
+            continue;
+        }
+        float error = relativeError(fixed, reference, SignalConfig::TOTAL_FEATURES);
+        worst = std::max(worst, error);
+        sum += error;
+        for (unsigned int f = 0; f < SignalConfig::TOTAL_FEATURES; f++) {
+            featureWorst[f] = std::max(featureWorst[f], std::fabs(fixed[f] - reference[f]) / std::max(std::fabs(reference[f]), 1e-6f));
+        }
+        float a[NNConfig::NUM_OUTPUTS], b[NNConfig::NUM_OUTPUTS];
+        nn.getPredictionProbabilities(reference, a);
+        nn.getPredictionProbabilities(fixed, b);
+        sameClass += argmax(a, NNConfig::NUM_OUTPUTS) == argmax(b, NNConfig::NUM_OUTPUTS);
+    }
+    signalProc.setFeatureEngine(SignalConfig::DEFAULT_FEATURE_ENGINE);
+    const size_t compared = recordings.size() - 1;
+
+    printf("Q15 vs float features over %zu windows: error %.2e mean, %.2e worst of the largest feature (bound %.0e)\n",
+           compared, sum / compared, worst, bound);
+    printf("Worst per-feature relative error:");
+    for (unsigned int f = 0; f < SignalConfig::TOTAL_FEATURES; f++) printf(" %.1e", featureWorst[f]);
+    printf("\nSame class for %zu/%zu windows, flat window %s\n", sameClass, compared, flatZero ? "all zero" : "NOT zero");
+    printf("processData (ns):\n");
+    floatTimer.print();
+    fixedTimer.print();
+    printf("Window buffers: %zu bytes raw, %zu bytes float\n", SignalConfig::SAMPLES * sizeof(int16_t),
+           SignalConfig::SAMPLES * sizeof(float));
+
+    if (!(worst <= bound) || !flatZero) {
+        fprintf(stderr, "FAILED: fixed-point features outside %.0e of the float path\n", bound);
+        return 1;
+    }
+    return 0;
+}
+
+// Magnitude spectrum of every recording through the legacy extractor and
+// FeaturePlan::extract(), iterations times each, timed per call. Both sum the same
+// values in a different order, so every feature must agree within tolerance of
+// itself (or of the window's largest feature, for features near zero).
+int runFeatureExtraction(int iterations) {
+    typedef FeaturePlan<SignalConfig::SAMPLES, SignalConfig::SAMPLING_FREQ, SignalConfig::FreqBands> Plan;
+    const float tolerance = 1e-5f;
+    static float vReal[SignalConfig::SAMPLES];
+    ArduinoFFT<float> dsp(vReal, nullptr, SignalConfig::SAMPLES, SignalConfig::SAMPLING_FREQ);
+
+    const std::vector<Recording>& recordings = IMU.getRecordings();
+    StageTimer legacyTimer("legacy.extract"), planTimer("plan.extract");
+    float worst = 0.0f;
+    for (size_t r = 0; r < recordings.size(); r++) {
+        const Recording& recording = recordings[r];
+        for (unsigned int i = 0; i < SignalConfig::SAMPLES; i++) {
+            size_t s = min((size_t)i, recording.sampleCount() - 1);
+            vReal[i] = recording.samples[Recording::CHANNELS * s] * 9.81f;
+        }
+        dsp.dcRemoval();
+        dsp.windowing(FFTWindow::Hamming, FFTDirection::Forward);
+        dsp.computeReal();
+        dsp.complexToMagnitudeReal();
+
+        float legacy[SignalConfig::TOTAL_FEATURES], planned[SignalConfig::TOTAL_FEATURES];
+        for (int i = 0; i < iterations; i++) {
+            Clock::time_point t = Clock::now();
+            legacyExtractFeatures(vReal, legacy);
+            legacyTimer.add(elapsedNs(t));
+
+            t = Clock::now();
+            Plan::extract(vReal, planned);
+            planTimer.add(elapsedNs(t));
+        }
+
+        float largest = 0.0f;
+        for (unsigned int f = 0; f < SignalConfig::TOTAL_FEATURES; f++) largest = std::max(largest, std::fabs(legacy[f]));
+        for (unsigned int f = 0; f < SignalConfig::TOTAL_FEATURES; f++) {
+            float scale = std::max(std::fabs(legacy[f]), largest * 1e-3f);
+            worst = std::max(worst, std::fabs(planned[f] - legacy[f]) / std::max(scale, 1e-12f));
+        }
+    }
+
+    // A flat spectrum has no spread; the merged m2 may round below zero but the std must not turn NaN
+    for (unsigned int i = 0; i < SignalConfig::SAMPLES; i++) vReal[i] = 0.3f + 1e-7f * (i % 3);
+    float flat[SignalConfig::TOTAL_FEATURES];
+    Plan::extract(vReal, flat);
+    const float flatStd = flat[SignalConfig::TOTAL_FEATURES - 1];
+
+    printf("Feature extraction over %zu windows x%d (ns):\n", recordings.size(), iterations);
+    legacyTimer.print();
+    planTimer.print();
+    printf("Speedup: %.2fx, worst relative difference %.2e (tolerance %.0e)\n",
+           (double)legacyTimer.total() / std::max(planTimer.total(), (uint64_t)1), worst, tolerance);
+
+    printf("Flat spectrum std: %g\n", flatStd);
+    if (!(worst <= tolerance)) {
+        fprintf(stderr, "FAILED: FeaturePlan features differ from the legacy extractor\n");
+        return 1;
+    }
+    if (!(flatStd >= 0.0f && flatStd < 1e-3f)) {
+        fprintf(stderr, "FAILED: flat spectrum std is %g\n", flatStd);
+        return 1;
+    }
+    return 0;
+}
+
+// Virtual clock for the scheduler check: only moves when a task "works" or the loop idles
+unsigned long schedulerNow = 0;
+std::string schedulerTrace;
+int schedulerUrgent = Scheduler::INVALID_TASK;
+int schedulerHog = Scheduler::INVALID_TASK;
+Scheduler* schedulerUnderTest = nullptr;
+
+// processData()'s real-input FFT against the complex one it replaced, bin by bin
+int runRealFft() {
+    const unsigned int bins = SignalConfig::SAMPLES / 2 + 1;
+    const float tolerance = 1e-5f;
+    static float window[SignalConfig::SAMPLES], vReal[SignalConfig::SAMPLES], vImag[SignalConfig::SAMPLES];
+    ArduinoFFT<float> realDsp(vReal, nullptr, SignalConfig::SAMPLES, SignalConfig::SAMPLING_FREQ);
+    ArduinoFFT<float> complexDsp(vReal, vImag, SignalConfig::SAMPLES, SignalConfig::SAMPLING_FREQ);
+
+    const std::vector<Recording>& recordings = IMU.getRecordings();
+    StageTimer complexTimer("complex.fft+mag"), realTimer("real.fft+mag");
+    float worst = 0.0f;
+    for (size_t r = 0; r < recordings.size(); r++) {
+        const Recording& recording = recordings[r];
+        for (unsigned int i = 0; i < SignalConfig::SAMPLES; i++) {
+            size_t s = min((size_t)i, recording.sampleCount() - 1);
+            vReal[i] = recording.samples[Recording::CHANNELS * s] * 9.81f;
+        }
+        realDsp.dcRemoval();
+        realDsp.windowing(FFTWindow::Hamming, FFTDirection::Forward);
+        memcpy(window, vReal, sizeof(window));
+
+        memset(vImag, 0, sizeof(vImag));
+        Clock::time_point t = Clock::now();
+        complexDsp.compute(FFTDirection::Forward);
+        complexDsp.complexToMagnitude();
+        complexTimer.add(elapsedNs(t));
+        std::vector<float> reference(vReal, vReal + bins);
+
+        memcpy(vReal, window, sizeof(window));
+        t = Clock::now();
+        realDsp.computeReal();
+        realDsp.complexToMagnitudeReal();
+        realTimer.add(elapsedNs(t));
+
+        const float largest = *std::max_element(reference.begin(), reference.end());
+        for (unsigned int k = 0; k < bins; k++) {
+            worst = std::max(worst, std::fabs(vReal[k] - reference[k]) / std::max(largest, 1e-12f));
+        }
+    }
+
+    printf("Spectrum over %zu windows, %u bins (ns):\n", recordings.size(), bins);
+    complexTimer.print();
+    realTimer.print();
+    printf("Speedup: %.2fx, worst difference %.2e of the largest bin (tolerance %.0e)\n",
+           (double)complexTimer.total() / std::max(realTimer.total(), (uint64_t)1), worst, tolerance);
+
+    if (recordings.empty() || !(worst <= tolerance)) {
+        fprintf(stderr, "FAILED: real-input FFT magnitudes differ from the complex FFT\n");
+        return 1;
+    }
+    return 0;
+}
+
+unsigned long schedulerClock() {
+    return schedulerNow;
+}
+
+void fastTask() {                  // 1 ms period, 100 us of work
+    schedulerNow += 100;
+    schedulerTrace += 'f';
+}
+
+void slowTask() {                  // 5 ms period, 950 us against a 200 us budget, then fires the urgent event
+    schedulerNow += 950;
+    schedulerUnderTest->trigger(schedulerUrgent);
+    schedulerTrace += 's';
+}
+
+void urgentTask() {                // Event, 200 us deadline
+    schedulerNow += 50;
+    schedulerTrace += 'u';
+}
+
+void hogTask() {                   // Event without budget that blocks for 3.5 ms
+    schedulerNow += 3500;
+    schedulerTrace += 'h';
+}
+
+int runSchedulerCheck() {
+    schedulerNow = 0;
+    Scheduler scheduler(schedulerClock);
+    schedulerUnderTest = &scheduler;
+    int fast = scheduler.addPeriodic("fast", fastTask, 1000, 200);
+    int slow = scheduler.addPeriodic("slow", slowTask, 5000, 200);
+    schedulerUrgent = scheduler.addEvent("urgent", urgentTask, 100, 200);
+    schedulerHog = scheduler.addEvent("hog", hogTask, 0, 100000);
+
+    // 50 ms undisturbed, then the hog blocks once and fast falls behind
+    while (schedulerNow < 50000) {
+        if (!scheduler.runOnce()) schedulerNow += 10;
+    }
+    const Scheduler::TaskStats fastStats = scheduler.getStats(fast);
+    const Scheduler::TaskStats slowStats = scheduler.getStats(slow);
+    const Scheduler::TaskStats urgentStats = scheduler.getStats(schedulerUrgent);
+    // Slow overlaps the next fast release, so urgent (200 us deadline) and fast (1 ms) are
+    // pending together each time and urgent must go first
+    bool urgentFirst = true;
+    for (size_t i = schedulerTrace.find('s'); i != std::string::npos; i = schedulerTrace.find('s', i + 1)) {
+        urgentFirst = urgentFirst && schedulerTrace.compare(i, 3, "suf") == 0;
+    }
+
+    scheduler.trigger(schedulerHog);
+    scheduler.trigger(schedulerHog);   // Still pending: must not queue a second run
+    while (schedulerNow < 60000) {
+        if (!scheduler.runOnce()) schedulerNow += 10;
+    }
+    const Scheduler::TaskStats& hogStats = scheduler.getStats(schedulerHog);
+    const Scheduler::TaskStats& fastAfter = scheduler.getStats(fast);
+
+    printf("SCHEDULER: fast %lu runs, slow %lu runs (%lu overruns), urgent %lu runs, "
+           "hog %lu run -> fast %lu skipped releases\n",
+           (unsigned long)fastStats.runs, (unsigned long)slowStats.runs, (unsigned long)slowStats.overruns,
+           (unsigned long)urgentStats.runs, (unsigned long)hogStats.runs, (unsigned long)fastAfter.skippedReleases);
+
+    if (fastStats.runs != 50 || slowStats.runs != 10 || fastStats.overruns != 0 || fastStats.deadlineMisses != 0 ||
+        fastStats.skippedReleases != 0) {
+        fprintf(stderr, "FAILED: periodic releases wrong (fast %lu, slow %lu)\n",
+                (unsigned long)fastStats.runs, (unsigned long)slowStats.runs);
+        return 1;
+    }
+    if (slowStats.overruns != slowStats.runs || slowStats.maxUs != 950 || slowStats.deadlineMisses != 0) {
+        fprintf(stderr, "FAILED: slow task overruns not counted\n");
+        return 1;
+    }
+    if (urgentStats.runs != slowStats.runs || urgentStats.deadlineMisses != 0 || !urgentFirst) {
+        fprintf(stderr, "FAILED: urgent event did not run first (%lu runs, trace %s)\n",
+                (unsigned long)urgentStats.runs, schedulerTrace.substr(0, 40).c_str());
+        return 1;
+    }
+    // The releases fast lost under the hog are dropped, the next one runs on time
+    if (hogStats.runs != 1 || hogStats.overruns != 0 || fastAfter.skippedReleases < 2 || fastAfter.deadlineMisses != 0) {
+        fprintf(stderr, "FAILED: blocking task did not show up as skipped releases\n");
+        return 1;
+    }
+    return 0;
+}
+
+// Overfills the ring the way a burst between idle passes would and checks that the
+// producer side never blocks, overflow is counted and drain() empties it in slices
+int runLogCheck() {
+    Log::drain();
+    const uint32_t droppedBefore = Log::getDropped();
+    const size_t burst = LogConfig::RING_SIZE + 3;
+
+    Clock::time_point t = Clock::now();
+    for (size_t i = 0; i < burst; i++) {
+        Log::write(LOG_LEVEL_INFO, "burst %u of %u, %f", (unsigned)i, (unsigned)burst, i * 0.5f);
+    }
+    uint64_t ns = elapsedNs(t);
+
+    if (Log::pending() != LogConfig::RING_SIZE || Log::getDropped() - droppedBefore != burst - LogConfig::RING_SIZE) {
+        fprintf(stderr, "FAILED: %zu pending, %lu dropped after a burst of %zu\n", Log::pending(),
+                (unsigned long)(Log::getDropped() - droppedBefore), burst);
+        return 1;
+    }
+    size_t passes = 0;
+    while (Log::pending() > 0) {
+        size_t expected = std::min<size_t>(LogConfig::DRAIN_PER_IDLE, Log::pending());
+        if (Log::drain(LogConfig::DRAIN_PER_IDLE) != expected) {
+            break;
+        }
+        passes++;
+    }
+    if (Log::pending() != 0 || passes != (LogConfig::RING_SIZE + LogConfig::DRAIN_PER_IDLE - 1) / LogConfig::DRAIN_PER_IDLE) {
+        fprintf(stderr, "FAILED: ring not drained in %u-record slices (%zu passes)\n", LogConfig::DRAIN_PER_IDLE, passes);
+        return 1;
+    }
+    Log::write(LOG_LEVEL_INFO, "text %s", "0123456789abcdefghijklmnopqrstuvwxyz");
+    Log::write(LOG_LEVEL_INFO, "no args");
+    if (Log::drain() != 2) {
+        fprintf(stderr, "FAILED: text records not drained\n");
+        return 1;
+    }
+    printf("LOG: %zu-record burst in %llu ns (%.1f ns/record), %zu dropped, drained in %zu idle passes\n", burst,
+           (unsigned long long)ns, (double)ns / burst, burst - LogConfig::RING_SIZE, passes);
+    return 0;
+}
+
+void drainLogAtExit() {
+    Log::drain();
+    fprintf(stderr, "log: %lu records written, %lu dropped\n", (unsigned long)Log::getWritten(),
+            (unsigned long)Log::getDropped());
+}
+
+} // namespace
+
+// Decodes the batched notifications and compares them record by record with what was sent
+static int checkPredictionStream(const std::vector<std::vector<uint8_t> >& packets,
+                                 const std::vector<std::vector<float> >& sent, const std::vector<uint32_t>& timestamps,
+                                 unsigned long streamBytes, unsigned long legacyNotifications) {
+    size_t index = 0;
+    for (size_t p = 0; p < packets.size(); p++) {
+        const std::vector<uint8_t>& packet = packets[p];
+        size_t count = packet.empty() ? 0 : packet[0];
+        if (count == 0 || packet.size() != BLEConfig::PREDICTION_STREAM_HEADER_SIZE + count * BLEConfig::PREDICTION_RECORD_SIZE) {
+            fprintf(stderr, "FAILED: stream packet %zu is malformed\n", p);
+            return 1;
+        }
+        for (size_t r = 0; r < count; r++, index++) {
+            const uint8_t* record = &packet[BLEConfig::PREDICTION_STREAM_HEADER_SIZE + r * BLEConfig::PREDICTION_RECORD_SIZE];
+            uint16_t sequence;
+            uint32_t timestamp;
+            memcpy(&sequence, record, sizeof(sequence));
+            memcpy(&timestamp, &record[2], sizeof(timestamp));
+            bool match = index < sent.size() && sequence == (uint16_t)index && timestamp == timestamps[index] &&
+                         record[6] == argmax(sent[index].data(), 3);
+            for (int c = 0; match && c < 3; c++) {
+                match = fabsf(record[7 + c] / 255.0f - sent[index][c]) <= 0.5f / 255.0f + 1e-6f;
+            }
+            if (!match) {
+                fprintf(stderr, "FAILED: stream record %zu (sequence %u) does not match the prediction\n", index, sequence);
+                return 1;
+            }
+        }
+    }
+    if (index != sent.size() || legacyNotifications != 0) {
+        fprintf(stderr, "FAILED: %zu of %zu predictions streamed, %lu legacy notifications\n", index, sent.size(),
+                legacyNotifications);
+        return 1;
+    }
+    printf("STREAM: %zu records in %zu notifications (%.1f per notification), %lu bytes vs %zu as single floats\n",
+           index, packets.size(), packets.empty() ? 0.0 : (double)index / packets.size(), streamBytes,
+           sent.size() * 3 * sizeof(float));
+    return 0;
+}
+
+static float probabilities[3];
+
+// Same decision path as the sketch: gate, then DSP and inference only for motion
+static void classifyWindow(SignalProcessing& signalProc, NeuralNetworkBikeLock& NN,
+                           StageTimer& gate, StageTimer& process, StageTimer& inference) {
+    Clock::time_point t = Clock::now();
+    bool moving = signalProc.detectMotion();
+    if (!moving) signalProc.getStationaryProbabilities(probabilities);
+    gate.add(elapsedNs(t));
+    if (!moving) return;
+
+    t = Clock::now();
+    signalProc.processData();
+    process.add(elapsedNs(t));
+
+    t = Clock::now();
+    NN.getPredictionProbabilities(signalProc.getFeatures(), probabilities);
+    inference.add(elapsedNs(t));
+}
+
+int main(int argc, char** argv) {
+    bool continuous = false;
+    bool sliding = false;
+    bool verbose = false;
+    int repeat = 1;
+    int synthetic = 0;
+    int benchmarkIterations = 0;
+    bool weights = false;
+    int mtu = 247;
+    int deltaSteps = 0;
+    bool logCheck = false;
+    bool schedulerCheck = false;
+    bool stream = false;
+    int trainEpochs = 0;
+    int backendIterations = 0;
+    int maxBatch = 0;
+    int prunePercent = 0;
+    int cascadePercent = 0;
+    bool storeCheck = false;
+    bool fixedPoint = false;
+    int featureIterations = 0;
+    bool realFft = false;
+    std::string path;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--continuous") continuous = true;
+        else if (arg == "--sdft") sliding = continuous = true;
+        else if (arg == "--verbose") verbose = true;
+        else if (arg == "--weights") weights = true;
+        else if (arg == "--log") logCheck = true;
+        else if (arg == "--scheduler") schedulerCheck = true;
+        else if (arg == "--stream") stream = true;
+        else if (arg == "--store") storeCheck = true;
+        else if (arg == "--q15") fixedPoint = true;
+        else if (arg == "--fft") realFft = true;
+        else if (arg == "--repeat" && i + 1 < argc) repeat = atoi(argv[++i]);
+        else if (arg == "--synthetic" && i + 1 < argc) synthetic = atoi(argv[++i]);
+        else if (arg == "--benchmark" && i + 1 < argc) benchmarkIterations = atoi(argv[++i]);
+        else if (arg == "--mtu" && i + 1 < argc) mtu = atoi(argv[++i]);
+        else if (arg == "--delta" && i + 1 < argc) deltaSteps = atoi(argv[++i]);
+        else if (arg == "--train" && i + 1 < argc) trainEpochs = atoi(argv[++i]);
+        else if (arg == "--backends" && i + 1 < argc) backendIterations = atoi(argv[++i]);
+        else if (arg == "--batch" && i + 1 < argc) maxBatch = atoi(argv[++i]);
+        else if (arg == "--prune" && i + 1 < argc) prunePercent = atoi(argv[++i]);
+        else if (arg == "--cascade" && i + 1 < argc) cascadePercent = atoi(argv[++i]);
+        else if (arg == "--features" && i + 1 < argc) featureIterations = atoi(argv[++i]);
+        else if (!arg.empty() && arg[0] != '-') path = arg;
+        else {
+            fprintf(stderr, "usage: %s [--continuous] [--sdft] [--repeat N] [--synthetic N] [--benchmark N] [--weights] [--delta N] [--train N] [--backends N] [--batch N] [--prune P] [--cascade P] [--mtu N] [--stream] [--store] [--q15] [--features N] [--fft] [--scheduler] [--log] [--verbose] [recordings.csv]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    Serial.setEnabled(verbose);
+    if (verbose) {
+        atexit(drainLogAtExit);
+    }
+    if (!path.empty() && !IMU.load(path)) {
+        fprintf(stderr, "No recordings found in %s\n", path.c_str());
+        return 1;
+    }
+    if (path.empty() && synthetic == 0) synthetic = 10;
+    if (synthetic > 0) addSyntheticRecordings(IMU, synthetic);
+
+    // Same bring-up order as setup()
+    static Communication bleComm;
+    static NeuralNetworkBikeLock NN;
+    static SignalProcessing signalProc;
+    randomSeed(42);
+    if (!bleComm.begin() || !signalProc.begin()) {
+        fprintf(stderr, "Firmware init failed\n");
+        return 1;
+    }
+    NN.init(NNConfig::LAYERS, nullptr, NNConfig::NUM_LAYERS);
+    ATT.fakeSetMtu((uint16_t)constrain(mtu, 23, 517));
+    BLE.fakeConnect(true);
+
+    if (logCheck) {
+        return runLogCheck();
+    }
+    if (schedulerCheck) {
+        return runSchedulerCheck();
+    }
+    if (weights) {
+        return runWeightRoundTrip(bleComm, NN);
+    }
+    if (deltaSteps > 0) {
+        return runDeltaSync(bleComm, NN, signalProc, deltaSteps);
+    }
+    if (trainEpochs > 0) {
+        return runBackgroundTraining(bleComm, NN, signalProc, trainEpochs);
+    }
+    if (backendIterations > 0) {
+        return runBackendComparison(NN, signalProc, backendIterations);
+    }
+    if (maxBatch > 0) {
+        return runBatchInference(signalProc, maxBatch);
+    }
+    if (storeCheck) {
+        return runModelStore(NN, signalProc);
+    }
+    if (fixedPoint) {
+        return runFixedPoint(NN, signalProc);
+    }
+    if (featureIterations > 0) {
+        return runFeatureExtraction(featureIterations);
+    }
+    if (realFft) {
+        return runRealFft();
+    }
+    if (cascadePercent > 0) {
+        return runCascade(bleComm, NN, signalProc, cascadePercent);
+    }
+    if (prunePercent > 0) {
+        return runPruning(NN, signalProc, prunePercent);
+    }
+    if (benchmarkIterations > 0) {
+        return runBenchmark(bleComm, NN, signalProc, (uint16_t)benchmarkIterations);
+    }
+
+    const std::vector<Recording>& recordings = IMU.getRecordings();
+    printf("Replaying %zu recordings x%d, %s mode, %s engine\n", recordings.size(), repeat,
+           continuous ? "continuous" : "window", sliding ? "sliding DFT" : "FFT");
+
+    StageTimer acquire("acquire"), gate("detectMotion"), process("processData"), inference("inference"), send("sendPrediction");
+    StageTimer dspWindow("dsp.dc+window"), dspFft("dsp.fft"), dspMagnitude("dsp.magnitude"), dspFeatures("dsp.features");
+    unsigned long windows = 0;
+    bool finite = true;
+    unsigned long confusion[3][3] = {};
+
+    // Stream mode: what each window sent, to check the batched records against
+    std::vector<std::vector<uint8_t> > streamPackets;
+    std::vector<std::vector<float> > sentPredictions;
+    std::vector<uint32_t> sentTimestamps;
+    BLECharacteristic* streamChar = BLE.fakeCharacteristic(BLEConfig::PREDICTION_STREAM_CHAR_UUID);
+    if (stream) {
+        streamChar->fakeSubscribe(true);
+        streamChar->fakeOnNotify(collectPacket, &streamPackets);
+    }
+
+    Clock::time_point wallStart = Clock::now();
+    for (int r = 0; r < repeat; r++) {
+        if (continuous) {
+            IMU.selectAll();
+            // Selected the way the sketch does it, through SET_FEATURE_ENGINE
+            uint8_t control[2] = {static_cast<uint8_t>(Command::SET_FEATURE_ENGINE),
+                                  static_cast<uint8_t>(sliding ? SignalConfig::FeatureEngine::SLIDING_DFT : SignalConfig::FeatureEngine::FFT)};
+            BLE.fakeCharacteristic(BLEConfig::CONTROL_CHAR_UUID)->fakeWrite(control, sizeof(control));
+            bleComm.update();
+            signalProc.setFeatureEngine(bleComm.getFeatureEngine());
+            bleComm.resetState();
+            signalProc.startContinuous();
+            while (!IMU.exhausted()) {
+                Clock::time_point t = Clock::now();
+                bool ready = signalProc.update();
+                acquire.add(elapsedNs(t));
+                if (!ready) {
+                    if (stream) bleComm.update();   // Age-based flushes
+                    continue;
+                }
+
+                classifyWindow(signalProc, NN, gate, process, inference);
+
+                t = Clock::now();
+                bleComm.sendPrediction(probabilities, 3, signalProc.getWindowEndMs());
+                send.add(elapsedNs(t));
+                sentPredictions.push_back(std::vector<float>(probabilities, probabilities + 3));
+                sentTimestamps.push_back(signalProc.getWindowEndMs());
+
+                finite = finite && allFinite(probabilities, 3);
+                windows++;
+            }
+            signalProc.stopContinuous();
+            continue;
+        }
+
+        for (size_t i = 0; i < recordings.size(); i++) {
+            IMU.select(i);
+
+            Clock::time_point t = Clock::now();
+            signalProc.collectData();
+            acquire.add(elapsedNs(t));
+
+            classifyWindow(signalProc, NN, gate, process, inference);
+
+            t = Clock::now();
+            bleComm.sendPrediction(probabilities, 3, signalProc.getWindowEndMs());
+            send.add(elapsedNs(t));
+            sentPredictions.push_back(std::vector<float>(probabilities, probabilities + 3));
+            sentTimestamps.push_back(signalProc.getWindowEndMs());
+
+            finite = finite && allFinite(probabilities, 3);
+            int label = recordings[i].label;
+            if (label >= 0 && label < 3) confusion[label][argmax(probabilities, 3)]++;
+            windows++;
+
+            timeDspBreakdown(recordings[i], dspWindow, dspFft, dspMagnitude, dspFeatures);
+        }
+    }
+    uint64_t wallNs = elapsedNs(wallStart);
+
+    printf("\nStage timings (ns):\n");
+    acquire.print();
+    gate.print();
+    process.print();
+    inference.print();
+    send.print();
+    if (!continuous) {
+        printf("\nprocessData() breakdown (ns):\n");
+        dspWindow.print();
+        dspFft.print();
+        dspMagnitude.print();
+        dspFeatures.print();
+    }
+
+    // Acquisition is paced by the virtual clock, so throughput counts compute only
+    uint64_t computeNs = gate.total() + process.total() + inference.total() + send.total();
+    printf("\nWindows: %lu  IMU samples: %lu  held: %lu\n", windows, IMU.samplesRead(), signalProc.getHeldSamples());
+    if (computeNs > 0) {
+        printf("Throughput: %.1f windows/s (compute), %.1f windows/s (wall)\n",
+               windows * 1e9 / computeNs, windows * 1e9 / wallNs);
+    }
+    printf("Motion gate: %lu/%lu windows skipped, noise floor %.3f m/s^2\n", signalProc.getWindowsSkipped(),
+           signalProc.getWindowsChecked(), signalProc.getNoiseFloor());
+    BLECharacteristic* prediction = BLE.fakeCharacteristic(BLEConfig::PREDICTION_CHAR_UUID);
+    if (prediction) {
+        printf("BLE predictions: %lu notifications, %lu bytes\n", prediction->notifyCount(), prediction->notifyBytes());
+    }
+    if (!continuous) {
+        printf("Confusion (rows = label, cols = predicted):\n");
+        for (int l = 0; l < 3; l++) {
+            printf("  %d: %6lu %6lu %6lu\n", l, confusion[l][0], confusion[l][1], confusion[l][2]);
+        }
+    }
+
+    if (windows == 0 || !finite) {
+        fprintf(stderr, "FAILED: %s\n", windows == 0 ? "no windows classified" : "non-finite prediction");
+        return 1;
+    }
+    if (stream) {
+        bleComm.flushPredictions();
+        return checkPredictionStream(streamPackets, sentPredictions, sentTimestamps,
+                                     streamChar->notifyBytes(), prediction ? prediction->notifyCount() : 0);
+    }
+    return 0;
+}
@@ -527,6 +527,20 @@ bool ATTClass::paired(uint16_t handle) const
   return false; // unknown handle
 }
 
+/*
+ * Return the MTU of the first connected peer, 23 if none is connected
+ */
+uint16_t ATTClass::mtu() const
+{
+  for (int i = 0; i < ATT_MAX_PEERS; i++) {
+    if (_peers[i].connectionHandle != 0xffff) {
+      return _peers[i].mtu;
+    }
+  }
+
+  return 23;
+}
+
 uint16_t ATTClass::mtu(uint16_t handle) const
 {
   for (int i = 0; i < ATT_MAX_PEERS; i++) {
@@ -77,6 +77,7 @@ public:
   virtual bool connected(uint16_t handle) const;
   virtual bool paired() const;
   virtual bool paired(uint16_t handle) const;
+  virtual uint16_t mtu() const;
   virtual uint16_t mtu(uint16_t handle) const;
 
   virtual bool disconnect();
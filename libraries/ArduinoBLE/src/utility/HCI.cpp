@@ -648,6 +648,11 @@ int HCIClass::sendAclPkt(uint16_t handle, uint8_t cid, uint8_t plen, void* data)
   return 0;
 }
 
+uint8_t HCIClass::availableAclPackets() const
+{
+  return (_pendingPkt < _maxPkt) ? (_maxPkt - _pendingPkt) : 0;
+}
+
 int HCIClass::disconnect(uint16_t handle)
 {
     struct __attribute__ ((packed)) HCIDisconnectData {
@@ -111,6 +111,8 @@ public:
   virtual int tryResolveAddress(uint8_t* BDAddr, uint8_t* address);
 
   virtual int sendAclPkt(uint16_t handle, uint8_t cid, uint8_t plen, void* data);
+  // Controller ACL buffers still free; sendAclPkt() blocks in poll() when this is 0
+  virtual uint8_t availableAclPackets() const;
 
   virtual int disconnect(uint16_t handle);
 
@@ -125,6 +125,25 @@ int LSM9DS1Class::readAcceleration(float& x, float& y, float& z)
   return 1;
 }
 
+int LSM9DS1Class::readRawAcceleration(int16_t& x, int16_t& y, int16_t& z)
+{
+  int16_t data[3];
+
+  if (!readRegisters(LSM9DS1_ADDRESS, LSM9DS1_OUT_X_XL, (uint8_t*)data, sizeof(data))) {
+    x = 0;
+    y = 0;
+    z = 0;
+
+    return 0;
+  }
+
+  x = data[0];
+  y = data[1];
+  z = data[2];
+
+  return 1;
+}
+
 int LSM9DS1Class::accelerationAvailable()
 {
   if (continuousMode) {
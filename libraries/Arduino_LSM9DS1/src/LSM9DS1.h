@@ -35,6 +35,7 @@ class LSM9DS1Class {
 
     // Accelerometer
     virtual int readAcceleration(float& x, float& y, float& z); // Results are in g (earth gravity).
+    virtual int readRawAcceleration(int16_t& x, int16_t& y, int16_t& z); // Register counts, 8192 per g (4 g range).
     virtual int accelerationAvailable(); // Number of samples in the FIFO.
     virtual float accelerationSampleRate(); // Sampling rate of the sensor.
 
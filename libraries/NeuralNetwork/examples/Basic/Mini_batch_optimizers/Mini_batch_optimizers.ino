@@ -0,0 +1,111 @@
+#define NumberOf(arg) ((unsigned int) (sizeof (arg) / sizeof (arg [0]))) // calculates the number of layers (in this case 3)
+#define _1_OPTIMIZE 0B00010000 // https://github.com/GiorgosXou/NeuralNetworks#define-macro-properties
+
+#include <NeuralNetwork.h>
+
+// Trains the same NNs on a 3-input-xor and on 14 accelerometer FFT feature-vectors (moving or not), once with BackProp
+// after every input and then with mini-batches through each optimizer, and prints the epochs and time each one took to reach TARGET_MSE
+
+#define TARGET_MSE 0.003
+#define MAX_EPOCHS 5000
+
+const unsigned int xorLayers[] = {3, 5, 1};
+const float xorInputs[8][3] = {
+  {0, 0, 0}, // = 0
+  {0, 0, 1}, // = 1
+  {0, 1, 0}, // = 1
+  {0, 1, 1}, // = 0
+  {1, 0, 0}, // = 1
+  {1, 0, 1}, // = 0
+  {1, 1, 0}, // = 0
+  {1, 1, 1}  // = 1
+};
+const float xorExpected[8][1] = {{0}, {1}, {1}, {0}, {1}, {0}, {0}, {1}};
+
+// 8 frequency bins (0-5, 5-10, 10-15, 15-20, 20-25, 25-30, 30-40, 40-50 Hz) + mean, max and variance, from FFTwithNN
+const unsigned int fftLayers[] = {11, 20, 1};
+const float fftInputs[14][11] = {
+  {57.928509,14.470326,8.354366,4.072833,2.259012,2.115621,1.281847,1.137330,9.081741,162.061386,20.795198},
+  {0.249636,0.310526,0.284251,0.289740,0.276506,0.293029,0.275930,0.285157,0.282762,0.590756,0.083509},
+  {40.523720,14.090983,11.033436,5.623566,3.171416,2.047416,1.925643,1.129067,8.056471,79.404900,12.813414},
+  {0.092623,0.091632,0.147428,0.062245,0.073431,0.047236,0.038493,0.050569,0.069262,0.294503,0.055974},
+  {50.662792,22.568745,12.957399,6.475854,3.548554,3.598305,2.184609,1.502175,10.462087,97.633827,16.766186},
+  {0.192281,0.201777,0.132999,0.078350,0.067252,0.057038,0.052922,0.044456,0.091942,0.479395,0.089565},
+  {47.318878,24.611332,5.407272,3.697110,3.413770,2.539831,1.273825,1.078464,8.923025,116.080383,16.665312},
+  {0.096454,0.077746,0.091129,0.032084,0.041571,0.028106,0.035343,0.026464,0.048864,0.288771,0.048027},
+  {36.649235,14.464705,9.048715,3.719692,3.130369,1.862029,1.483838,0.957352,7.190089,118.930450,14.377792},
+  {0.150395,0.195433,0.131368,0.051687,0.052537,0.041452,0.052452,0.047448,0.082054,0.858473,0.104018},
+  {31.517038,13.517478,13.759942,2.860543,2.029840,2.100289,1.336743,1.164108,6.926655,67.461426,11.004887},
+  {2.016347,2.704451,4.680589,3.015826,2.751961,2.217993,1.735959,0.939064,2.276168,11.290654,1.567029},
+  {41.681168,11.800854,8.496819,3.517949,1.820635,1.602628,1.353350,1.173330,7.174771,179.494263,18.839750},
+  {1.715903,2.167234,2.968738,1.863114,1.737162,2.312426,1.199850,1.066952,1.725375,7.378445,1.031108}
+};
+const float fftExpected[14][1] = {{1}, {0}, {1}, {0}, {1}, {0}, {1}, {0}, {1}, {0}, {1}, {0}, {1}, {0}};
+
+// batchSize 0 means BackProp after each input
+void train(const char *name, const unsigned int *layers, const unsigned int &numberOfLayers, const float *inputs, const float *expected, const unsigned int &numberOfInputs, const byte &optimizer, const float &learningRate, const unsigned int &batchSize)
+{
+  const unsigned int inputSize  = layers[0];
+  const unsigned int outputSize = layers[numberOfLayers - 1];
+
+  randomSeed(1); // same initial weights for every run
+  NeuralNetwork NN(layers, numberOfLayers, learningRate, learningRate);
+  if (batchSize != 0)
+    NN.setOptimizer(optimizer); // allocates the gradients (and the optimizer's state) before the clock starts
+
+  unsigned int epoch = 0;
+  float mse;
+  unsigned long start = micros();
+  do{
+    epoch++;
+    for (unsigned int j = 0; j < numberOfInputs; j++)
+    {
+      NN.FeedForward(&inputs[j * inputSize]);
+      if (batchSize == 0){
+        NN.BackProp(&expected[j * outputSize]);
+      }else{
+        NN.AccumulateGradients(&expected[j * outputSize]);
+        if ((j + 1) % batchSize == 0 || j == numberOfInputs - 1) // the last batch of an epoch may be smaller
+          NN.ApplyGradients((j % batchSize) + 1);
+      }
+    }
+    mse = NN.getMeanSqrdError(numberOfInputs);
+  }while(mse > TARGET_MSE && epoch < MAX_EPOCHS);
+  unsigned long elapsed = micros() - start;
+
+  Serial.print(name);
+  Serial.print(F(" (LR "));
+  Serial.print(learningRate, 2);
+  if (batchSize != 0){
+    Serial.print(F(", batch "));
+    Serial.print(batchSize);
+  }
+  Serial.print(F("): "));
+  Serial.print(epoch);
+  Serial.print((mse > TARGET_MSE) ? F(" epochs (target not reached), ") : F(" epochs, "));
+  Serial.print(elapsed / 1000.0, 1);
+  Serial.print(F(" ms, MSE "));
+  Serial.println(mse, 6);
+}
+
+void benchmark(const char *dataset, const unsigned int *layers, const unsigned int &numberOfLayers, const float *inputs, const float *expected, const unsigned int &numberOfInputs)
+{
+  Serial.print(F("\n =-["));
+  Serial.print(dataset);
+  Serial.println(F("]-="));
+  train("BackProp", layers, numberOfLayers, inputs, expected, numberOfInputs, OPTIMIZER_SGD     , 0.33, 0);
+  train("SGD     ", layers, numberOfLayers, inputs, expected, numberOfInputs, OPTIMIZER_SGD     , 1.32, 4); // 4 * 0.33, as gradients are averaged over the batch
+  train("Momentum", layers, numberOfLayers, inputs, expected, numberOfInputs, OPTIMIZER_MOMENTUM, 0.2 , 4);
+  train("Adam    ", layers, numberOfLayers, inputs, expected, numberOfInputs, OPTIMIZER_ADAM    , 0.05, 4);
+}
+
+void setup()
+{
+  Serial.begin(9600);
+  while (!Serial);
+
+  benchmark("3-INPUT XOR", xorLayers, NumberOf(xorLayers), &xorInputs[0][0], &xorExpected[0][0], NumberOf(xorInputs));
+  benchmark("FFT FEATURES", fftLayers, NumberOf(fftLayers), &fftInputs[0][0], &fftExpected[0][0], NumberOf(fftInputs));
+}
+
+void loop() {}
@@ -314,7 +314,7 @@
 #endif
 
 // Disable SIMD parallel processing if double-precision or int-quntization is enabled
-#if defined(CONFIG_IDF_TARGET_ESP32S3) || defined(USE_ESP_SIMD)
+#if (defined(CONFIG_IDF_TARGET_ESP32S3) || defined(USE_ESP_SIMD)) and !defined(NO_SIMD)
     #if defined(USE_64_BIT_DOUBLE)
         #undef MSG7
         #define MSG7 \n- " [1] 0B00000001 [ⓘ] [𝗥𝗲𝗺𝗶𝗻𝗱𝗲𝗿] SIMD disabled, there is no support when double precision."
@@ -327,6 +327,119 @@
     #endif
 #endif
 
+// Dot-product backend of Layer::FeedForward, picked at compile time from the target (#define NO_SIMD for the plain loop)
+// CMSIS-DSP is used on Cortex-M with an FPU when USE_CMSIS_DSP is defined or arm_math.h was included before this file
+#define SIMD_BACKEND "scalar"
+#if defined(ESP_SUPPORTS_SIMD)
+    #define SUPPORTS_SIMD
+    #define SIMD_DOTPROD dsps_dotprod_f32
+    #undef  SIMD_BACKEND
+    #define SIMD_BACKEND "ESP-DSP"
+#elif !defined(NO_SIMD) and !defined(USE_64_BIT_DOUBLE) and !defined(USE_INT_QUANTIZATION)
+    #if defined(__ARM_FP) and (defined(USE_CMSIS_DSP) or defined(_ARM_MATH_H) or defined(ARM_MATH_H))
+        #include <arm_math.h>
+        #define SUPPORTS_SIMD
+        #define CMSIS_SUPPORTS_SIMD
+        #undef  SIMD_BACKEND
+        #define SIMD_BACKEND "CMSIS-DSP"
+    #elif defined(__AVX2__) and defined(__FMA__)
+        #include <immintrin.h>
+        #define SUPPORTS_SIMD
+        #define AVX2_SUPPORTS_SIMD
+        #undef  SIMD_BACKEND
+        #define SIMD_BACKEND "AVX2"
+    #elif defined(__SSE__)
+        #include <xmmintrin.h>
+        #define SUPPORTS_SIMD
+        #define SSE_SUPPORTS_SIMD
+        #undef  SIMD_BACKEND
+        #define SIMD_BACKEND "SSE"
+    #elif defined(__aarch64__) and defined(__ARM_NEON)
+        #include <arm_neon.h>
+        #define SUPPORTS_SIMD
+        #define NEON_SUPPORTS_SIMD
+        #undef  SIMD_BACKEND
+        #define SIMD_BACKEND "NEON"
+    #endif
+    #if defined(SUPPORTS_SIMD)
+        #define SIMD_DOTPROD simd_dotprod_f32
+        #undef MSG7
+        #define MSG7 \n- " [ⓘ] [𝗥𝗲𝗺𝗶𝗻𝗱𝗲𝗿] FeedForward uses the " SIMD_BACKEND " dot-product, sums may differ in the last bits from the plain loop (NO_SIMD)."
+    #endif
+#endif
+
+// Same arguments as dsps_dotprod_f32: *dest = sum of src1[j] * src2[j]. The vector backends keep several partial sums and add them up at the end, loads are unaligned
+#if defined(CMSIS_SUPPORTS_SIMD)
+    inline void simd_dotprod_f32(const float *src1, const float *src2, float *dest, const unsigned int &len)
+    {
+        arm_dot_prod_f32((float32_t *)src1, (float32_t *)src2, len, dest); // older CMSIS-DSP versions take non-const sources
+    }
+#elif defined(AVX2_SUPPORTS_SIMD)
+    inline void simd_dotprod_f32(const float *src1, const float *src2, float *dest, const unsigned int &len)
+    {
+        __m256 acc0 = _mm256_setzero_ps();
+        __m256 acc1 = _mm256_setzero_ps(); // two chains so the FMAs don't wait for each other
+        unsigned int j = 0;
+        for (; j + 16 <= len; j += 16){
+            acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(&src1[j    ]), _mm256_loadu_ps(&src2[j    ]), acc0);
+            acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(&src1[j + 8]), _mm256_loadu_ps(&src2[j + 8]), acc1);
+        }
+        if (j + 8 <= len){
+            acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(&src1[j]), _mm256_loadu_ps(&src2[j]), acc0);
+            j += 8;
+        }
+        acc0 = _mm256_add_ps(acc0, acc1);
+        __m128 sum4 = _mm_add_ps(_mm256_castps256_ps128(acc0), _mm256_extractf128_ps(acc0, 1));
+        sum4 = _mm_add_ps(sum4, _mm_movehl_ps(sum4, sum4));
+        sum4 = _mm_add_ss(sum4, _mm_shuffle_ps(sum4, sum4, 1));
+        float sum = _mm_cvtss_f32(sum4);
+        for (; j < len; j++)
+            sum += src1[j] * src2[j];
+        *dest = sum;
+    }
+#elif defined(SSE_SUPPORTS_SIMD)
+    inline void simd_dotprod_f32(const float *src1, const float *src2, float *dest, const unsigned int &len)
+    {
+        __m128 acc0 = _mm_setzero_ps();
+        __m128 acc1 = _mm_setzero_ps();
+        unsigned int j = 0;
+        for (; j + 8 <= len; j += 8){
+            acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(&src1[j    ]), _mm_loadu_ps(&src2[j    ])));
+            acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(&src1[j + 4]), _mm_loadu_ps(&src2[j + 4])));
+        }
+        if (j + 4 <= len){
+            acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(&src1[j]), _mm_loadu_ps(&src2[j])));
+            j += 4;
+        }
+        acc0 = _mm_add_ps(acc0, acc1);
+        acc0 = _mm_add_ps(acc0, _mm_movehl_ps(acc0, acc0));
+        acc0 = _mm_add_ss(acc0, _mm_shuffle_ps(acc0, acc0, 1));
+        float sum = _mm_cvtss_f32(acc0);
+        for (; j < len; j++)
+            sum += src1[j] * src2[j];
+        *dest = sum;
+    }
+#elif defined(NEON_SUPPORTS_SIMD)
+    inline void simd_dotprod_f32(const float *src1, const float *src2, float *dest, const unsigned int &len)
+    {
+        float32x4_t acc0 = vdupq_n_f32(0);
+        float32x4_t acc1 = vdupq_n_f32(0);
+        unsigned int j = 0;
+        for (; j + 8 <= len; j += 8){
+            acc0 = vfmaq_f32(acc0, vld1q_f32(&src1[j    ]), vld1q_f32(&src2[j    ]));
+            acc1 = vfmaq_f32(acc1, vld1q_f32(&src1[j + 4]), vld1q_f32(&src2[j + 4]));
+        }
+        if (j + 4 <= len){
+            acc0 = vfmaq_f32(acc0, vld1q_f32(&src1[j]), vld1q_f32(&src2[j]));
+            j += 4;
+        }
+        float sum = vaddvq_f32(vaddq_f32(acc0, acc1));
+        for (; j < len; j++)
+            sum += src1[j] * src2[j];
+        *dest = sum;
+    }
+#endif
+
 // REMINDER DO NOT UNCOMMENT THIS!!!!!! BECAUSE IT WILL RESULT ON ESP32-C3 NOT COMPILING WITH USE_PROGMEM or USE_INTERNAL_EEPROM AT ALL | i keep it here as a future reminder
 // #if defined(ESP_SUPPORTS_SIMD) and (defined(USE_PROGMEM) or defined(USE_INTERNAL_EEPROM))
 //     #error "There's no support for SIMD use with USE_PROGMEM or USE_INTERNAL_EEPROM yet."
@@ -805,13 +918,58 @@ private:
     unsigned int Individual_Input = 0;
     #if !defined(NO_BACKPROP)
         const DFLOAT *_inputs;        // Pointer to primary/first Inputs Array from Sketch    .
+        DFLOAT *gammaBlock = NULL;    // Two buffers as wide as the widest layer input, layers alternate between them for preLgamma so BackProp never allocates
+        void allocateGammas();
+
+        // Mini-batch training, allocated by setOptimizer() (or the first AccumulateGradients()) so plain BackProp costs no RAM for them
+        DFLOAT *gradients      = NULL;  // Sums of each weight's and then each bias' gradient since the last ApplyGradients(), in the same order as the weight arena
+        DFLOAT *optimizerState = NULL;  // OPTIMIZER_MOMENTUM: velocity per parameter | OPTIMIZER_ADAM: 1st moments followed by 2nd moments | OPTIMIZER_SGD: none
+        unsigned int numberOfParameters      = 0; // weights and biases
+        unsigned int numberOfGradientWeights = 0; // where the biases' gradients start
+        unsigned int optimizerStep           = 0; // Adam's t, for its bias correction
+        byte Optimizer = 0;                  // OPTIMIZER_SGD
+        void stepParameters(DFLOAT *parameters, const unsigned int &count, unsigned int &k, const DFLOAT &rate, const DFLOAT &scale);
     #endif
                                   // (Used for backpropagation)                           .
 
+    #if !defined(USE_INTERNAL_EEPROM)
+        // FeedForwardBatch runs BATCH_TILE samples at a time through all the layers, reading each weight once per tile
+        #if !defined(BATCH_TILE)
+            #define BATCH_TILE 4
+        #endif
+        DFLOAT *batchBlock = NULL;   // Two [BATCH_TILE x batchWidth] buffers for a tile's hidden outputs, layers alternate between them | allocated by the first FeedForwardBatch
+        unsigned int batchWidth = 0; // outputs of the widest hidden layer
+    #endif
+
     #if defined(SUPPORTS_SD_FUNCTIONALITY)
         bool isAlreadyLoadedOnce = false; // Determines if load() function has been called more than once, so the next time it will clean | I mean... if you use sd library then you have a spare byte right?
     #endif
 
+    #if !defined(REDUCE_RAM_WEIGHTS_COMMON)
+        // A layer's [_numberOfOutputs x _numberOfInputs] weights as rows of one flat array, so weights[i][j] (weight j of neuron i) costs no pointer per row
+        struct WeightRows
+        {
+            IS_CONST IDFLOAT *flat;   // weights[0][0], row-major
+            unsigned int      stride; // _numberOfInputs
+            IS_CONST IDFLOAT *operator[](const unsigned int &i) const { return &flat[i * stride]; }
+        };
+
+        // Weight arena: one ARENA_ALIGNMENT-aligned allocation per network (constructors that generate the weights and load()) holding
+        // every layer's weights, row-major and layer after layer (the same order as default_Weights and REDUCE_RAM_WEIGHTS_LVL2's NN.weights),
+        // followed by every layer's biases (1 per layer, _numberOfOutputs per layer if MULTIPLE_BIASES_PER_LAYER, none if NO_BIAS)
+        #define ARENA_ALIGNMENT 16
+        IDFLOAT *arenaBlock   = NULL; // as returned by new[], for delete[]
+        IDFLOAT *arena        = NULL; // aligned start of the weights
+        unsigned int arenaWeightsAt = 0; // cursors of the layers being built
+        unsigned int arenaBiasesAt  = 0;
+
+        void allocateArena(const unsigned int &numberOfWeights, const unsigned int &numberOfBiases);
+        WeightRows arenaWeights(const unsigned int &NumberOfInputs, const unsigned int &NumberOfOutputs);
+        #if !defined(NO_BIAS)
+            IDFLOAT *arenaBiases(const unsigned int &count);
+        #endif
+    #endif
+
     class Layer
     {
     public:
@@ -832,10 +990,10 @@ private:
         //    IDFLOAT *weights;         // weights of this     layer  [1D Array] pointers.                             #(used if     #REDUCE_RAM_WEIGHTS_LVL1   defined)         
         //#endif
         #if !defined(REDUCE_RAM_WEIGHTS_COMMON)
-            IS_CONST IDFLOAT **weights; // weights of this     layer  [2D Array] pointers.                             #(used if NOT #REDUCE_RAM_WEIGHTS_COMMON defined) 
+            WeightRows weights;         // weights of this     layer  [2D Array] view into the arena or default_Weights. #(used if NOT #REDUCE_RAM_WEIGHTS_COMMON defined)
         #endif
         #if !defined(NO_BACKPROP)
-            DFLOAT *preLgamma;         // gamma   of previous layer  [1D Array] pointers.
+            DFLOAT *preLgamma;         // gamma   of previous layer  [1D Array] pointers. Into NN's gammaBlock, the other half from the next layer's
         #endif
 
         // Default Constractor                                                         .
@@ -863,6 +1021,7 @@ private:
         #endif
 
         void FeedForward(const DFLOAT *inputs); // Calculates the outputs() of layer.
+        void FeedForwardBatch(const DFLOAT *inputs, const unsigned int &n, DFLOAT *batchOutputs, const unsigned int &weightsAt); // n <= BATCH_TILE rows, weightsAt is the layer's first weight in NN.weights (REDUCE_RAM_WEIGHTS_LVL2)
         void FdF_PROGMEM(const DFLOAT *inputs);
         #if defined(USE_INTERNAL_EEPROM)
             void FdF_IN_EEPROM(const DFLOAT *inputs);
@@ -871,6 +1030,7 @@ private:
         #if !defined (NO_BACKPROP)
             void BackPropOutput(const DFLOAT *_expected_, const DFLOAT *inputs);
             void BackPropHidden(const Layer *frontLayer, const DFLOAT *inputs);
+            void AccumulateGradients(const Layer *frontLayer, const DFLOAT *_expected_, const DFLOAT *inputs, DFLOAT *weightGradients, DFLOAT *biasGradients); // frontLayer == NULL for the output layer
         #endif
 
 
@@ -993,6 +1153,15 @@ public:
         #if !defined(NO_BIAS)
             DFLOAT LearningRateOfBiases  = 0.066; // Learning Rate of Biases .
         #endif
+
+        // Optimizers of ApplyGradients(), see setOptimizer()
+        #define OPTIMIZER_SGD      0 // w -= LR * g
+        #define OPTIMIZER_MOMENTUM 1 // v = Momentum * v + g , w -= LR * v
+        #define OPTIMIZER_ADAM     2 // https://arxiv.org/abs/1412.6980 , LR is its α (try 0.01 instead of the default 0.33)
+        DFLOAT Momentum = 0.9  ;
+        DFLOAT Beta1    = 0.9  ; // Adam's decay rate of the 1st moments
+        DFLOAT Beta2    = 0.999; // Adam's decay rate of the 2nd moments
+        DFLOAT Epsilon  = 1e-7 ; // Adam's ε, 1e-8 underflows in float next to the moments of small gradients
     #endif
     
 
@@ -1036,6 +1205,9 @@ public:
     void  reset_Individual_Input_Counter();
     DFLOAT *FeedForward_Individual(const DFLOAT &input);
     DFLOAT *FeedForward(const DFLOAT *inputs); // Moves Calculated outputs as inputs to next layer.
+    #if !defined(USE_INTERNAL_EEPROM)
+        DFLOAT *FeedForwardBatch(const DFLOAT *inputs, const unsigned int &n, DFLOAT *outputs); // n input-rows into n output-rows, returns outputs | leaves the layers' outputs (and so BackProp) as they were
+    #endif
     
     //LOSS FUNCTIONS +common
     DFLOAT getMeanSqrdError           (unsigned int inputsPerEpoch); 
@@ -1045,6 +1217,11 @@ public:
 
     #if !defined (NO_BACKPROP)
         void BackProp(const DFLOAT *expected);    // BackPropopagation - (error, delta-weights, etc.).
+
+        // Mini-batch training: AccumulateGradients() after each FeedForward() of the batch, then ApplyGradients(batch_size) once
+        void setOptimizer(const byte &optimizer);           // OPTIMIZER_SGD (default), OPTIMIZER_MOMENTUM or OPTIMIZER_ADAM | (re)allocates the gradients and optimizer state, resetting both
+        void AccumulateGradients(const DFLOAT *expected);   // Same gradients (and loss) as BackProp, summed into a buffer instead of changing the weights
+        void ApplyGradients(const unsigned int &batchSize); // One optimizer step with the summed gradients divided by batchSize, then clears them
     #endif
 
     #if defined(SUPPORTS_SD_FUNCTIONALITY)
@@ -1099,15 +1276,8 @@ public:
                 unsigned int i=0;
                 while(true) // for (unsigned int i = 0; i < numberOflayers; i++)
                 {
-                    #if !defined(REDUCE_RAM_WEIGHTS_COMMON) // && !defined(USE_PROGMEM)
-                        for (unsigned int j = 0; j < layers[i]._numberOfOutputs; j++) // because of this i wont make _numberOfOutputs/inputs private :/ or maybe.. i ll see... or i will change them to const* ... what? i've just read it again lol
-                        {
-                            delete[] layers[i].weights[j];
-                        }
-                    #endif
-
                     // #if !defined(USE_PROGMEM)
-                    #if !defined(NO_BIAS)
+                    #if !defined(NO_BIAS) && defined(REDUCE_RAM_WEIGHTS_COMMON) // else the biases are in the arena
                         delete layers[i].bias;
                     #endif
                     // #endif
@@ -1129,6 +1299,10 @@ public:
 
                 #if defined(REDUCE_RAM_WEIGHTS_LVL2) // && !defined(USE_PROGMEM) // no need for progmem condition because progmem is never going to be initialized with new
                     delete weights;
+                #elif !defined(REDUCE_RAM_WEIGHTS_COMMON)
+                    delete[] arenaBlock; // every weight and bias at once
+                    arenaBlock = NULL;
+                    arena      = NULL;
                 #endif
             }else{
                 #if !defined(REDUCE_RAM_DELETE_OUTPUTS)
@@ -1143,6 +1317,21 @@ public:
             }
         #endif
 
+        #if !defined(NO_BACKPROP)
+            delete[] gammaBlock;
+            gammaBlock = NULL;
+            delete[] gradients;      // load() may change the shape, so the next AccumulateGradients() reallocates them
+            delete[] optimizerState;
+            gradients      = NULL;
+            optimizerState = NULL;
+        #endif
+
+        #if !defined(USE_INTERNAL_EEPROM)
+            delete[] batchBlock;     // same for FeedForwardBatch
+            batchBlock = NULL;
+            batchWidth = 0;
+        #endif
+
         #if defined(ACTIVATION__PER_LAYER) && defined(SUPPORTS_SD_FUNCTIONALITY) 
             if (isAlreadyLoadedOnce){
                 delete[] ActFunctionPerLayer;
@@ -1156,6 +1345,48 @@ public:
     NeuralNetwork::~NeuralNetwork() { pdestract(); } 
 
 
+    #if !defined(NO_BACKPROP)
+        void NeuralNetwork::allocateGammas()
+        {
+            unsigned int width = 0;
+            for (unsigned int i = 0; i < numberOflayers; i++){
+                if (layers[i]._numberOfInputs > width)
+                    width = layers[i]._numberOfInputs;
+            }
+            gammaBlock = new DFLOAT[2 * width];
+            for (unsigned int i = 0; i < numberOflayers; i++) // each layer reads the front layer's half and writes the other one
+                layers[i].preLgamma = &gammaBlock[(i & 1) * width];
+        }
+    #endif
+
+    #if !defined(REDUCE_RAM_WEIGHTS_COMMON)
+        void NeuralNetwork::allocateArena(const unsigned int &numberOfWeights, const unsigned int &numberOfBiases)
+        {
+            // new[] only guarantees IDFLOAT's alignment, so allocate one boundary's worth more and start at the first one inside
+            arenaBlock = new IDFLOAT[numberOfWeights + numberOfBiases + ARENA_ALIGNMENT / sizeof(IDFLOAT)];
+            arena      = (IDFLOAT *)(((uintptr_t)arenaBlock + ARENA_ALIGNMENT - 1) & ~(uintptr_t)(ARENA_ALIGNMENT - 1));
+            arenaWeightsAt = 0;
+            arenaBiasesAt  = numberOfWeights;
+        }
+
+        NeuralNetwork::WeightRows NeuralNetwork::arenaWeights(const unsigned int &NumberOfInputs, const unsigned int &NumberOfOutputs)
+        {
+            WeightRows rows = {&arena[arenaWeightsAt], NumberOfInputs};
+            arenaWeightsAt += NumberOfInputs * NumberOfOutputs;
+            return rows;
+        }
+
+        #if !defined(NO_BIAS)
+            IDFLOAT *NeuralNetwork::arenaBiases(const unsigned int &count)
+            {
+                IDFLOAT *biases = &arena[arenaBiasesAt];
+                arenaBiasesAt += count;
+                return biases;
+            }
+        #endif
+    #endif
+
+
 
     #if defined(NO_BIAS)
         NeuralNetwork::NeuralNetwork(const unsigned int *layer_, IS_CONST IDFLOAT *default_Weights, const unsigned int &NumberOflayers, byte *_ActFunctionPerLayer)
@@ -1216,6 +1447,9 @@ public:
             #endif
             
         }
+        #if !defined(NO_BACKPROP)
+            allocateGammas();
+        #endif
     }
 
     #if !defined(NO_BACKPROP)
@@ -1251,12 +1485,25 @@ public:
                 
                 weights = new DFLOAT[i_j];
                 i_j=0;
+            #elif !defined(REDUCE_RAM_WEIGHTS_COMMON)
+                unsigned int numberOfWeights = 0;
+                unsigned int numberOfBiases  = 0;
+                for (unsigned int i = 0; i < numberOflayers; i++){
+                    numberOfWeights += layer_[i] * layer_[i + 1];
+                    #if defined(MULTIPLE_BIASES_PER_LAYER)
+                        numberOfBiases += layer_[i + 1];
+                    #elif !defined(NO_BIAS)
+                        numberOfBiases++;
+                    #endif
+                }
+                allocateArena(numberOfWeights, numberOfBiases);
             #endif
 
             for (unsigned int i = 0; i < numberOflayers; i++)
             {
                 layers[i] =  Layer(layer_[i], layer_[i + 1],this);
             }
+            allocateGammas();
 
         }
 
@@ -1285,12 +1532,25 @@ public:
                 
                 weights = new DFLOAT[i_j];
                 i_j=0;
+            #elif !defined(REDUCE_RAM_WEIGHTS_COMMON)
+                unsigned int numberOfWeights = 0;
+                unsigned int numberOfBiases  = 0;
+                for (unsigned int i = 0; i < numberOflayers; i++){
+                    numberOfWeights += layer_[i] * layer_[i + 1];
+                    #if defined(MULTIPLE_BIASES_PER_LAYER)
+                        numberOfBiases += layer_[i + 1];
+                    #elif !defined(NO_BIAS)
+                        numberOfBiases++;
+                    #endif
+                }
+                allocateArena(numberOfWeights, numberOfBiases);
             #endif
 
             for (unsigned int i = 0; i < numberOflayers; i++)
             {
                 layers[i] =  Layer(layer_[i], layer_[i + 1],this);
             }
+            allocateGammas();
         }
     #endif
 
@@ -1474,6 +1734,44 @@ public:
         return layers[i - 1].outputs;
     }
 
+    #if !defined(USE_INTERNAL_EEPROM)
+        DFLOAT *NeuralNetwork::FeedForwardBatch(const DFLOAT *inputs, const unsigned int &n, DFLOAT *outputs)
+        {
+            #if defined(REDUCE_RAM_STATIC_REFERENCE_FOR_MULTIPLE_NN_OBJECTS)
+                me = this;
+            #endif
+
+            if (batchBlock == NULL && numberOflayers > 1){
+                for (unsigned int i = 0; i < numberOflayers - 1; i++){
+                    if (layers[i]._numberOfOutputs > batchWidth)
+                        batchWidth = layers[i]._numberOfOutputs;
+                }
+                batchBlock = new DFLOAT[2 * BATCH_TILE * batchWidth];
+            }
+
+            // A tile goes through every layer before the next one starts, so its outputs stay in the cache
+            const unsigned int inputSize  = layers[0]._numberOfInputs;
+            const unsigned int outputSize = layers[numberOflayers - 1]._numberOfOutputs;
+            for (unsigned int t = 0; t < n; t += BATCH_TILE)
+            {
+                const unsigned int tile = (n - t < BATCH_TILE) ? n - t : BATCH_TILE;
+                const DFLOAT *tileInputs = &inputs[t * inputSize];
+                unsigned int weightsAt = 0;
+                for (unsigned int i = 0; i < numberOflayers; i++)
+                {
+                    #if defined(ACTIVATION__PER_LAYER)
+                        AtlayerIndex = i;
+                    #endif
+                    DFLOAT *tileOutputs = (i == numberOflayers - 1) ? &outputs[t * outputSize] : &batchBlock[(i & 1) * BATCH_TILE * batchWidth];
+                    layers[i].FeedForwardBatch(tileInputs, tile, tileOutputs, weightsAt);
+                    weightsAt += layers[i]._numberOfInputs * layers[i]._numberOfOutputs;
+                    tileInputs = tileOutputs;
+                }
+            }
+            return outputs;
+        }
+    #endif
+
 
 
     #if !defined (NO_BACKPROP)
@@ -1494,13 +1792,136 @@ public:
             for (int i = numberOflayers - 2; i > 0; i--)
             {
                 layers[i].BackPropHidden(&layers[i + 1], layers[i - 1].outputs);
-                delete[] layers[i + 1].preLgamma;
             }
 
             layers[0].BackPropHidden(&layers[1], _inputs);
+        }
+
+        void NeuralNetwork::setOptimizer(const byte &optimizer)
+        {
+            Optimizer = optimizer;
+            numberOfGradientWeights = 0;
+            numberOfParameters      = 0;
+            for (unsigned int i = 0; i < numberOflayers; i++){
+                numberOfGradientWeights += layers[i]._numberOfInputs * layers[i]._numberOfOutputs;
+                #if defined(MULTIPLE_BIASES_PER_LAYER)
+                    numberOfParameters += layers[i]._numberOfOutputs;
+                #elif !defined(NO_BIAS)
+                    numberOfParameters++;
+                #endif
+            }
+            numberOfParameters += numberOfGradientWeights;
+
+            unsigned int stateSize = 0;
+            if (optimizer == OPTIMIZER_MOMENTUM)
+                stateSize = numberOfParameters;
+            else if (optimizer == OPTIMIZER_ADAM)
+                stateSize = 2 * numberOfParameters;
+
+            delete[] gradients;
+            delete[] optimizerState;
+            gradients      = new DFLOAT[numberOfParameters];
+            optimizerState = (stateSize == 0) ? NULL : new DFLOAT[stateSize];
+            for (unsigned int k = 0; k < numberOfParameters; k++)
+                gradients[k] = 0;
+            for (unsigned int k = 0; k < stateSize; k++)
+                optimizerState[k] = 0;
+            optimizerStep = 0;
+        }
+
+        void NeuralNetwork::AccumulateGradients(const DFLOAT *expected)
+        {
+            #if defined(REDUCE_RAM_STATIC_REFERENCE_FOR_MULTIPLE_NN_OBJECTS)
+                me = this;
+            #endif
+
+            if (gradients == NULL)
+                setOptimizer(Optimizer);
+
+            // Layers go backwards, so do their slices of gradients
+            unsigned int weightsAt = numberOfGradientWeights;
+            unsigned int biasesAt  = numberOfParameters;
+            for (int i = numberOflayers - 1; i >= 0; i--)
+            {
+                weightsAt -= layers[i]._numberOfInputs * layers[i]._numberOfOutputs;
+                #if defined(MULTIPLE_BIASES_PER_LAYER)
+                    biasesAt -= layers[i]._numberOfOutputs;
+                #elif !defined(NO_BIAS)
+                    biasesAt--;
+                #endif
+
+                #if defined(REDUCE_RAM_WEIGHTS_LVL2)
+                    DFLOAT *weightGradients = gradients; // indexed by i_j, like NN.weights
+                #else
+                    DFLOAT *weightGradients = &gradients[weightsAt];
+                #endif
+                const Layer  *frontLayer = (i == (int)numberOflayers - 1) ? NULL : &layers[i + 1];
+                const DFLOAT *inputs     = (i == 0) ? _inputs : layers[i - 1].outputs;
+                layers[i].AccumulateGradients(frontLayer, expected, inputs, weightGradients, &gradients[biasesAt]);
+            }
+        }
+
+        void NeuralNetwork::ApplyGradients(const unsigned int &batchSize)
+        {
+            if (gradients == NULL || batchSize == 0) // nothing accumulated
+                return;
+
+            DFLOAT scale      = (DFLOAT)1.0 / batchSize;
+            DFLOAT correction = 1;
+            if (Optimizer == OPTIMIZER_ADAM){ // the bias correction of both moments, folded into the learning rates
+                optimizerStep++;
+                correction = sqrt(1 - pow(Beta2, optimizerStep)) / (1 - pow(Beta1, optimizerStep));
+            }
+
+            unsigned int k = 0;
+            for (unsigned int i = 0; i < numberOflayers; i++)
+            {
+                #if defined(REDUCE_RAM_WEIGHTS_LVL2)
+                    stepParameters(&weights[k], layers[i]._numberOfInputs * layers[i]._numberOfOutputs, k, LearningRateOfWeights * correction, scale);
+                #else
+                    stepParameters(layers[i].weights.flat, layers[i]._numberOfInputs * layers[i]._numberOfOutputs, k, LearningRateOfWeights * correction, scale);
+                #endif
+            }
+            #if !defined(NO_BIAS)
+                for (unsigned int i = 0; i < numberOflayers; i++)
+                {
+                    #if defined(MULTIPLE_BIASES_PER_LAYER)
+                        stepParameters(layers[i].bias, layers[i]._numberOfOutputs, k, LearningRateOfBiases * correction, scale);
+                    #else
+                        stepParameters(layers[i].bias, 1, k, LearningRateOfBiases * correction, scale);
+                    #endif
+                }
+            #endif
+        }
 
-            delete[] layers[1].preLgamma;
-            delete[] layers[0].preLgamma;
+        // parameters[0 .. count) take gradients[k ..] and the optimizer state at k, and k moves past them
+        void NeuralNetwork::stepParameters(DFLOAT *parameters, const unsigned int &count, unsigned int &k, const DFLOAT &rate, const DFLOAT &scale)
+        {
+            DFLOAT *g = &gradients[k];
+            if (Optimizer == OPTIMIZER_MOMENTUM){
+                DFLOAT *velocity = &optimizerState[k];
+                for (unsigned int n = 0; n < count; n++){
+                    velocity[n] = Momentum * velocity[n] + g[n] * scale;
+                    parameters[n] -= velocity[n] * rate;
+                    g[n] = 0;
+                }
+            }else if (Optimizer == OPTIMIZER_ADAM){
+                DFLOAT *m = &optimizerState[k];
+                DFLOAT *v = &optimizerState[numberOfParameters + k];
+                for (unsigned int n = 0; n < count; n++){
+                    DFLOAT gradient = g[n] * scale;
+                    m[n] = Beta1 * m[n] + (1 - Beta1) * gradient;
+                    v[n] = Beta2 * v[n] + (1 - Beta2) * gradient * gradient;
+                    parameters[n] -= rate * m[n] / ((DFLOAT)sqrt(v[n]) + Epsilon);
+                    g[n] = 0;
+                }
+            }else{
+                for (unsigned int n = 0; n < count; n++){
+                    parameters[n] -= (g[n] * scale) * rate;
+                    g[n] = 0;
+                }
+            }
+            k += count;
         }
     #endif
 
@@ -1587,10 +2008,33 @@ public:
                     i_j = 0;
                     weights = new IDFLOAT[myFile.readStringUntil('\n').toInt()];
                 #else
-                    myFile.readStringUntil('\n').toInt(); // Skipping line
+                    unsigned int numberOfWeights = myFile.readStringUntil('\n').toInt();
                 #endif
 
                 numberOflayers = myFile.readStringUntil('\n').toInt() - 1;
+                #if !defined(REDUCE_RAM_WEIGHTS_LVL2) // #1.1
+                    #if defined(MULTIPLE_BIASES_PER_LAYER)
+                        // The file doesn't say how many biases there are, so add up the layers' outputs first and come back
+                        unsigned int numberOfBiases = 0;
+                        unsigned long layersAt = myFile.position();
+                        for (unsigned int i = 0; i < numberOflayers; i++){
+                            #if defined(ACTIVATION__PER_LAYER)
+                                myFile.readStringUntil('\n');
+                            #endif
+                            unsigned long layerInputs  = myFile.readStringUntil('\n').toInt();
+                            unsigned long layerOutputs = myFile.readStringUntil('\n').toInt();
+                            numberOfBiases += layerOutputs;
+                            for (unsigned long k = 0; k < layerOutputs * (layerInputs + 1); k++) // a bias and its weights per neuron
+                                myFile.readStringUntil('\n');
+                        }
+                        myFile.seek(layersAt);
+                        allocateArena(numberOfWeights, numberOfBiases);
+                    #elif defined(NO_BIAS)
+                        allocateArena(numberOfWeights, 0);
+                    #else
+                        allocateArena(numberOfWeights, numberOflayers);
+                    #endif
+                #endif
                 layers = new Layer[numberOflayers]; 
                 #if defined(REDUCE_RAM_DELETE_OUTPUTS)
                     layers[numberOflayers -1].outputs = NULL;
@@ -1626,16 +2070,21 @@ public:
                     tmp_layerOutputs = myFile.readStringUntil('\n').toInt();
                     #if !defined(NO_BIAS)
                         #if !defined(MULTIPLE_BIASES_PER_LAYER)
+                            #if defined(REDUCE_RAM_WEIGHTS_LVL2) // #1.1
+                                tmp_bias  = new IDFLOAT;
+                            #else
+                                tmp_bias  = arenaBiases(1);
+                            #endif
                             #if !defined(USE_INT_QUANTIZATION)
                                 tmp       = ATOL((char*)myFile.readStringUntil('\n').c_str());
-                                tmp_bias  = new DFLOAT;
                                 *tmp_bias = *((DFLOAT*)(&tmp));
                             #else
-                                tmp_bias  = new IDFLOAT;
                                 *tmp_bias = (IDFLOAT)strtol((char*)myFile.readStringUntil('\n').c_str(), NULL, 10);
                             #endif
-                        #else
+                        #elif defined(REDUCE_RAM_WEIGHTS_LVL2) // #1.1
                             tmp_bias  = new IDFLOAT[tmp_layerOutputs];
+                        #else
+                            tmp_bias  = arenaBiases(tmp_layerOutputs);
                         #endif
                     #endif
 
@@ -1645,7 +2094,7 @@ public:
                         #else
                             layers[i] = Layer(tmp_layerInputs, tmp_layerOutputs, tmp_bias, this);
                         #endif
-                        layers[i].weights = new IDFLOAT *[tmp_layerOutputs];
+                        layers[i].weights = arenaWeights(tmp_layerInputs, tmp_layerOutputs);
                     #endif
 
                     #if !defined(REDUCE_RAM_WEIGHTS_LVL2) // #1.1
@@ -1658,7 +2107,6 @@ public:
                                     layers[i].bias[j] = (IDFLOAT)strtol((char*)myFile.readStringUntil('\n').c_str(), NULL, 10);
                                 #endif
                             #endif
-                            layers[i].weights[j] = new IDFLOAT[tmp_layerInputs];
                             for(unsigned int k=0; k<tmp_layerInputs; k++){
                                 #if !defined(USE_INT_QUANTIZATION)
                                     tmp = ATOL((char*)myFile.readStringUntil('\n').c_str());
@@ -1707,6 +2155,9 @@ public:
                         #endif
                     #endif
                 }
+                #if !defined(NO_BACKPROP)
+                    allocateGammas();
+                #endif
                 myFile.close();
                 return true;
             }
@@ -1930,10 +2381,8 @@ public:
             #if !defined(NO_BIAS) // TODO: REDUCE_RAM_BIASES "common reference"
                 bias = default_Bias; //                          ##1    Bias as Default Bias. Biases if defined MULTIPLE_BIASES_PER_LAYER | A reference
             #endif
-            weights = new IS_CONST IDFLOAT *[_numberOfOutputs]; //      ##1    New Array of Pointers to (IDFLOAT) weights.
-
-            for (unsigned int i = 0; i < _numberOfOutputs; i++)              // [matrix] (_numberOfOutputs * _numberOfInputs)
-                weights[i] = &default_Weights[i * _numberOfInputs]; // Passing Default weights to ##1 weights by reference.  
+            weights.flat   = default_Weights; //                 ##1    Default weights by reference, [matrix] (_numberOfOutputs * _numberOfInputs)
+            weights.stride = _numberOfInputs;
         }
     #endif
 
@@ -1976,9 +2425,14 @@ public:
                 outputs = new DFLOAT[_numberOfOutputs];                     // ##1    New Array of Outputs.
             #endif 
             #if !defined(REDUCE_RAM_WEIGHTS_COMMON)      
-                weights = new IDFLOAT *[_numberOfOutputs];                  // ##1    New Array of Pointers to (IDFLOAT) weights.
-            #endif
-            #if defined(MULTIPLE_BIASES_PER_LAYER)
+                weights = me->arenaWeights(_numberOfInputs, _numberOfOutputs); // ##1 Next weights of the arena.
+                #if defined(MULTIPLE_BIASES_PER_LAYER)
+                    bias = me->arenaBiases(_numberOfOutputs);               // ##1    Next         Biases
+                #elif !defined(NO_BIAS)
+                    bias = me->arenaBiases(1);                              // ##1    Next         Bias   .
+                    *bias = 1.0; // SuS cause IDFLOAT
+                #endif
+            #elif defined(MULTIPLE_BIASES_PER_LAYER)
                 bias = new IDFLOAT[_numberOfOutputs];                       // ##1    New          Biases
             #elif !defined(NO_BIAS)
                 bias = new IDFLOAT;                                         // ##1    New          Bias   .
@@ -1987,10 +2441,6 @@ public:
 
             for (unsigned int i = 0; i < _numberOfOutputs; i++)
             {
-                #if !defined(REDUCE_RAM_WEIGHTS_COMMON)
-                    weights[i] = new IDFLOAT[_numberOfInputs];
-                #endif
-
                 #if defined(MULTIPLE_BIASES_PER_LAYER) // TODO: REDUCE_RAM_BIASES
                     bias[i] = (IDFLOAT)random(-90000, 90000) / 100000;
                 #endif
@@ -2333,11 +2783,11 @@ public:
         //feed forwards
         for (unsigned int i = 0; i < _numberOfOutputs; i++)
         {
-            #if defined(ESP_SUPPORTS_SIMD)
+            #if defined(SUPPORTS_SIMD)
                 #if !defined(REDUCE_RAM_WEIGHTS_LVL2)
-                    dsps_dotprod_f32(inputs, weights[i], &outputs[i], _numberOfInputs); // https://github.com/GiorgosXou/NeuralNetworks/discussions/16#discussioncomment-7479256
+                    SIMD_DOTPROD(inputs, weights[i], &outputs[i], _numberOfInputs); // https://github.com/GiorgosXou/NeuralNetworks/discussions/16#discussioncomment-7479256
                 #else
-                    dsps_dotprod_f32(inputs, &me->weights[me->i_j], &outputs[i], _numberOfInputs); 
+                    SIMD_DOTPROD(inputs, &me->weights[me->i_j], &outputs[i], _numberOfInputs); 
                     me->i_j+= _numberOfInputs;
                 #endif
 
@@ -2386,6 +2836,96 @@ public:
         // return outputs;
     } 
 
+    #if !defined(USE_INTERNAL_EEPROM)
+        // The same sums in the same order as FeedForward (with the scalar SIMD_BACKEND), only each weight is read once for up to BATCH_TILE samples
+        void NeuralNetwork::Layer::FeedForwardBatch(const DFLOAT *inputs, const unsigned int &n, DFLOAT *batchOutputs, const unsigned int &weightsAt)
+        {
+            // A shorter tile repeats its last sample, so the sample loops always run BATCH_TILE times and the sums can stay in registers
+            const DFLOAT *in[BATCH_TILE];
+            for (unsigned int s = 0; s < BATCH_TILE; s++)
+                in[s] = &inputs[((s < n) ? s : n - 1) * _numberOfInputs];
+
+            DFLOAT sum[BATCH_TILE];
+            for (unsigned int i = 0; i < _numberOfOutputs; i++)
+            {
+                #if defined(REDUCE_RAM_WEIGHTS_LVL2)
+                    const IDFLOAT *row = &me->weights[weightsAt + i * _numberOfInputs];
+                #else
+                    const IDFLOAT *row = weights[i];
+                    (void)weightsAt; // rows are per layer
+                #endif
+
+                #if defined(NO_BIAS)
+                    DFLOAT bias_i = 0;
+                #elif defined(USE_PROGMEM) and defined(MULTIPLE_BIASES_PER_LAYER)
+                    DFLOAT bias_i = PGM_READ_IDFLOAT(&bias[i]) MULTIPLY_BY_INT_IF_QUANTIZATION;
+                #elif defined(USE_PROGMEM)
+                    DFLOAT bias_i = PGM_READ_IDFLOAT(bias) MULTIPLY_BY_INT_IF_QUANTIZATION;
+                #elif defined(MULTIPLE_BIASES_PER_LAYER)
+                    DFLOAT bias_i = bias[i] MULTIPLY_BY_INT_IF_QUANTIZATION;
+                #else
+                    DFLOAT bias_i = *bias MULTIPLY_BY_INT_IF_QUANTIZATION;
+                #endif
+                for (unsigned int s = 0; s < BATCH_TILE; s++)
+                    sum[s] = bias_i;
+
+                if (n == 1){ // nothing to share the weights with, so don't pay for the padding
+                    for (unsigned int j = 0; j < _numberOfInputs; j++)
+                    {
+                        #if defined(USE_PROGMEM)
+                            sum[0] += in[0][j] * PGM_READ_IDFLOAT(&row[j]) MULTIPLY_BY_INT_IF_QUANTIZATION;
+                        #else
+                            sum[0] += in[0][j] * row[j] MULTIPLY_BY_INT_IF_QUANTIZATION;
+                        #endif
+                    }
+                }else{
+                    for (unsigned int j = 0; j < _numberOfInputs; j++)
+                    {
+                        #if defined(USE_PROGMEM)
+                            const IDFLOAT w = PGM_READ_IDFLOAT(&row[j]);
+                        #else
+                            const IDFLOAT w = row[j];
+                        #endif
+                        for (unsigned int s = 0; s < BATCH_TILE; s++)
+                            sum[s] += in[s][j] * w MULTIPLY_BY_INT_IF_QUANTIZATION;
+                    }
+                }
+
+                for (unsigned int s = 0; s < n; s++)
+                    batchOutputs[s * _numberOfOutputs + i] = sum[s];
+            }
+
+            for (unsigned int s = 0; s < n; s++)
+            {
+                DFLOAT *o = &batchOutputs[s * _numberOfOutputs];
+                #if defined(ALL_ACTIVATION_FUNCTIONS) or defined(Softmax)
+                    me->sumOfSoftmax = 0;
+                #endif
+                for (unsigned int i = 0; i < _numberOfOutputs; i++)
+                {
+                    #if defined(ACTIVATION__PER_LAYER)
+                        o[i] = ((this)->*(activation_Function_ptrs)[me->ActFunctionPerLayer[me->AtlayerIndex]])(o[i]);
+                    #elif defined(Softmax)
+                        o[i] = exp(o[i]);
+                        me->sumOfSoftmax += o[i];
+                    #else
+                        o[i] = ACTIVATE_WITH(ACTIVATION_FUNCTION, o[i]);
+                    #endif
+                }
+
+                #if (defined(ACTIVATION__PER_LAYER) and defined(Softmax)) or defined(ALL_ACTIVATION_FUNCTIONS)
+                    if (me->ActFunctionPerLayer[me->AtlayerIndex] == 6){
+                        for (unsigned int i = 0; i < _numberOfOutputs; i++)
+                            o[i] /= me->sumOfSoftmax;
+                    }
+                #elif defined(Softmax)
+                    for (unsigned int i = 0; i < _numberOfOutputs; i++)
+                        o[i] /= me->sumOfSoftmax;
+                #endif
+            }
+        }
+    #endif
+
     
     DFLOAT NeuralNetwork::Layer::erf(DFLOAT x)
     {
@@ -2471,7 +3011,8 @@ public:
         void NeuralNetwork::Layer::BackPropOutput(const DFLOAT *_expected_, const DFLOAT *inputs)
         {
 
-            preLgamma = new DFLOAT[_numberOfInputs]{}; // create gamma of previous layer and initialize{} values to 0 .. meh
+            for (unsigned int j = 0; j < _numberOfInputs; j++) // gamma of previous layer starts at 0, in NN's preallocated buffer
+                preLgamma[j] = 0;
             
 
             #if !defined(NO_BIAS)
@@ -2566,7 +3107,8 @@ public:
             #if defined(ACTIVATION__PER_LAYER)
                 me->AtlayerIndex -= 1; 
             #endif
-            preLgamma = new DFLOAT[_numberOfInputs]{};
+            for (unsigned int j = 0; j < _numberOfInputs; j++)
+                preLgamma[j] = 0;
 
             #if !defined(NO_BIAS)
                 DFLOAT bias_Delta = 1.0;
@@ -2625,6 +3167,77 @@ public:
                 *bias -= bias_Delta * me->LearningRateOfBiases;
             #endif
         }
+
+        // BackPropOutput (frontLayer == NULL) or BackPropHidden, in the same order, except that each weight's and bias' change goes into the gradients
+        void NeuralNetwork::Layer::AccumulateGradients(const Layer *frontLayer, const DFLOAT *_expected_, const DFLOAT *inputs, DFLOAT *weightGradients, DFLOAT *biasGradients)
+        {
+            #if defined(ACTIVATION__PER_LAYER)
+                if (frontLayer != NULL)
+                    me->AtlayerIndex -= 1; 
+            #endif
+            for (unsigned int j = 0; j < _numberOfInputs; j++)
+                preLgamma[j] = 0;
+
+            #if !defined(NO_BIAS)
+                DFLOAT bias_Delta = 1.0;
+            #else
+                (void)biasGradients; // no biases to accumulate
+            #endif
+            DFLOAT gamma;
+
+            #if defined(REDUCE_RAM_WEIGHTS_LVL2)
+                for (int i = _numberOfOutputs -1; i >= 0; i--)
+            #else
+                for (unsigned int i = 0; i < _numberOfOutputs; i++)
+            #endif
+                {
+                    if (frontLayer == NULL){
+                        gamma = (outputs[i] - _expected_[i]);
+                        #if defined(CATEGORICAL_CROSS_ENTROPY)
+                            me->sumOfCategoricalCrossEntropy -= _expected_[i] * (DFLOAT)log(outputs[i]);
+                        #endif
+                        #if defined(BINARY_CROSS_ENTROPY)
+                            me->sumOfBinaryCrossEntropy -=  _expected_[i] * (DFLOAT)log(outputs[i]) + (1.0 - _expected_[i]) * (DFLOAT)log(1.0 - outputs[i]);
+                        #endif
+                        #if defined(MEAN_SQUARED_ERROR) or defined(DEFAULT_LOSS)
+                            me->sumSquaredError += gamma * gamma; 
+                        #endif
+                    }else{
+                        gamma = frontLayer->preLgamma[i];
+                    }
+
+                    #if defined(ACTIVATION__PER_LAYER)
+                        gamma = gamma * ((this)->*(derivative_Function_ptrs)[me->ActFunctionPerLayer[me->AtlayerIndex]])(outputs[i]);
+                    #else
+                        gamma = gamma * DERIVATIVE_OF(ACTIVATION_FUNCTION, outputs[i]);
+                    #endif
+                    #if defined(MULTIPLE_BIASES_PER_LAYER)
+                        biasGradients[i] += gamma;
+                    #elif !defined(NO_BIAS)
+                        bias_Delta *= gamma;
+                    #endif
+
+                    #if defined(REDUCE_RAM_WEIGHTS_LVL2)
+                        for (int j = _numberOfInputs -1; j >= 0; j--)
+                        {
+                            me->i_j--;
+                            preLgamma[j] += gamma * me->weights[me->i_j];
+                            weightGradients[me->i_j] += gamma * inputs[j];
+                        }
+                    #else
+                        DFLOAT *rowGradients = &weightGradients[i * _numberOfInputs];
+                        for (unsigned int j = 0; j < _numberOfInputs; j++)
+                        {
+                            preLgamma[j] += gamma * weights[i][j];
+                            rowGradients[j] += gamma * inputs[j];
+                        }
+                    #endif
+                }
+
+            #if !defined(NO_BIAS) and !defined(MULTIPLE_BIASES_PER_LAYER)
+                *biasGradients += bias_Delta;
+            #endif
+        }
     #endif
 
 
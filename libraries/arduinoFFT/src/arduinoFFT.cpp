@@ -57,6 +57,24 @@ void ArduinoFFT<T>::complexToMagnitude(T *vReal, T *vImag,
   }
 }
 
+template <typename T> void ArduinoFFT<T>::complexToMagnitudeReal(void) const {
+  complexToMagnitudeReal(this->_vReal, this->_samples);
+}
+
+template <typename T>
+void ArduinoFFT<T>::complexToMagnitudeReal(T *vData,
+                                           uint_fast16_t samples) const {
+  // Bin k is read from [2k, 2k + 1] and written to k, which never overtakes
+  // the reads. Only the Nyquist term in vData[1] has to be saved first.
+  uint_fast16_t half = samples >> 1;
+  T nyquist = vData[1];
+  vData[0] = sqrt_internal(sq(vData[0]));
+  for (uint_fast16_t i = 1; i < half; i++) {
+    vData[i] = sqrt_internal(sq(vData[2 * i]) + sq(vData[2 * i + 1]));
+  }
+  vData[half] = sqrt_internal(sq(nyquist));
+}
+
 template <typename T> void ArduinoFFT<T>::compute(FFTDirection dir) const {
   compute(this->_vReal, this->_vImag, this->_samples, exponent(this->_samples),
           dir);
@@ -144,6 +162,47 @@ void ArduinoFFT<T>::compute(T *vReal, T *vImag, uint_fast16_t samples,
   }
 }
 
+template <typename T> void ArduinoFFT<T>::computeReal(void) const {
+  computeReal(this->_vReal, this->_samples);
+}
+
+// Computes the forward FFT of real data with a half-size complex FFT
+template <typename T>
+void ArduinoFFT<T>::computeReal(T *vData, uint_fast16_t samples) const {
+  uint_fast16_t half = samples >> 1;
+  // Even samples are the real parts, odd samples the imaginary parts
+  computeInterleaved(vData, half, exponent(half));
+
+  // Split: X[k] = E[k] + W^k O[k], X[N/2 - k] = conj(E[k] - W^k O[k]) with
+  // E[k] = (Z[k] + conj(Z[N/2 - k])) / 2, O[k] = -j (Z[k] - conj(Z[N/2 - k])) / 2
+  T z0 = vData[0];
+  vData[0] = z0 + vData[1];
+  vData[1] = z0 - vData[1];
+
+  T theta = twoPi / samples;
+  T wStepR = cos(theta);
+  T wStepI = -sin(theta);
+  T wr = wStepR;
+  T wi = wStepI;
+  for (uint_fast16_t k = 1; k <= (half >> 1); k++) {
+    uint_fast16_t a = 2 * k;
+    uint_fast16_t b = 2 * (half - k);
+    T er = 0.5 * (vData[a] + vData[b]);
+    T ei = 0.5 * (vData[a + 1] - vData[b + 1]);
+    T or_ = 0.5 * (vData[a + 1] + vData[b + 1]);
+    T oi = -0.5 * (vData[a] - vData[b]);
+    T tr = wr * or_ - wi * oi;
+    T ti = wr * oi + wi * or_;
+    vData[a] = er + tr;
+    vData[a + 1] = ei + ti;
+    vData[b] = er - tr;
+    vData[b + 1] = -(ei - ti);
+    T wTemp = wr;
+    wr = wr * wStepR - wi * wStepI;
+    wi = wTemp * wStepI + wi * wStepR;
+  }
+}
+
 template <typename T> void ArduinoFFT<T>::dcRemoval(void) const {
   dcRemoval(this->_vReal, this->_samples);
 }
@@ -410,6 +469,61 @@ void ArduinoFFT<T>::windowing(T *vData, uint_fast16_t samples,
 
 // Private functions
 
+// Forward in-place complex FFT on interleaved [re, im] pairs
+template <typename T>
+void ArduinoFFT<T>::computeInterleaved(T *vData, uint_fast16_t samples,
+                                       uint_fast8_t power) const {
+  // Reverse bits
+  uint_fast16_t j = 0;
+  for (uint_fast16_t i = 0; i < (samples - 1); i++) {
+    if (i < j) {
+      swap(&vData[2 * i], &vData[2 * j]);
+      swap(&vData[2 * i + 1], &vData[2 * j + 1]);
+    }
+    uint_fast16_t k = (samples >> 1);
+
+    while (k <= j) {
+      j -= k;
+      k >>= 1;
+    }
+    j += k;
+  }
+  // Compute the FFT
+  T c1 = -1.0;
+  T c2 = 0.0;
+  uint_fast16_t l2 = 1;
+  for (uint_fast8_t l = 0; (l < power); l++) {
+    uint_fast16_t l1 = l2;
+    l2 <<= 1;
+    T u1 = 1.0;
+    T u2 = 0.0;
+    for (j = 0; j < l1; j++) {
+      for (uint_fast16_t i = j; i < samples; i += l2) {
+        uint_fast16_t i1 = i + l1;
+        T t1 = u1 * vData[2 * i1] - u2 * vData[2 * i1 + 1];
+        T t2 = u1 * vData[2 * i1 + 1] + u2 * vData[2 * i1];
+        vData[2 * i1] = vData[2 * i] - t1;
+        vData[2 * i1 + 1] = vData[2 * i + 1] - t2;
+        vData[2 * i] += t1;
+        vData[2 * i + 1] += t2;
+      }
+      T z = ((u1 * c1) - (u2 * c2));
+      u2 = ((u1 * c2) + (u2 * c1));
+      u1 = z;
+    }
+
+#if defined(__AVR__) && defined(USE_AVR_PROGMEM)
+    c2 = pgm_read_float_near(&(_c2[l]));
+    c1 = pgm_read_float_near(&(_c1[l]));
+#else
+    T cTemp = 0.5 * c1;
+    c2 = sqrt_internal(0.5 - cTemp);
+    c1 = sqrt_internal(0.5 + cTemp);
+#endif
+    c2 = -c2;
+  }
+}
+
 template <typename T>
 uint_fast8_t ArduinoFFT<T>::exponent(uint_fast16_t value) const {
   // Calculates the base 2 logarithm of a value
@@ -65,12 +65,20 @@ public:
 
   void complexToMagnitude(void) const;
   void complexToMagnitude(T *vReal, T *vImag, uint_fast16_t samples) const;
+  // Magnitudes of a computeReal() result: samples/2 + 1 bins, in place
+  void complexToMagnitudeReal(void) const;
+  void complexToMagnitudeReal(T *vData, uint_fast16_t samples) const;
 
   void compute(FFTDirection dir) const;
   void compute(T *vReal, T *vImag, uint_fast16_t samples,
                FFTDirection dir) const;
   void compute(T *vReal, T *vImag, uint_fast16_t samples, uint_fast8_t power,
                FFTDirection dir) const;
+  // Forward FFT of purely real data, no vImag needed. Runs a samples/2 point
+  // complex FFT and splits it; vData ends up packed as
+  // [Re X0, Re X(N/2), Re X1, Im X1, ..., Re X(N/2-1), Im X(N/2-1)]
+  void computeReal(void) const;
+  void computeReal(T *vData, uint_fast16_t samples) const;
 
   void dcRemoval(void) const;
   void dcRemoval(T *vData, uint_fast16_t samples) const;
@@ -114,6 +122,8 @@ private:
   T *_vReal;
   FFTWindow _windowFunction;
   /* Functions */
+  void computeInterleaved(T *vData, uint_fast16_t samples,
+                          uint_fast8_t power) const;
   uint_fast8_t exponent(uint_fast16_t value) const;
   void findMaxY(T *vData, uint_fast16_t length, T *maxY,
                 uint_fast16_t *index) const;